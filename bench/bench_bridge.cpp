@@ -0,0 +1,204 @@
+// Microbenchmarks of the co-simulation bridge without an HDL simulator or ngspice
+//
+// Runs the TimeBarrier handoff and the AnalogDigitalInterface conversions
+// against the in-memory VPI host (mock_vpi) and ngspice stub (mock_ngspice).
+//
+// Usage: spicebind_bench [filter]   (only benchmarks whose name contains filter)
+
+#include "mock_ngspice.h"
+#include "mock_vpi.h"
+#include "AnalogDigitalInterface.h"
+#include "Config.h"
+#include "NgSpiceCallbacks.h"
+#include "NgSpiceLibrary.h"
+#include "SpicePartition.h"
+#include "TimeBarrier.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using spice_bench::MockNgSpice;
+using spice_bench::MockVpi;
+using spice_vpi::AnalogDigitalInterface;
+using spice_vpi::Config;
+using spice_vpi::NgSpiceLibrary;
+
+namespace {
+
+constexpr int kRuns = 5;  // best of
+const std::vector<int> kPortCounts = {1, 8, 64, 512};
+
+std::string g_filter;
+
+/**
+ * @brief Time a benchmark and print the best time per operation of kRuns runs
+ * @param name Benchmark name
+ * @param ops Operations performed by one call of body
+ * @param body Runs ops operations
+ */
+void run(const std::string &name, unsigned long long ops, const std::function<void()> &body) {
+    if (!g_filter.empty() && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    double best_ns = 0.0;
+    for (int r = 0; r < kRuns; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(ops);
+        best_ns = (r == 0) ? ns : std::min(best_ns, ns);
+    }
+    std::printf("%-44s %12.1f ns/op  (%llu ops)\n", name.c_str(), best_ns, ops);
+    std::fflush(stdout);
+}
+
+auto bench_settings() -> Config::Settings {
+    Config::Settings settings;
+    settings.spice_netlist_path = "bench.cir";
+    settings.spice_netlist_paths = {settings.spice_netlist_path};
+    settings.hdl_instance_names = {"tb.dut"};
+    settings.vcc_voltage = 1.8;
+    return settings;
+}
+
+// Module with n inputs a<i> and n outputs y<i>, bound to an interface
+struct Dut {
+    std::vector<vpiHandle> inputs;   // nets
+    std::vector<vpiHandle> outputs;  // nets
+};
+
+auto make_dut(AnalogDigitalInterface &interface, int n) -> Dut {
+    MockVpi::reset();
+    MockNgSpice::clear_vectors();
+    Dut dut;
+    vpiHandle module = MockVpi::add_module("tb.dut");
+    for (int i = 0; i < n; ++i) {
+        vpiHandle in = MockVpi::add_port(module, "a" + std::to_string(i), vpiInput);
+        vpiHandle out = MockVpi::add_port(module, "y" + std::to_string(i), vpiOutput);
+        interface.add_port(in);
+        interface.add_port(out);
+        dut.inputs.push_back(MockVpi::net(in));
+        dut.outputs.push_back(MockVpi::net(out));
+        MockNgSpice::set_vector("v(y" + std::to_string(i) + ")", 0.0);
+    }
+    return dut;
+}
+
+// HDL and SPICE engines handing the barrier back and forth, one time step per handoff
+void bench_barrier() {
+    for (int engines : {1, 2, 4}) {
+        const unsigned long long steps = 20000;
+        run("barrier/handoff engines=" + std::to_string(engines), steps, [&] {
+            spice_vpi::TimeBarrier<unsigned long long> barrier(engines);
+            std::vector<std::thread> spice;
+            for (int id = 1; id <= engines; ++id) {
+                spice.emplace_back([&barrier, id] {
+                    for (unsigned long long t = 1; t <= steps; ++t) {
+                        barrier.update(id, t);
+                    }
+                    barrier.update_no_wait(id, steps + 1);
+                });
+            }
+            for (unsigned long long t = 1; t <= steps; ++t) {
+                barrier.update(0, t);
+            }
+            barrier.update_no_wait(0, steps + 1);
+            for (auto &thread : spice) {
+                thread.join();
+            }
+        });
+    }
+}
+
+// ng_srcdata for every input source of a step, with the barrier released so it never blocks
+void bench_srcdata() {
+    std::unique_ptr<NgSpiceLibrary> ngspice = NgSpiceLibrary::linked();
+    for (int n : kPortCounts) {
+        spice_vpi::TimeBarrier<unsigned long long> barrier(1);
+        barrier.set_spice_released(true);
+        spice_vpi::EngineLink link;
+        spice_vpi::SpicePartition partition(1, bench_settings(), barrier, *ngspice, link);
+        make_dut(partition.interface(), n);
+
+        std::vector<std::string> sources;
+        for (int i = 0; i < n; ++i) {
+            sources.push_back("va" + std::to_string(i));
+        }
+        const int steps = std::max(1, 200000 / n);
+        run("srcdata/per_source ports=" + std::to_string(n), static_cast<unsigned long long>(steps) * n, [&] {
+            double value = 0.0;
+            for (int step = 0; step < steps; ++step) {
+                double time = step * 1e-9;
+                for (auto &source : sources) {
+                    spice_vpi::ng_srcdata(&value, time, source.data(), 1, &partition);
+                }
+            }
+        });
+    }
+}
+
+// HDL input changes converted to analog source values
+void bench_inputs() {
+    std::unique_ptr<NgSpiceLibrary> ngspice = NgSpiceLibrary::linked();
+    for (int n : kPortCounts) {
+        AnalogDigitalInterface interface(bench_settings(), *ngspice);
+        Dut dut = make_dut(interface, n);
+        const int rounds = std::max(1, 200000 / n);
+        run("inputs/digital_input_update ports=" + std::to_string(n), static_cast<unsigned long long>(rounds) * n, [&] {
+            for (int round = 0; round < rounds; ++round) {
+                int level = (round & 1) ? vpi1 : vpi0;
+                for (vpiHandle net : dut.inputs) {
+                    MockVpi::set_scalar(net, level);
+                    interface.digital_input_update(net);
+                }
+            }
+        });
+    }
+}
+
+// Analog outputs read back from ngspice and written to the HDL, every output toggling each step
+void bench_outputs() {
+    std::unique_ptr<NgSpiceLibrary> ngspice = NgSpiceLibrary::linked();
+    for (int n : kPortCounts) {
+        AnalogDigitalInterface interface(bench_settings(), *ngspice);
+        make_dut(interface, n);
+        std::vector<std::string> vectors;
+        for (int i = 0; i < n; ++i) {
+            vectors.push_back("v(y" + std::to_string(i) + ")");
+        }
+        const int rounds = std::max(1, 100000 / n);
+        run("outputs/update_and_set ports=" + std::to_string(n), static_cast<unsigned long long>(rounds) * n, [&] {
+            for (int round = 0; round < rounds; ++round) {
+                double level = (round & 1) ? 1.8 : 0.0;
+                for (auto &vector : vectors) {
+                    MockNgSpice::set_vector(vector, level);
+                }
+                interface.analog_outputs_update();
+                interface.set_digital_output();
+            }
+        });
+        run("outputs/update_unchanged ports=" + std::to_string(n), static_cast<unsigned long long>(rounds) * n, [&] {
+            for (int round = 0; round < rounds; ++round) {
+                interface.analog_outputs_update();
+                interface.set_digital_output();
+            }
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        g_filter = argv[1];
+    }
+    bench_barrier();
+    bench_srcdata();
+    bench_inputs();
+    bench_outputs();
+    return 0;
+}
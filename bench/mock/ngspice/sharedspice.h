@@ -0,0 +1,103 @@
+/*
+ * Subset of ngspice's sharedspice.h used by spicebind, for building the
+ * benchmarks against the ngspice stub (bench/mock_ngspice.cpp) on hosts
+ * without ngspice. The layouts match the ngspice shared library API.
+ */
+#ifndef NGSPICE_MOCK_SHAREDSPICE_H
+#define NGSPICE_MOCK_SHAREDSPICE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NG_BOOL
+#define NG_BOOL bool
+#endif
+
+typedef struct ngcomplex {
+    double cx_real;
+    double cx_imag;
+} ngcomplex_t;
+
+typedef struct vector_info {
+    char *v_name;
+    int v_type;
+    short v_flags;
+    double *v_realdata;
+    ngcomplex_t *v_compdata;
+    int v_length;
+} vector_info, *pvector_info;
+
+typedef struct vecvalues {
+    char *name;
+    double creal;
+    double cimag;
+    NG_BOOL is_scale;
+    NG_BOOL is_complex;
+} vecvalues, *pvecvalues;
+
+typedef struct vecvaluesall {
+    int veccount;
+    int vecindex;
+    pvecvalues *vecsa;
+} vecvaluesall, *pvecvaluesall;
+
+typedef struct vecinfo {
+    int number;
+    char *vecname;
+    NG_BOOL is_real;
+    void *pdvec;
+    void *pdvecscale;
+} vecinfo, *pvecinfo;
+
+typedef struct vecinfoall {
+    char *name;
+    char *title;
+    char *date;
+    char *type;
+    int veccount;
+    pvecinfo *vecs;
+} vecinfoall, *pvecinfoall;
+
+typedef struct evt_data {
+    int dcop;
+    double step;
+    char *node_value;
+} evt_data, *pevt_data;
+
+typedef struct evt_shared_data {
+    pevt_data *evt_dect;
+    int num_steps;
+} evt_shared_data, *pevt_shared_data;
+
+typedef int(SendChar)(char *, int, void *);
+typedef int(SendStat)(char *, int, void *);
+typedef int(ControlledExit)(int, NG_BOOL, NG_BOOL, int, void *);
+typedef int(SendData)(pvecvaluesall, int, int, void *);
+typedef int(SendInitData)(pvecinfoall, int, void *);
+typedef int(BGThreadRunning)(NG_BOOL, int, void *);
+typedef int(GetVSRCData)(double *, double, char *, int, void *);
+typedef int(GetISRCData)(double *, double, char *, int, void *);
+typedef int(GetSyncData)(double, double *, double, int, int, int, void *);
+typedef int(SendEvtData)(int, double, double, char *, void *, int, int, int, void *);
+typedef int(SendInitEvtData)(int, int, char *, char *, int, void *);
+
+int ngSpice_Init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata, SendInitData *sinitdata,
+                 BGThreadRunning *bgtrun, void *userData);
+int ngSpice_Init_Sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *userData);
+int ngSpice_Init_Evt(SendEvtData *sevtdata, SendInitEvtData *sinitevtdata, void *userData);
+int ngSpice_Command(char *command);
+pvector_info ngGet_Vec_Info(char *vecname);
+int ngSpice_Circ(char **circarray);
+char *ngSpice_CurPlot(void);
+char **ngSpice_AllPlots(void);
+char **ngSpice_AllVecs(char *plotname);
+NG_BOOL ngSpice_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NGSPICE_MOCK_SHAREDSPICE_H */
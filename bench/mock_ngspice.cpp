@@ -0,0 +1,109 @@
+#include "mock_ngspice.h"
+#include "ngspice/sharedspice.h"
+#include <map>
+#include <memory>
+
+namespace spice_bench {
+
+namespace {
+
+struct Vector {
+    std::string name;
+    double value = 0.0;
+    vector_info info{};
+};
+
+struct Engine {
+    std::map<std::string, std::unique_ptr<Vector>> vectors;  // stable vector_info addresses
+    unsigned long long vec_info_calls = 0;
+};
+
+auto engine() -> Engine & {
+    static Engine instance;
+    return instance;
+}
+
+} // namespace
+
+void MockNgSpice::set_vector(const std::string &name, double value) {
+    auto &slot = engine().vectors[name];
+    if (!slot) {
+        slot = std::make_unique<Vector>();
+        slot->name = name;
+        slot->info.v_name = slot->name.data();
+        slot->info.v_realdata = &slot->value;
+        slot->info.v_length = 1;
+    }
+    slot->value = value;
+}
+
+void MockNgSpice::clear_vectors() {
+    engine().vectors.clear();
+    engine().vec_info_calls = 0;
+}
+
+auto MockNgSpice::vec_info_count() -> unsigned long long {
+    return engine().vec_info_calls;
+}
+
+} // namespace spice_bench
+
+using spice_bench::engine;
+using spice_bench::Engine;
+
+extern "C" {
+
+int ngSpice_Init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata, SendInitData *sinitdata,
+                 BGThreadRunning *bgtrun, void *userData) {
+    (void)printfcn, (void)statfcn, (void)ngexit, (void)sdata, (void)sinitdata, (void)bgtrun, (void)userData;
+    return 0;
+}
+
+int ngSpice_Init_Sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *userData) {
+    (void)vsrcdat, (void)isrcdat, (void)syncdat, (void)ident, (void)userData;
+    return 0;
+}
+
+int ngSpice_Init_Evt(SendEvtData *sevtdata, SendInitEvtData *sinitevtdata, void *userData) {
+    (void)sevtdata, (void)sinitevtdata, (void)userData;
+    return 0;
+}
+
+int ngSpice_Command(char *command) {
+    (void)command;
+    return 0;
+}
+
+pvector_info ngGet_Vec_Info(char *vecname) {
+    Engine &e = engine();
+    e.vec_info_calls++;
+    auto it = e.vectors.find(vecname);
+    return it == e.vectors.end() ? nullptr : &it->second->info;
+}
+
+int ngSpice_Circ(char **circarray) {
+    (void)circarray;
+    return 0;
+}
+
+char *ngSpice_CurPlot(void) {
+    static char plot[] = "const";
+    return plot;
+}
+
+char **ngSpice_AllPlots(void) {
+    static char *plots[] = {nullptr};
+    return plots;
+}
+
+char **ngSpice_AllVecs(char *plotname) {
+    (void)plotname;
+    static char *vecs[] = {nullptr};
+    return vecs;
+}
+
+NG_BOOL ngSpice_running(void) {
+    return false;
+}
+
+} // extern "C"
@@ -0,0 +1,36 @@
+#ifndef MOCK_NGSPICE_H
+#define MOCK_NGSPICE_H
+
+#include <string>
+
+namespace spice_bench {
+
+/**
+ * @brief ngspice stub linked in place of libngspice
+ *
+ * Provides the shared library API spicebind calls. Commands are accepted and
+ * ignored, no background thread is started; ngGet_Vec_Info() returns the
+ * values set with set_vector() so analog outputs can be read back.
+ */
+class MockNgSpice {
+public:
+    /**
+     * @brief Set the last value of a vector
+     * @param name Vector name as passed to ngGet_Vec_Info, e.g. "v(out)"
+     */
+    static void set_vector(const std::string &name, double value);
+
+    /**
+     * @brief Remove all vectors
+     */
+    static void clear_vectors();
+
+    /**
+     * @brief Number of ngGet_Vec_Info() calls since the last clear_vectors()
+     */
+    static unsigned long long vec_info_count();
+};
+
+} // namespace spice_bench
+
+#endif // MOCK_NGSPICE_H
@@ -0,0 +1,320 @@
+#include "mock_vpi.h"
+#include <cstdarg>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace spice_bench {
+
+namespace {
+
+struct Object {
+    int type = 0;
+    std::string name;
+    std::string full_name;
+    int direction = 0;
+    int size = 1;
+    int index = 0;
+    Object *parent = nullptr;              // module of a port or net, net of a bit
+    Object *net = nullptr;                 // net of a port
+    std::vector<Object *> children;        // ports and nets of a module, bits of a vector net
+    int scalar = vpi0;
+    double real = 0.0;
+};
+
+// iterator state returned by vpi_iterate()
+struct Iterator {
+    std::vector<Object *> items;
+    size_t next = 0;
+};
+
+struct Host {
+    std::deque<Object> objects;  // stable addresses
+    std::vector<std::unique_ptr<Iterator>> iterators;
+    std::vector<std::unique_ptr<s_cb_data>> callbacks;
+    unsigned long long time = 0;
+    unsigned long long puts = 0;
+};
+
+auto host() -> Host & {
+    static Host instance;
+    return instance;
+}
+
+auto object(vpiHandle handle) -> Object * {
+    return reinterpret_cast<Object *>(handle);
+}
+
+auto handle(Object *object) -> vpiHandle {
+    return reinterpret_cast<vpiHandle>(object);
+}
+
+} // namespace
+
+auto MockVpi::add_module(const std::string &full_name) -> vpiHandle {
+    Object &module = host().objects.emplace_back();
+    module.type = vpiModule;
+    module.full_name = full_name;
+    module.name = full_name.substr(full_name.rfind('.') + 1);
+    return handle(&module);
+}
+
+auto MockVpi::add_port(vpiHandle module_handle, const std::string &name, int direction, int net_type, int size) -> vpiHandle {
+    Host &h = host();
+    Object *module = object(module_handle);
+
+    Object &net = h.objects.emplace_back();
+    net.type = net_type;
+    net.name = name;
+    net.full_name = module->full_name + "." + name;
+    net.direction = direction;
+    net.size = size;
+    net.parent = module;
+    if (size > 1) {
+        for (int i = 0; i < size; ++i) {
+            Object &bit = h.objects.emplace_back();
+            bit.type = vpiNetBit;
+            bit.name = name + "[" + std::to_string(i) + "]";
+            bit.full_name = net.full_name + "[" + std::to_string(i) + "]";
+            bit.direction = direction;
+            bit.index = i;
+            bit.parent = &net;
+            net.children.push_back(&bit);
+        }
+    }
+
+    Object &port = h.objects.emplace_back();
+    port.type = vpiPort;
+    port.name = name;
+    port.full_name = net.full_name;
+    port.direction = direction;
+    port.size = size;
+    port.parent = module;
+    port.net = &net;
+
+    module->children.push_back(&port);
+    module->children.push_back(&net);
+    return handle(&port);
+}
+
+auto MockVpi::net(vpiHandle port) -> vpiHandle {
+    return handle(object(port)->net);
+}
+
+void MockVpi::set_scalar(vpiHandle net, int value) {
+    object(net)->scalar = value;
+}
+
+auto MockVpi::scalar(vpiHandle net) -> int {
+    return object(net)->scalar;
+}
+
+auto MockVpi::real(vpiHandle net) -> double {
+    return object(net)->real;
+}
+
+void MockVpi::set_time(unsigned long long time) {
+    host().time = time;
+}
+
+auto MockVpi::put_count() -> unsigned long long {
+    return host().puts;
+}
+
+void MockVpi::reset() {
+    Host &h = host();
+    h.objects.clear();
+    h.iterators.clear();
+    h.callbacks.clear();
+    h.time = 0;
+    h.puts = 0;
+}
+
+} // namespace spice_bench
+
+using spice_bench::host;
+using spice_bench::Object;
+
+extern "C" {
+
+vpiHandle vpi_register_cb(p_cb_data cb_data_p) {
+    auto &callbacks = host().callbacks;
+    callbacks.push_back(std::make_unique<s_cb_data>(*cb_data_p));
+    return reinterpret_cast<vpiHandle>(callbacks.back().get());
+}
+
+PLI_INT32 vpi_remove_cb(vpiHandle cb_obj) {
+    auto &callbacks = host().callbacks;
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+        if (reinterpret_cast<vpiHandle>(it->get()) == cb_obj) {
+            callbacks.erase(it);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+vpiHandle vpi_register_systf(p_vpi_systf_data systf_data_p) {
+    (void)systf_data_p;
+    return nullptr;
+}
+
+vpiHandle vpi_handle_by_name(PLI_BYTE8 *name, vpiHandle scope) {
+    std::string wanted = name;
+    for (Object &candidate : host().objects) {
+        if (candidate.type == vpiPort || candidate.type == vpiNetBit) {
+            continue;
+        }
+        if (scope != nullptr ? (candidate.parent == spice_bench::object(scope) && candidate.name == wanted) : candidate.full_name == wanted) {
+            return spice_bench::handle(&candidate);
+        }
+    }
+    return nullptr;
+}
+
+vpiHandle vpi_handle_by_index(vpiHandle object, PLI_INT32 indx) {
+    Object *net = spice_bench::object(object);
+    if (net->children.empty()) {
+        return indx == 0 ? object : nullptr;  // a scalar is its own bit 0
+    }
+    return (indx >= 0 && indx < static_cast<PLI_INT32>(net->children.size())) ? spice_bench::handle(net->children[indx]) : nullptr;
+}
+
+vpiHandle vpi_handle(PLI_INT32 type, vpiHandle refHandle) {
+    if (type == vpiParent && refHandle != nullptr) {
+        return spice_bench::handle(spice_bench::object(refHandle)->parent);
+    }
+    return nullptr;
+}
+
+vpiHandle vpi_iterate(PLI_INT32 type, vpiHandle refHandle) {
+    auto iterator = std::make_unique<spice_bench::Iterator>();
+    for (Object *child : spice_bench::object(refHandle)->children) {
+        if (child->type == type) {
+            iterator->items.push_back(child);
+        }
+    }
+    if (iterator->items.empty()) {
+        return nullptr;
+    }
+    host().iterators.push_back(std::move(iterator));
+    return reinterpret_cast<vpiHandle>(host().iterators.back().get());
+}
+
+vpiHandle vpi_scan(vpiHandle iterator) {
+    auto *it = reinterpret_cast<spice_bench::Iterator *>(iterator);
+    return (it->next < it->items.size()) ? spice_bench::handle(it->items[it->next++]) : nullptr;
+}
+
+PLI_INT32 vpi_free_object(vpiHandle object) {
+    (void)object;
+    return 1;
+}
+
+PLI_INT32 vpi_get(PLI_INT32 property, vpiHandle object) {
+    if (object == nullptr) {
+        // time unit and precision of the host: 1 ps
+        return (property == vpiTimeUnit || property == vpiTimePrecision) ? -12 : 0;
+    }
+    Object *obj = spice_bench::object(object);
+    switch (property) {
+    case vpiType:
+        return obj->type;
+    case vpiSize:
+        return obj->size;
+    case vpiDirection:
+        return obj->direction;
+    case vpiIndex:
+        return obj->index;
+    default:
+        return 0;
+    }
+}
+
+PLI_BYTE8 *vpi_get_str(PLI_INT32 property, vpiHandle object) {
+    Object *obj = spice_bench::object(object);
+    if (property == vpiName) {
+        return const_cast<PLI_BYTE8 *>(obj->name.c_str());
+    }
+    if (property == vpiFullName) {
+        return const_cast<PLI_BYTE8 *>(obj->full_name.c_str());
+    }
+    return nullptr;
+}
+
+void vpi_get_value(vpiHandle expr, p_vpi_value value_p) {
+    Object *obj = spice_bench::object(expr);
+    switch (value_p->format) {
+    case vpiRealVal:
+        value_p->value.real = (obj->type == vpiRealVar) ? obj->real : static_cast<double>(obj->scalar == vpi1);
+        break;
+    case vpiIntVal:
+        value_p->value.integer = (obj->scalar == vpi1) ? 1 : 0;
+        break;
+    case vpiScalarVal:
+        value_p->value.scalar = obj->scalar;
+        break;
+    case vpiBinStrVal: {
+        // most significant bit first, valid until the next call like in a simulator
+        static std::string text;
+        auto bit = [](int scalar) { return scalar == vpi0 ? '0' : scalar == vpi1 ? '1' : scalar == vpiZ ? 'z' : 'x'; };
+        text.clear();
+        if (obj->children.empty()) {
+            text += bit(obj->scalar);
+        }
+        for (auto it = obj->children.rbegin(); it != obj->children.rend(); ++it) {
+            text += bit((*it)->scalar);
+        }
+        value_p->value.str = &text[0];
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+vpiHandle vpi_put_value(vpiHandle object, p_vpi_value value_p, p_vpi_time time_p, PLI_INT32 flags) {
+    (void)time_p;
+    (void)flags;
+    Object *obj = spice_bench::object(object);
+    if (value_p->format == vpiRealVal) {
+        obj->real = value_p->value.real;
+    } else if (value_p->format == vpiScalarVal) {
+        obj->scalar = value_p->value.scalar;
+    } else if (value_p->format == vpiIntVal) {
+        obj->scalar = value_p->value.integer != 0 ? vpi1 : vpi0;
+    }
+    host().puts++;
+    return nullptr;
+}
+
+void vpi_get_time(vpiHandle object, p_vpi_time time_p) {
+    (void)object;
+    time_p->high = static_cast<PLI_UINT32>(host().time >> 32);
+    time_p->low = static_cast<PLI_UINT32>(host().time & 0xffffffffULL);
+    time_p->real = static_cast<double>(host().time);
+}
+
+PLI_INT32 vpi_printf(const PLI_BYTE8 *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = std::vprintf(format, args);
+    va_end(args);
+    return written;
+}
+
+PLI_INT32 vpi_vprintf(const PLI_BYTE8 *format, va_list ap) {
+    return std::vprintf(format, ap);
+}
+
+PLI_INT32 vpi_flush(void) {
+    return std::fflush(stdout);
+}
+
+PLI_INT32 vpi_control(PLI_INT32 operation, ...) {
+    (void)operation;
+    return 1;
+}
+
+} // extern "C"
@@ -0,0 +1,66 @@
+#ifndef MOCK_VPI_H
+#define MOCK_VPI_H
+
+#include "vpi_user.h"
+#include <string>
+
+namespace spice_bench {
+
+/**
+ * @brief In-memory VPI host for running the bridge without an HDL simulator
+ *
+ * Implements the VPI functions spicebind calls on a small object model of
+ * modules, ports and nets. Values written with vpi_put_value() are stored on
+ * the net; callbacks are recorded but only fired by the benchmark itself.
+ */
+class MockVpi {
+public:
+    /**
+     * @brief Add a module instance
+     * @param full_name Hierarchical name, e.g. "tb.dut"
+     */
+    static vpiHandle add_module(const std::string &full_name);
+
+    /**
+     * @brief Add a port with its net to a module
+     * @param module Module from add_module()
+     * @param name Port name
+     * @param direction vpiInput or vpiOutput
+     * @param net_type vpiNet, vpiReg or vpiRealVar
+     * @param size Bits of the port (1 for scalars)
+     * @return Port handle; the net is found with vpi_handle_by_name(name, module)
+     */
+    static vpiHandle add_port(vpiHandle module, const std::string &name, int direction, int net_type = vpiNet, int size = 1);
+
+    /**
+     * @brief Net of a port added with add_port()
+     */
+    static vpiHandle net(vpiHandle port);
+
+    /**
+     * @brief Drive a scalar net (or one bit of a vector net) from the "HDL" side
+     */
+    static void set_scalar(vpiHandle net, int value);
+
+    static int scalar(vpiHandle net);
+    static double real(vpiHandle net);
+
+    /**
+     * @brief Simulation time returned by vpi_get_time()
+     */
+    static void set_time(unsigned long long time);
+
+    /**
+     * @brief Number of vpi_put_value() calls since the last reset()
+     */
+    static unsigned long long put_count();
+
+    /**
+     * @brief Remove all objects and callbacks
+     */
+    static void reset();
+};
+
+} // namespace spice_bench
+
+#endif // MOCK_VPI_H
@@ -0,0 +1,75 @@
+#include "AdaptiveTolerance.h"
+#include <cstdio>
+
+namespace spice_vpi {
+
+AdaptiveTolerance::AdaptiveTolerance(const Config::Settings &config)
+    : enabled_(config.adaptive == "on"), reltol_(config.adaptive_reltol), abstol_(config.adaptive_abstol),
+      loose_reltol_(config.adaptive_loose_reltol), loose_abstol_(config.adaptive_loose_abstol), max_step_(config.adaptive_max_step),
+      hold_(config.adaptive_hold) {}
+
+auto AdaptiveTolerance::enabled() const -> bool {
+    return enabled_;
+}
+
+void AdaptiveTolerance::on_step(double time, bool near_threshold, double *delta_time) {
+    if (!enabled_) {
+        return;
+    }
+    if (input_changed_.exchange(false, std::memory_order_relaxed) || near_threshold) {
+        last_activity_ = time;
+    }
+
+    bool loose = time - last_activity_ >= hold_;
+    want_loose_.store(loose, std::memory_order_relaxed);
+
+    // the step limit needs no pause, tighten it before the edge gets closer
+    if (!loose && max_step_ > 0.0 && *delta_time > max_step_) {
+        *delta_time = max_step_;
+    }
+}
+
+void AdaptiveTolerance::input_changed() {
+    if (enabled_) {
+        input_changed_.store(true, std::memory_order_relaxed);
+        want_loose_.store(false, std::memory_order_relaxed);
+    }
+}
+
+auto AdaptiveTolerance::needs_switch() const -> bool {
+    return enabled_ && want_loose_.load(std::memory_order_relaxed) != loose_;
+}
+
+auto AdaptiveTolerance::apply() -> std::string {
+    loose_ = want_loose_.load(std::memory_order_relaxed);
+    if (loose_) {
+        loosened_++;
+    } else {
+        tightened_++;
+    }
+    return command(loose_);
+}
+
+auto AdaptiveTolerance::tight_command() const -> std::string {
+    return command(false);
+}
+
+auto AdaptiveTolerance::loose() const -> bool {
+    return loose_;
+}
+
+auto AdaptiveTolerance::loosened() const -> unsigned long long {
+    return loosened_;
+}
+
+auto AdaptiveTolerance::tightened() const -> unsigned long long {
+    return tightened_;
+}
+
+auto AdaptiveTolerance::command(bool loose) const -> std::string {
+    char buffer[96];
+    std::snprintf(buffer, sizeof(buffer), "option reltol=%g abstol=%g", loose ? loose_reltol_ : reltol_, loose ? loose_abstol_ : abstol_);
+    return buffer;
+}
+
+} // namespace spice_vpi
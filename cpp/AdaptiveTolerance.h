@@ -0,0 +1,81 @@
+#ifndef ADAPTIVE_TOLERANCE_H
+#define ADAPTIVE_TOLERANCE_H
+
+#include "Config.h"
+#include <atomic>
+#include <string>
+
+namespace spice_vpi {
+
+/**
+ * @brief Activity-driven choice between tight and loose solver tolerances of one partition (SPICE_ADAPTIVE)
+ *
+ * The ngspice thread reports after each accepted step whether a bound logic
+ * output is near its thresholds. Once no output has been near them and no
+ * input has changed for the hold time, the partition asks for the loose
+ * tolerances; an input change or an output approaching a threshold asks for
+ * the tight ones again. The maximum step applies at once from the ngspice
+ * thread, reltol/abstol are switched by the HDL thread, which has to pause
+ * ngspice for ngspice to read them.
+ */
+class AdaptiveTolerance {
+public:
+    explicit AdaptiveTolerance(const Config::Settings &config);
+
+    bool enabled() const;
+
+    /**
+     * @brief An accepted step ended (ngspice thread)
+     * @param time SPICE time of the step end in seconds
+     * @param near_threshold A bound logic output is within the margin of a threshold
+     * @param delta_time Next step of ngspice, capped at the tight maximum step while tight
+     */
+    void on_step(double time, bool near_threshold, double *delta_time);
+
+    /**
+     * @brief An input of the partition changed (HDL thread)
+     */
+    void input_changed();
+
+    /**
+     * @brief Check if the requested tolerances differ from the applied ones (HDL thread)
+     */
+    bool needs_switch() const;
+
+    /**
+     * @brief Apply the requested tolerances (HDL thread, while ngspice is paused)
+     * @return ngspice command setting them
+     */
+    std::string apply();
+
+    /**
+     * @brief ngspice command setting the tight tolerances, applied before the run
+     */
+    std::string tight_command() const;
+
+    bool loose() const;
+    unsigned long long loosened() const;
+    unsigned long long tightened() const;
+
+private:
+    std::string command(bool loose) const;
+
+    bool enabled_;
+    double reltol_;
+    double abstol_;
+    double loose_reltol_;
+    double loose_abstol_;
+    double max_step_;
+    double hold_;
+
+    double last_activity_ = 0.0;             // ngspice thread only
+    std::atomic<bool> input_changed_{false};  // set by the HDL thread, taken by the ngspice thread
+    std::atomic<bool> want_loose_{false};
+    bool loose_ = false;                      // applied, HDL thread only
+    unsigned long long loosened_ = 0;
+    unsigned long long tightened_ = 0;
+};
+
+} // namespace spice_vpi
+
+#endif // ADAPTIVE_TOLERANCE_H
@@ -1,20 +1,22 @@
 #include "AnalogDigitalInterface.h"
 #include "Debug.h"
+#include "OutputStub.h"
 #include "ngspice/sharedspice.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <stdexcept>
 
 namespace spice_vpi {
 
 // PortInfo constructors and operators
 AnalogDigitalInterface::PortInfo::PortInfo() 
-    : handle(nullptr), direction(0), net_type(0), size(1), is_vector(false), bit_index(-1), value(0.0), changed(false) {}
+    : handle(nullptr), direction(0), net_type(0), size(1), is_vector(false), bit_index(-1), value(0.0), changed(false), event(false), requests(0) {}
 
 AnalogDigitalInterface::PortInfo::PortInfo(const PortInfo &other)
     : name(other.name), base_name(other.base_name), handle(other.handle), direction(other.direction), 
       net_type(other.net_type), size(other.size), is_vector(other.is_vector),
-      bit_index(other.bit_index), value(other.value), changed(other.changed) {}
+      bit_index(other.bit_index), value(other.value), changed(other.changed), event(other.event), requests(other.requests) {}
 
 auto AnalogDigitalInterface::PortInfo::operator=(const PortInfo &other) -> AnalogDigitalInterface::PortInfo & {
     if (this != &other) {
@@ -28,6 +30,8 @@ auto AnalogDigitalInterface::PortInfo::operator=(const PortInfo &other) -> Analo
         bit_index = other.bit_index;
         value = other.value;
         changed = other.changed;
+        event = other.event;
+        requests = other.requests;
     }
     return *this;
 }
@@ -35,7 +39,7 @@ auto AnalogDigitalInterface::PortInfo::operator=(const PortInfo &other) -> Analo
 AnalogDigitalInterface::PortInfo::PortInfo(PortInfo &&other) noexcept
     : name(std::move(other.name)), base_name(std::move(other.base_name)), handle(other.handle), 
       direction(other.direction), net_type(other.net_type), size(other.size),
-      is_vector(other.is_vector), bit_index(other.bit_index), value(other.value), changed(other.changed) {}
+      is_vector(other.is_vector), bit_index(other.bit_index), value(other.value), changed(other.changed), event(other.event), requests(other.requests) {}
 
 auto AnalogDigitalInterface::PortInfo::operator=(PortInfo &&other) noexcept -> AnalogDigitalInterface::PortInfo & {
     if (this != &other) {
@@ -49,13 +53,15 @@ auto AnalogDigitalInterface::PortInfo::operator=(PortInfo &&other) noexcept -> A
         bit_index = other.bit_index;
         value = (other.value);
         changed = (other.changed);
+        event = other.event;
+        requests = other.requests;
     }
     return *this;
 }
 
 // AnalogDigitalInterface implementation
-AnalogDigitalInterface::AnalogDigitalInterface(const Config::Settings& config) 
-    : config_(&config) {}
+AnalogDigitalInterface::AnalogDigitalInterface(const Config::Settings& config, NgSpiceLibrary& ngspice) 
+    : config_(&config), ngspice_(&ngspice) {}
 
 auto AnalogDigitalInterface::digital_to_analog(int digital_value) const -> double {
     switch (digital_value) {
@@ -82,14 +88,15 @@ std::string AnalogDigitalInterface::create_indexed_name(const std::string &base_
     return base_name + "[" + std::to_string(index) + "]"; 
 }
 
-void AnalogDigitalInterface::add_port(vpiHandle port) {
+auto AnalogDigitalInterface::add_port(vpiHandle port) -> PortBinding {
 
     std::string pname = vpi_get_str(vpiName, port);
+    std::string port_name = pname;
 
     vpiHandle module = vpi_handle(vpiParent, port);
     if (module == nullptr) {
         ERROR("add_port: no parent module for port %s", pname.c_str());
-        return;
+        return PortBinding::Unbound;
     }
 
     const std::string module_path = vpi_get_str(vpiFullName, module);
@@ -97,7 +104,7 @@ void AnalogDigitalInterface::add_port(vpiHandle port) {
     vpiHandle net = vpi_handle_by_name(const_cast<char*>(pname.c_str()), module);
     if (net == nullptr) {
         ERROR("add_port: net %s in module %s not found", pname.c_str(), module_path.c_str());
-        return;
+        return PortBinding::Unbound;
     }
 
     // If full path discovery is enabled, add the module path to the port name
@@ -115,10 +122,10 @@ void AnalogDigitalInterface::add_port(vpiHandle port) {
     // Validate net type
     if (net_type != vpiNet && net_type != vpiReg && net_type != vpiRealVar) {
         ERROR("add_port: unsupported net type %d for %s", net_type, pname.c_str());
-        return;
+        return PortBinding::Unbound;
     }
 
-    DBG("Adding port: %s, dir=%d, size=%d, net_type=%d", pname.c_str(), dir, port_size, net_type);
+    TRACE(General, "Adding port: %s, dir=%d, size=%d, net_type=%d", pname.c_str(), dir, port_size, net_type);
 
     if (port_size > 1) {
         // Vector port - create entries for each bit
@@ -142,15 +149,18 @@ void AnalogDigitalInterface::add_port(vpiHandle port) {
                 if (dir == vpiInput) {
                     std::lock_guard<std::mutex> lock(inputs_mutex_);
                     analog_inputs_.emplace(indexed_name, std::move(port_info));
-                    DBG("Added analog input: %s", indexed_name.c_str());
+                    TRACE(General, "Added analog input: %s", indexed_name.c_str());
                 } else if (dir == vpiOutput) {
                     std::lock_guard<std::mutex> lock(outputs_mutex_);
                     analog_outputs_.emplace(spice_name, std::move(port_info));
-                    DBG("Added analog output: %s", indexed_name.c_str());
+                    TRACE(General, "Added analog output: %s", indexed_name.c_str());
                 }
             }
         }
-    } else {
+        return PortBinding::Analog;
+    }
+
+    {
         // Scalar port
         PortInfo port_info;
         port_info.name = pname;
@@ -168,13 +178,31 @@ void AnalogDigitalInterface::add_port(vpiHandle port) {
         if (dir == vpiInput) {
             std::lock_guard<std::mutex> lock(inputs_mutex_);
             analog_inputs_.emplace(pname, std::move(port_info));
-            DBG("Added analog input: %s", pname.c_str());
+            TRACE(General, "Added analog input: %s", pname.c_str());
         } else if (dir == vpiOutput) {
             std::lock_guard<std::mutex> lock(outputs_mutex_);
             analog_outputs_.emplace(spice_name, std::move(port_info));
-            DBG("Added analog output: %s", pname.c_str());
+            TRACE(General, "Added analog output: %s", pname.c_str());
         }
     }
+
+    if (dir == vpiInput && net_type != vpiRealVar && is_no_redo_input(pname, port_name)) {
+        TRACE(General, "Input %s bound without redo", pname.c_str());
+        return PortBinding::NoRedo;
+    }
+    return PortBinding::Analog;
+}
+
+// Listed by SPICE_NO_REDO_INPUTS, either with the bound name or the plain port name ("*" for all)
+auto AnalogDigitalInterface::is_no_redo_input(const std::string &name, const std::string &port_name) const -> bool {
+    std::string lower_port_name = port_name;
+    std::transform(lower_port_name.begin(), lower_port_name.end(), lower_port_name.begin(), ::tolower);
+    for (const std::string &no_redo_input : config_->no_redo_input_names) {
+        if (no_redo_input == "*" || no_redo_input == name || no_redo_input == lower_port_name) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void AnalogDigitalInterface::set_analog_input(const char* name, double *value) {
@@ -182,23 +210,35 @@ void AnalogDigitalInterface::set_analog_input(const char* name, double *value) {
     auto it = analog_inputs_.find(name);
     if (it != analog_inputs_.end()) {
         *value = it->second.value;
+        it->second.requests++;
     } else {
+        unknown_source_requests_++;
         ERROR("analog input %s not found", name);
     }
 }
 
+void AnalogDigitalInterface::get_analog_input(const char* name, double *value) const {
+    std::lock_guard<std::mutex> lock(inputs_mutex_);
+    auto it = analog_inputs_.find(name);
+    if (it != analog_inputs_.end()) {
+        *value = it->second.value;
+    }
+}
 
 void AnalogDigitalInterface::analog_outputs_update() {
     std::lock_guard<std::mutex> lock(outputs_mutex_);
 
     for (auto &[name, port_info] : analog_outputs_) {
+        if (port_info.event) {
+            continue;
+        }
 
-        pvector_info vector_info = ngGet_Vec_Info(const_cast<char*>(name.c_str())); // TODO: this can be cashed (no need to call ngspice every time)
+        pvector_info vector_info = ngspice_->get_vec_info(name); // TODO: this can be cashed (no need to call ngspice every time)
         if ((vector_info != nullptr) && vector_info->v_length > 0) {
             double new_value = vector_info->v_realdata[vector_info->v_length - 1];
 
             if (std::abs(port_info.value - new_value) > config_->min_analog_change_threshold) {
-                DBG("Analog output %s updated: %g -> %g", name.c_str(), port_info.value, new_value);
+                TRACE(Port, "Analog output %s updated: %g -> %g", name.c_str(), port_info.value, new_value);
                 port_info.value = new_value;
                 port_info.changed = true;
             }
@@ -206,12 +246,75 @@ void AnalogDigitalInterface::analog_outputs_update() {
     }
 }
 
-void AnalogDigitalInterface::set_digital_output() {
+auto AnalogDigitalInterface::outputs_near_threshold(double margin) const -> bool {
     std::lock_guard<std::mutex> lock(outputs_mutex_);
 
+    for (const auto &[name, port_info] : analog_outputs_) {
+        if (port_info.event || port_info.net_type == vpiRealVar) {
+            continue;
+        }
+        pvector_info vector_info = ngspice_->get_vec_info(name);
+        if ((vector_info != nullptr) && vector_info->v_length > 0) {
+            double value = vector_info->v_realdata[vector_info->v_length - 1];
+            if (value > config_->logic_threshold_low - margin && value < config_->logic_threshold_high + margin) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+auto AnalogDigitalInterface::bind_event_output(int index, const char *node, const char *type) -> bool {
+    if (type == nullptr || std::strcmp(type, "d") != 0) {
+        return false;
+    }
+
+    std::string key = std::string("v(") + node + ")";
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    auto it = analog_outputs_.find(key);
+    if (it == analog_outputs_.end() || it->second.net_type == vpiRealVar) {
+        return false;
+    }
+    it->second.event = true;
+    event_outputs_[index] = key;
+    TRACE(General, "Output %s bound to event node %d", it->second.name.c_str(), index);
+    return true;
+}
+
+void AnalogDigitalInterface::event_output_update(int index, const char *state) {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    auto node = event_outputs_.find(index);
+    if (node == event_outputs_.end() || state == nullptr) {
+        return;
+    }
+
+    // the first character is the level, the second the strength
+    int digital_value = vpiX;
+    if (state[0] == '0') {
+        digital_value = vpi0;
+    } else if (state[0] == '1') {
+        digital_value = vpi1;
+    }
+
+    PortInfo &port_info = analog_outputs_.at(node->second);
+    double new_value = digital_to_analog(digital_value);
+    if (port_info.value != new_value) {
+        TRACE(Port, "Event output %s updated: %s", port_info.name.c_str(), state);
+        port_info.value = new_value;
+        port_info.changed = true;
+    }
+}
+
+auto AnalogDigitalInterface::set_digital_output() -> size_t {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+
+    size_t written = 0;
     for (auto &[name, port_info] : analog_outputs_) {
         if (port_info.changed) { // Read and clear change flag
             port_info.changed = false;
+            written++;
             double analog_value = port_info.value;
             
             if(port_info.net_type == vpiRealVar) {
@@ -219,7 +322,10 @@ void AnalogDigitalInterface::set_digital_output() {
                 val.format = vpiRealVal;
                 val.value.real = analog_value;
                 vpi_put_value(port_info.handle, &val, nullptr, vpiNoDelay);
-                DBG("Updated digital real %s = %g", name.c_str(), analog_value);
+                if (output_recorder_ != nullptr) {
+                    output_recorder_->output(port_info.handle, port_info.bit_index, val);
+                }
+                TRACE(Port, "Updated digital real %s = %g", name.c_str(), analog_value);
             } else {
                 int digital_value = analog_to_digital(analog_value);
 
@@ -228,12 +334,133 @@ void AnalogDigitalInterface::set_digital_output() {
                 val.value.scalar = digital_value;
 
                 vpi_put_value(port_info.handle, &val, nullptr, vpiNoDelay);
-                DBG("Updated digital scalar %s = %d", name.c_str(), digital_value);
+                if (output_recorder_ != nullptr) {
+                    output_recorder_->output(port_info.handle, port_info.bit_index, val);
+                }
+                TRACE(Port, "Updated digital scalar %s = %d", name.c_str(), digital_value);
+            }
+            TRACE(Timeline, "event=%d output %s = %g", Tracer::OutputUpdate, name.c_str(), analog_value);
+        }
+    }
+    return written;
+}
+
+void AnalogDigitalInterface::set_output_recorder(OutputRecorder *recorder) {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    output_recorder_ = recorder;
+}
+
+void AnalogDigitalInterface::set_surrogate(std::unique_ptr<SurrogateModel> model) {
+    std::scoped_lock lock(inputs_mutex_, outputs_mutex_);
+    surrogate_inputs_.clear();
+    surrogate_outputs_.clear();
+    for (const SurrogateModel::Input &input : model->inputs()) {
+        auto it = analog_inputs_.find(input.name);
+        if (it == analog_inputs_.end()) {
+            throw std::runtime_error("surrogate input " + input.name + " is not a bound input port");
+        }
+        surrogate_inputs_.push_back(&it->second);
+    }
+    for (const SurrogateModel::Output &output : model->outputs()) {
+        auto it = analog_outputs_.find("v(" + output.name + ")");
+        if (it == analog_outputs_.end()) {
+            throw std::runtime_error("surrogate output " + output.name + " is not a bound output port");
+        }
+        it->second.changed = true;
+        surrogate_outputs_.push_back(&it->second);
+    }
+    surrogate_in_.assign(surrogate_inputs_.size(), 0.0);
+    surrogate_values_.assign(surrogate_outputs_.size(), 0.0);
+    surrogate_delays_.assign(surrogate_outputs_.size(), 0.0);
+    surrogate_ = std::move(model);
+}
+
+auto AnalogDigitalInterface::surrogate_update() -> size_t {
+    std::scoped_lock lock(inputs_mutex_, outputs_mutex_);
+    if (surrogate_ == nullptr) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < surrogate_inputs_.size(); ++i) {
+        surrogate_in_[i] = surrogate_inputs_[i]->value;
+    }
+    surrogate_->evaluate(surrogate_in_.data(), surrogate_values_.data(), surrogate_delays_.data());
+
+    size_t written = 0;
+    for (size_t j = 0; j < surrogate_outputs_.size(); ++j) {
+        PortInfo &port_info = *surrogate_outputs_[j];
+        double new_value = surrogate_values_[j];
+
+        s_vpi_value val;
+        if (port_info.net_type == vpiRealVar) {
+            if (!port_info.changed && std::abs(port_info.value - new_value) <= config_->min_analog_change_threshold) {
+                continue;
+            }
+            val.format = vpiRealVal;
+            val.value.real = new_value;
+        } else {
+            if (!port_info.changed && analog_to_digital(port_info.value) == analog_to_digital(new_value)) {
+                continue;  // same level as already scheduled
             }
+            val.format = vpiScalarVal;
+            val.value.scalar = analog_to_digital(new_value);
         }
+        port_info.value = new_value;
+        port_info.changed = false;
+
+        auto ticks = static_cast<unsigned long long>(std::llround(surrogate_delays_[j] * static_cast<double>(config_->time_precision)));
+        s_vpi_time delay;
+        delay.type = vpiSimTime;
+        delay.high = static_cast<PLI_UINT32>(ticks >> 32);
+        delay.low = static_cast<PLI_UINT32>(ticks & 0xffffffffULL);
+        vpi_put_value(port_info.handle, &val, &delay, vpiInertialDelay);
+        TRACE(Port, "Surrogate output %s = %g after %llu ticks", port_info.name.c_str(), new_value, ticks);
+        written++;
     }
+    return written;
 }
 
+void AnalogDigitalInterface::compare_digital_output(const AnalogDigitalInterface &reference, unsigned long long time) {
+    std::scoped_lock lock(outputs_mutex_, reference.outputs_mutex_);
+
+    for (auto &[name, port_info] : analog_outputs_) {
+        port_info.changed = false;
+
+        auto ref = reference.analog_outputs_.find(name);
+        if (ref == reference.analog_outputs_.end()) {
+            continue;
+        }
+
+        bool differs = false;
+        if (port_info.net_type == vpiRealVar) {
+            differs = std::abs(port_info.value - ref->second.value) > config_->corner_tolerance;
+        } else {
+            differs = analog_to_digital(port_info.value) != reference.analog_to_digital(ref->second.value);
+        }
+
+        if (differs) {
+            OutputDivergence &divergence = divergences_[port_info.name];
+            if (!divergence.active) {
+                if (divergence.count == 0) {
+                    divergence.first_time = time;
+                }
+                divergence.count++;
+                divergence.active = true;
+                TRACE(Port, "Corner output %s diverged at t=%llu: %g vs %g", name.c_str(), time, port_info.value, ref->second.value);
+            }
+        } else {
+            auto it = divergences_.find(port_info.name);
+            if (it != divergences_.end()) {
+                it->second.active = false;
+            }
+        }
+    }
+}
+
+auto AnalogDigitalInterface::divergences() const -> std::map<std::string, OutputDivergence> {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    return divergences_;
+}
 
 void AnalogDigitalInterface::update_all_digital_inputs() {
     std::lock_guard<std::mutex> lock(inputs_mutex_);
@@ -265,7 +492,7 @@ void AnalogDigitalInterface::digital_input_update(vpiHandle handle) {
 
     // std::lock_guard<std::mutex> lock(inputs_mutex_);
 
-    DBG("Digital input update: %s size=%d net_type=%d", name.c_str(), size, net_type);
+    TRACE(Port, "Digital input update: %s size=%d net_type=%d", name.c_str(), size, net_type);
 
     if (net_type == vpiRealVar) {
         auto it = analog_inputs_.find(name);
@@ -275,12 +502,12 @@ void AnalogDigitalInterface::digital_input_update(vpiHandle handle) {
             vpi_get_value(handle, &val);
 
             double old_value = it->second.value;
-            DBG("Digital X input %s : %g -> %g", name.c_str(), old_value, val.value.real);
+            TRACE(Port, "Digital X input %s : %g -> %g", name.c_str(), old_value, val.value.real);
 
             if (std::abs(old_value - val.value.real) > config_->min_analog_change_threshold) {
                 it->second.value= val.value.real;
                 it->second.changed = true;
-                DBG("Digital input %s updated: %g -> %g", name.c_str(), old_value, val.value.real);
+                TRACE(Port, "Digital input %s updated: %g -> %g", name.c_str(), old_value, val.value.real);
             }
         }
         else {
@@ -296,12 +523,12 @@ void AnalogDigitalInterface::digital_input_update(vpiHandle handle) {
 
             double new_value = digital_to_analog(val.value.integer);
             double old_value = it->second.value;
-            DBG("Digital Z input %s : %g -> %g", name.c_str(), old_value, new_value);
+            TRACE(Port, "Digital Z input %s : %g -> %g", name.c_str(), old_value, new_value);
 
             if (std::abs(old_value - new_value) > config_->min_analog_change_threshold) {
                 it->second.value = new_value;
                 it->second.changed = true;
-                DBG("Digital input %s updated: %g -> %g", name.c_str(), old_value, new_value);
+                TRACE(Port, "Digital input %s updated: %g -> %g", name.c_str(), old_value, new_value);
             }
         }
         else {
@@ -328,12 +555,12 @@ void AnalogDigitalInterface::digital_input_update(vpiHandle handle) {
 
                     double new_analog_value = digital_to_analog(bit_val.value.integer);
                     double old_value = it->second.value;
-                    DBG("Digital Y input %s : %g -> %g", indexed_name.c_str(), old_value, new_analog_value);
+                    TRACE(Port, "Digital Y input %s : %g -> %g", indexed_name.c_str(), old_value, new_analog_value);
 
                     if (std::abs(old_value - new_analog_value) > config_->min_analog_change_threshold) {
                         it->second.value = new_analog_value;
                         it->second.changed = true;
-                        DBG("Digital input %s updated: %g -> %g", indexed_name.c_str(), old_value, new_analog_value);
+                        TRACE(Port, "Digital input %s updated: %g -> %g", indexed_name.c_str(), old_value, new_analog_value);
                     }
                 }
                 else {
@@ -357,19 +584,60 @@ auto AnalogDigitalInterface::get_analog_input_names() const -> std::vector<std::
     return names;
 }
 
+auto AnalogDigitalInterface::get_analog_output_names() const -> std::vector<std::string> {
+    std::lock_guard<std::mutex> lock(outputs_mutex_);
+    std::vector<std::string> names;
+    names.reserve(analog_outputs_.size());
+    for (const auto &[name, port_info] : analog_outputs_) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+auto AnalogDigitalInterface::get_port_vectors() const -> std::vector<std::pair<std::string, std::string>> {
+    std::vector<std::pair<std::string, std::string>> ports;
+    {
+        std::lock_guard<std::mutex> lock(inputs_mutex_);
+        for (const auto &[name, port_info] : analog_inputs_) {
+            ports.emplace_back(port_info.name, "v(" + name + ")");
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(outputs_mutex_);
+        for (const auto &[name, port_info] : analog_outputs_) {
+            ports.emplace_back(port_info.name, name);
+        }
+    }
+    std::sort(ports.begin(), ports.end());
+    return ports;
+}
+
+auto AnalogDigitalInterface::source_requests() const -> std::vector<std::pair<std::string, unsigned long long>> {
+    std::lock_guard<std::mutex> lock(inputs_mutex_);
+    std::vector<std::pair<std::string, unsigned long long>> requests;
+    for (const auto &[name, port_info] : analog_inputs_) {
+        requests.emplace_back(port_info.name, port_info.requests);
+    }
+    std::sort(requests.begin(), requests.end());
+    if (unknown_source_requests_ != 0) {
+        requests.emplace_back(std::string(), unknown_source_requests_);
+    }
+    return requests;
+}
+
 void AnalogDigitalInterface::print_status() const {
     {
         std::lock_guard<std::mutex> lock(inputs_mutex_);
-        DBG("=== Analog Inputs (Digital->Analog) ===");
+        TRACE(General, "=== Analog Inputs (Digital->Analog) ===");
         for (const auto &[name, port_info] : analog_inputs_) {
-            DBG("  %s: value=%g, changed=%d, type=%d", name.c_str(), port_info.value, port_info.changed, port_info.net_type);
+            TRACE(General, "  %s: value=%g, changed=%d, type=%d", name.c_str(), port_info.value, port_info.changed, port_info.net_type);
         }
     }
     {
         std::lock_guard<std::mutex> lock(outputs_mutex_);
-        DBG("=== Analog Outputs (Analog->Digital) ===");
+        TRACE(General, "=== Analog Outputs (Analog->Digital) ===");
         for (const auto &[name, port_info] : analog_outputs_) {
-            DBG("  %s: value=%g, changed=%d, type=%d", name.c_str(), port_info.value, port_info.changed, port_info.net_type);
+            TRACE(General, "  %s: value=%g, changed=%d, type=%d", name.c_str(), port_info.value, port_info.changed, port_info.net_type);
         }
     }
 }
@@ -4,13 +4,20 @@
 #include "ngspice/sharedspice.h"
 #include "vpi_user.h"
 #include "Config.h"
+#include "NgSpiceLibrary.h"
+#include "SurrogateModel.h"
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <mutex>
 
 namespace spice_vpi {
 
+class OutputRecorder;
+
 /**
  * @brief Manages the interface between analog (SPICE) and digital (HDL) signals
  * 
@@ -21,6 +28,25 @@ namespace spice_vpi {
  * - Synchronization between SPICE and HDL simulators
  */
 class AnalogDigitalInterface {
+public:
+    /**
+     * @brief How a port was bound to the SPICE netlist
+     */
+    enum class PortBinding {
+        Unbound,  // port could not be bound
+        Analog,   // input change rolls the SPICE step back to the change time
+        NoRedo,   // 1-bit input applied at the next SPICE step, without rolling the step back
+    };
+
+    /**
+     * @brief Divergence of one corner output from the driving netlist
+     */
+    struct OutputDivergence {
+        unsigned long long count = 0;       // number of times the output started to differ
+        unsigned long long first_time = 0;  // HDL time of the first difference
+        bool active = false;                // output currently differs
+    };
+
 private:
     struct PortInfo {
         std::string name;          // Full name (e.g., "clk" or "data[0]")
@@ -33,6 +59,8 @@ private:
         int bit_index;             // Bit index for vector elements (-1 for scalar)
         double value;              // Current value
         bool changed;              // Change flag
+        bool event;                // Output driven by an XSPICE event node instead of a vector
+        unsigned long long requests;  // Values requested by ngspice for this input source
 
         PortInfo();
         PortInfo(const PortInfo &other);
@@ -44,31 +72,53 @@ private:
     // Separate storage for inputs and outputs for faster access
     std::unordered_map<std::string, PortInfo> analog_inputs_;  // Digital -> Analog (digital drives analog)
     std::unordered_map<std::string, PortInfo> analog_outputs_; // Analog -> Digital (analog drives digital)
+    std::unordered_map<int, std::string> event_outputs_;       // XSPICE node index -> analog_outputs_ key
+    unsigned long long unknown_source_requests_ = 0;           // requests for sources without a bound input
 
     // Thread safety
     mutable std::mutex inputs_mutex_;
     mutable std::mutex outputs_mutex_;
 
+    // Corner outputs that differed from the driving netlist, by port name
+    std::map<std::string, OutputDivergence> divergences_;
+
     // Configuration reference
     const Config::Settings* config_;
 
+    // ngspice instance the analog outputs are read from
+    NgSpiceLibrary* ngspice_;
+
+    // records the values written to the HDL (SPICE_RECORD_OUTPUTS), may be null
+    OutputRecorder* output_recorder_ = nullptr;
+
+    // characterised table evaluated instead of ngspice (SPICE_SURROGATE), may be null
+    std::unique_ptr<SurrogateModel> surrogate_;
+    std::vector<PortInfo*> surrogate_inputs_;   // bound port of each table input
+    std::vector<PortInfo*> surrogate_outputs_;  // bound port of each table output
+    std::vector<double> surrogate_in_;
+    std::vector<double> surrogate_values_;
+    std::vector<double> surrogate_delays_;
+
     // Utility functions
     double digital_to_analog(int digital_value) const;
     int analog_to_digital(double analog_value) const;
     static std::string create_indexed_name(const std::string &base_name, int index) ;
+    bool is_no_redo_input(const std::string &name, const std::string &port_name) const;
 
 public:
     /**
      * @brief Constructor
      * @param config Configuration settings to use for signal conversion
+     * @param ngspice ngspice instance to read analog outputs from
      */
-    explicit AnalogDigitalInterface(const Config::Settings& config);
+    AnalogDigitalInterface(const Config::Settings& config, NgSpiceLibrary& ngspice);
 
     /**
      * @brief Add a port to be managed by this interface
      * @param port VPI handle to the port
+     * @return How the port was bound (NoRedo for 1-bit inputs listed in SPICE_NO_REDO_INPUTS)
      */
-    void add_port(vpiHandle port);
+    PortBinding add_port(vpiHandle port);
 
     /**
      * @brief Set analog input value (from digital side)
@@ -77,15 +127,96 @@ public:
      */
     void set_analog_input(const char* name, double *value);
 
+    /**
+     * @brief Read an analog input value without counting it as a source request
+     * @param name Port name
+     * @param value Receives the analog value, left unchanged for unknown ports
+     */
+    void get_analog_input(const char* name, double *value) const;
+
     /**
      * @brief Update analog output values from SPICE
      */
     void analog_outputs_update();
 
+    /**
+     * @brief Check if a logic output is near its thresholds (SPICE_ADAPTIVE)
+     *
+     * Reads the latest SPICE values; real-valued and event-bound outputs have
+     * no thresholds and are not checked.
+     *
+     * @param margin Volts below the low and above the high threshold counted as near
+     */
+    bool outputs_near_threshold(double margin) const;
+
+    /**
+     * @brief Bind an output to an XSPICE event node of the same name
+     *
+     * Bound outputs are no longer read from ngspice vectors each step; their
+     * value changes arrive through event_output_update().
+     *
+     * @param index Event node index
+     * @param node Event node name
+     * @param type Event node type, only digital ("d") nodes are bound
+     * @return true if an output was bound
+     */
+    bool bind_event_output(int index, const char *node, const char *type);
+
+    /**
+     * @brief Update an event-bound output from its node state
+     * @param index Event node index
+     * @param state XSPICE digital state string ("0s", "1r", "Uz", ...)
+     */
+    void event_output_update(int index, const char *state);
+
     /**
      * @brief Set digital output values (to digital side)
+     * @return Number of outputs written to the HDL
+     */
+    size_t set_digital_output();
+
+    /**
+     * @brief Record every value set_digital_output() writes
+     * @param recorder Recorder, or null to stop recording
+     */
+    void set_output_recorder(OutputRecorder *recorder);
+
+    /**
+     * @brief Evaluate a characterised table in place of ngspice
+     *
+     * Every table input and output must be a bound port; the ports of the
+     * instance not in the table are left alone.
+     *
+     * @param model Table from spicebind_characterize
+     * @throws std::runtime_error if a table port is not bound
+     */
+    void set_surrogate(std::unique_ptr<SurrogateModel> model);
+
+    /**
+     * @brief Evaluate the surrogate for the current inputs and schedule the outputs
+     *
+     * Outputs are written with an inertial delay of their table delay, so a
+     * newer evaluation replaces a value that has not been applied yet.
+     *
+     * @return Number of outputs scheduled
+     */
+    size_t surrogate_update();
+
+    /**
+     * @brief Compare outputs against the driving netlist instead of driving the HDL
+     *
+     * Used for corner partitions. Digital outputs diverge when their logic
+     * levels differ, real outputs when they differ by more than the corner tolerance.
+     *
+     * @param reference Interface of the partition driving the HDL outputs
+     * @param time Current HDL time
      */
-    void set_digital_output();
+    void compare_digital_output(const AnalogDigitalInterface &reference, unsigned long long time);
+
+    /**
+     * @brief Outputs that diverged from the driving netlist so far
+     */
+    std::map<std::string, OutputDivergence> divergences() const;
 
     /**
      * @brief Update when digital input changes (called from VPI callback)
@@ -99,6 +230,24 @@ public:
      */
     std::vector<std::string> get_analog_input_names() const;
 
+    /**
+     * @brief Get the ngspice vectors read for the outputs (e.g. "v(out)")
+     */
+    std::vector<std::string> get_analog_output_names() const;
+
+    /**
+     * @brief Get the bound ports with the ngspice vector carrying their voltage
+     * @return (port name, vector) pairs, e.g. ("tb.dut.a", "v(tb.dut.a)")
+     */
+    std::vector<std::pair<std::string, std::string>> get_port_vectors() const;
+
+    /**
+     * @brief Values requested by ngspice per input source since the ports were bound
+     * @return (port name, count) pairs in port name order; sources without a bound
+     *         input are counted under an empty name
+     */
+    std::vector<std::pair<std::string, unsigned long long>> source_requests() const;
+
     /**
      * @brief Print debug status information
      */
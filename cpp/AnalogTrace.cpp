@@ -0,0 +1,394 @@
+#include "AnalogTrace.h"
+#include "Debug.h"
+#include "WaveformStream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef SPICEBIND_HAVE_FST
+#include "fstapi.h"
+#endif
+
+namespace spice_vpi {
+
+class TraceSink {
+public:
+    virtual ~TraceSink() = default;
+    virtual void push_scope(const std::string &name) = 0;
+    virtual void pop_scope() = 0;
+    virtual auto add_var(const std::string &name) -> uint32_t = 0;
+    virtual void end_declarations() = 0;
+    virtual void time(unsigned long long ticks) = 0;
+    virtual void value(uint32_t handle, double value) = 0;
+    virtual auto close() -> bool = 0;  // false on write error
+};
+
+namespace {
+
+// HDL time precision (ticks per second) as a power of ten, e.g. -12 for 1 ps
+auto timescale_exponent(unsigned long long time_precision) -> int {
+    return -static_cast<int>(std::lround(std::log10(static_cast<double>(std::max(time_precision, 1ULL)))));
+}
+
+class VcdSink : public TraceSink {
+public:
+    VcdSink(const std::string &file_name, unsigned long long time_precision) {
+        file_ = std::fopen(file_name.c_str(), "w");
+        if (file_ == nullptr) {
+            throw std::runtime_error("cannot create trace file " + file_name);
+        }
+        std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+        static const char *const units[] = {"s", "ms", "us", "ns", "ps", "fs"};
+        int exponent = std::min(0, std::max(-15, timescale_exponent(time_precision)));
+        int unit = (-exponent + 2) / 3;
+        int multiplier = (exponent + 3 * unit == 2) ? 100 : (exponent + 3 * unit == 1) ? 10 : 1;
+        std::fprintf(file_, "$version spicebind $end\n$timescale %d%s $end\n", multiplier, units[unit]);
+    }
+
+    ~VcdSink() override {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+
+    void push_scope(const std::string &name) override {
+        std::fprintf(file_, "$scope module %s $end\n", name.c_str());
+    }
+
+    void pop_scope() override {
+        std::fprintf(file_, "$upscope $end\n");
+    }
+
+    auto add_var(const std::string &name) -> uint32_t override {
+        auto handle = static_cast<uint32_t>(codes_.size());
+        codes_.push_back(identifier(handle));
+        std::fprintf(file_, "$var real 64 %s %s $end\n", codes_.back().c_str(), name.c_str());
+        return handle;
+    }
+
+    void end_declarations() override {
+        std::fprintf(file_, "$enddefinitions $end\n");
+    }
+
+    void time(unsigned long long ticks) override {
+        std::fprintf(file_, "#%llu\n", ticks);
+    }
+
+    void value(uint32_t handle, double value) override {
+        std::fprintf(file_, "r%.9g %s\n", value, codes_[handle].c_str());
+    }
+
+    auto close() -> bool override {
+        bool ok = std::ferror(file_) == 0;
+        ok = (std::fclose(file_) == 0) && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+private:
+    FILE *file_ = nullptr;
+    std::vector<std::string> codes_;
+
+    // short printable VCD identifier codes: !, ", ..., ~, !!, ...
+    static auto identifier(uint32_t index) -> std::string {
+        std::string code;
+        do {
+            code += static_cast<char>('!' + index % 94);
+            index /= 94;
+        } while (index != 0);
+        return code;
+    }
+};
+
+#ifdef SPICEBIND_HAVE_FST
+class FstSink : public TraceSink {
+public:
+    FstSink(const std::string &file_name, unsigned long long time_precision) {
+        ctx_ = fstWriterCreate(file_name.c_str(), 1);
+        if (ctx_ == nullptr) {
+            throw std::runtime_error("cannot create trace file " + file_name);
+        }
+        fstWriterSetPackType(ctx_, FST_WR_PT_LZ4);
+        fstWriterSetFileType(ctx_, FST_FT_VERILOG);
+        fstWriterSetTimescale(ctx_, timescale_exponent(time_precision));
+        fstWriterSetVersion(ctx_, "spicebind");
+    }
+
+    ~FstSink() override {
+        close();
+    }
+
+    void push_scope(const std::string &name) override {
+        fstWriterSetScope(ctx_, FST_ST_VCD_MODULE, name.c_str(), nullptr);
+    }
+
+    void pop_scope() override {
+        fstWriterSetUpscope(ctx_);
+    }
+
+    auto add_var(const std::string &name) -> uint32_t override {
+        return fstWriterCreateVar(ctx_, FST_VT_VCD_REAL, FST_VD_IMPLICIT, 8, name.c_str(), 0);
+    }
+
+    void end_declarations() override {}
+
+    void time(unsigned long long ticks) override {
+        fstWriterEmitTimeChange(ctx_, ticks);
+    }
+
+    void value(uint32_t handle, double value) override {
+        fstWriterEmitValueChange(ctx_, handle, &value);
+    }
+
+    auto close() -> bool override {
+        if (ctx_ != nullptr) {
+            fstWriterClose(ctx_);
+            ctx_ = nullptr;
+        }
+        return true;
+    }
+
+private:
+    void *ctx_ = nullptr;
+};
+#endif
+
+// "tb.dut" -> {"tb", "dut"}
+auto split_scope(const std::string &scope) -> std::vector<std::string> {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= scope.size() && !scope.empty()) {
+        size_t dot = scope.find('.', start);
+        if (dot == std::string::npos) {
+            dot = scope.size();
+        }
+        if (dot > start) {
+            parts.push_back(scope.substr(start, dot - start));
+        }
+        start = dot + 1;
+    }
+    return parts;
+}
+
+} // namespace
+
+AnalogTrace::AnalogTrace(const std::string &file_name, unsigned long long time_precision, double tolerance)
+    : file_name_(file_name), time_precision_(time_precision), tolerance_(tolerance) {
+    if (is_vcd_file(file_name_)) {
+        sink_ = std::make_unique<VcdSink>(file_name_, time_precision_);
+    } else {
+#ifdef SPICEBIND_HAVE_FST
+        sink_ = std::make_unique<FstSink>(file_name_, time_precision_);
+#else
+        throw std::runtime_error("spicebind was built without FST support, cannot write " + file_name_);
+#endif
+    }
+    pending_.reserve(CHUNK_CHANGES);
+    writer_ = std::thread(&AnalogTrace::writer, this);
+}
+
+AnalogTrace::~AnalogTrace() {
+    close();
+}
+
+auto AnalogTrace::file_name() const -> const std::string & {
+    return file_name_;
+}
+
+auto AnalogTrace::is_vcd_file(const std::string &file_name) -> bool {
+    const std::string suffix = ".vcd";
+    if (file_name.size() < suffix.size()) {
+        return false;
+    }
+    std::string end = file_name.substr(file_name.size() - suffix.size());
+    std::transform(end.begin(), end.end(), end.begin(), ::tolower);
+    return end == suffix;
+}
+
+void AnalogTrace::add_signal(const std::string &scope, const std::string &name, const std::string &vector) {
+    Signal signal;
+    signal.scope = split_scope(scope);
+    signal.name = name;
+    signal.vector = vector;
+    std::transform(signal.vector.begin(), signal.vector.end(), signal.vector.begin(), ::tolower);
+    signals_.push_back(std::move(signal));
+}
+
+void AnalogTrace::begin_plot(pvecinfoall info) {
+    if (info == nullptr) {
+        return;
+    }
+
+    scale_index_ = -1;
+    for (Signal &signal : signals_) {
+        signal.index = -1;
+    }
+    for (int i = 0; i < info->veccount; ++i) {
+        std::string name = raw_vector_name(info->vecs[i]->vecname);
+        if (name == "time") {
+            scale_index_ = i;
+            continue;
+        }
+        std::string plain = info->vecs[i]->vecname;
+        std::transform(plain.begin(), plain.end(), plain.begin(), ::tolower);
+        for (Signal &signal : signals_) {
+            if (signal.vector == name || signal.vector == plain) {
+                signal.index = i;
+            }
+        }
+    }
+
+    for (const Signal &signal : signals_) {
+        if (signal.index < 0 && scale_index_ >= 0) {
+            TRACE(General, "Traced vector %s is not saved by ngspice", signal.vector.c_str());
+        }
+    }
+}
+
+void AnalogTrace::add_point(pvecvaluesall values) {
+    if (values == nullptr || scale_index_ < 0 || scale_index_ >= values->veccount) {
+        return;
+    }
+
+    // SendData reports accepted points only, keep the HDL timeline monotonic anyway
+    auto ticks = static_cast<unsigned long long>(std::llround(std::max(0.0, values->vecsa[scale_index_]->creal) * static_cast<double>(time_precision_)));
+    ticks = std::max(ticks, last_time_);
+    last_time_ = ticks;
+
+    for (size_t id = 0; id < signals_.size(); ++id) {
+        Signal &signal = signals_[id];
+        if (signal.index < 0 || signal.index >= values->veccount) {
+            continue;
+        }
+        signal.current = values->vecsa[signal.index]->creal;
+        if (!signal.written || std::abs(signal.current - signal.last) > tolerance_) {
+            pending_.push_back(Change{ticks, static_cast<uint32_t>(id), signal.current});
+            signal.last = signal.current;
+            signal.written = true;
+        }
+    }
+
+    if (pending_.size() >= CHUNK_CHANGES) {
+        push(std::move(pending_));
+        pending_ = std::vector<Change>();
+        pending_.reserve(CHUNK_CHANGES);
+    }
+}
+
+void AnalogTrace::push(std::vector<Change> chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // bounded queue: the ngspice thread waits for a slow disk instead of growing memory
+    cv_.wait(lock, [this] { return queue_.size() < MAX_QUEUED_CHUNKS || closing_; });
+    queue_.push_back(std::move(chunk));
+    cv_.notify_all();
+}
+
+void AnalogTrace::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+    }
+
+    // values that settled within the tolerance end at their final value
+    for (size_t id = 0; id < signals_.size(); ++id) {
+        Signal &signal = signals_[id];
+        if (signal.written && signal.current != signal.last) {
+            pending_.push_back(Change{last_time_, static_cast<uint32_t>(id), signal.current});
+            signal.last = signal.current;
+        }
+    }
+    if (!pending_.empty()) {
+        push(std::move(pending_));
+        pending_ = std::vector<Change>();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+        cv_.notify_all();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void AnalogTrace::writer() {
+    bool header_written = false;
+    bool has_time = false;
+    unsigned long long time = 0;
+
+    while (true) {
+        std::vector<Change> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !queue_.empty() || closing_; });
+            if (queue_.empty()) {
+                break;
+            }
+            chunk = std::move(queue_.front());
+            queue_.pop_front();
+            cv_.notify_all();
+        }
+
+        // signals are declared before the run, the header goes out with the first values
+        if (!header_written) {
+            write_header();
+            header_written = true;
+        }
+        for (const Change &change : chunk) {
+            if (!has_time || change.time != time) {
+                sink_->time(change.time);
+                time = change.time;
+                has_time = true;
+            }
+            sink_->value(handles_[change.id], change.value);
+        }
+    }
+
+    if (!header_written) {
+        write_header();
+    }
+    write_error_ = !sink_->close();
+    if (write_error_) {
+        ERROR("Failed to write trace file %s", file_name_.c_str());
+    }
+}
+
+// Declare the signals grouped by scope, each scope opened once
+void AnalogTrace::write_header() {
+    std::vector<size_t> order(signals_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return signals_[a].scope < signals_[b].scope; });
+
+    handles_.assign(signals_.size(), 0);
+    std::vector<std::string> open;
+    for (size_t id : order) {
+        const std::vector<std::string> &scope = signals_[id].scope;
+        size_t common = 0;
+        while (common < open.size() && common < scope.size() && open[common] == scope[common]) {
+            common++;
+        }
+        while (open.size() > common) {
+            sink_->pop_scope();
+            open.pop_back();
+        }
+        while (open.size() < scope.size()) {
+            open.push_back(scope[open.size()]);
+            sink_->push_scope(open.back());
+        }
+        handles_[id] = sink_->add_var(signals_[id].name);
+    }
+    while (!open.empty()) {
+        sink_->pop_scope();
+        open.pop_back();
+    }
+    sink_->end_declarations();
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,125 @@
+#ifndef ANALOG_TRACE_H
+#define ANALOG_TRACE_H
+
+#include "ngspice/sharedspice.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spice_vpi {
+
+class TraceSink;  // FST or VCD output
+
+/**
+ * @brief Writes analog node voltages as real signals in HDL time to an FST (or VCD) file
+ *
+ * Points from the SendData callback are converted to HDL ticks and compressed
+ * by value change: a signal is written only when it moved by more than the
+ * tolerance since its last written value, so flat regions cost nothing.
+ * Changes are collected in chunks and written by a background thread.
+ *
+ * File names ending in ".vcd" are written as plain VCD, anything else as FST
+ * (requires a build with FST support, SPICEBIND_HAVE_FST).
+ */
+class AnalogTrace {
+public:
+    /**
+     * @brief Open the trace file and start the writer thread
+     * @param file_name Output file (".vcd" for VCD, FST otherwise)
+     * @param time_precision HDL time precision in ticks per second
+     * @param tolerance Minimum change in volts before a new value is written
+     * @throws std::runtime_error if the file cannot be created
+     */
+    AnalogTrace(const std::string &file_name, unsigned long long time_precision, double tolerance);
+
+    AnalogTrace(const AnalogTrace &) = delete;
+    AnalogTrace &operator=(const AnalogTrace &) = delete;
+    ~AnalogTrace();
+
+    /**
+     * @brief Declare a traced signal, before the first plot
+     * @param scope Dot-separated scope of the signal (e.g. "tb.dut")
+     * @param name Signal name in the scope
+     * @param vector ngspice vector carrying the value, as "v(node)", "i(source)" or a plain name
+     */
+    void add_signal(const std::string &scope, const std::string &name, const std::string &vector);
+
+    /**
+     * @brief Map the declared signals to the vectors reported by SendInitData
+     */
+    void begin_plot(pvecinfoall info);
+
+    /**
+     * @brief Append one point reported by SendData
+     *
+     * Waits while the writer thread is behind by more than a few chunks.
+     */
+    void add_point(pvecvaluesall values);
+
+    /**
+     * @brief Write the pending changes, stop the writer thread and close the file
+     */
+    void close();
+
+    const std::string &file_name() const;
+
+    /**
+     * @brief Check if a trace file name selects the VCD format
+     */
+    static bool is_vcd_file(const std::string &file_name);
+
+private:
+    struct Signal {
+        std::vector<std::string> scope;
+        std::string name;
+        std::string vector;  // lowercase raw vector name
+        int index = -1;      // vector index of the current plot
+        double last = 0.0;   // last written value
+        double current = 0.0;
+        bool written = false;
+    };
+
+    struct Change {
+        unsigned long long time;
+        uint32_t id;
+        double value;
+    };
+
+    static constexpr size_t CHUNK_CHANGES = 16384;
+    static constexpr size_t MAX_QUEUED_CHUNKS = 4;
+
+    std::string file_name_;
+    unsigned long long time_precision_;
+    double tolerance_;
+    std::unique_ptr<TraceSink> sink_;  // used by the writer thread only
+
+    // producer (ngspice thread) state
+    std::vector<Signal> signals_;
+    int scale_index_ = -1;
+    unsigned long long last_time_ = 0;
+    std::vector<Change> pending_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::vector<Change>> queue_;
+    bool closing_ = false;
+    bool closed_ = false;
+    std::thread writer_;
+
+    // writer thread state
+    std::vector<uint32_t> handles_;  // sink handle per signal
+    bool write_error_ = false;
+
+    void push(std::vector<Change> chunk);
+    void writer();
+    void write_header();
+};
+
+} // namespace spice_vpi
+
+#endif // ANALOG_TRACE_H
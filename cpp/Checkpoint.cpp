@@ -0,0 +1,133 @@
+#include "Checkpoint.h"
+#include "Debug.h"
+#include "CoSimSession.h"
+#include "vpi_user.h"
+#include <cstdio>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace spice_vpi {
+
+static int checkpoint_index_ = 0;
+
+#ifndef _WIN32
+static std::vector<pid_t> checkpoint_children_;
+#endif
+
+static auto checkpoint_calltf(PLI_BYTE8 *user_data) -> PLI_INT32 {
+    auto *session = reinterpret_cast<CoSimSession *>(user_data);
+    vpiHandle systf = vpi_handle(vpiSysTfCall, nullptr);
+
+    int num_children = 1;
+    vpiHandle args = vpi_iterate(vpiArgument, systf);
+    if (args != nullptr) {
+        vpiHandle arg = vpi_scan(args);
+        s_vpi_value arg_val;
+        arg_val.format = vpiIntVal;
+        vpi_get_value(arg, &arg_val);
+        num_children = arg_val.value.integer;
+        vpi_free_object(args);
+    }
+
+    s_vpi_value ret_val;
+    ret_val.format = vpiIntVal;
+    ret_val.value.integer = 0;
+
+#ifdef _WIN32
+    ERROR("$spicebind_checkpoint is not supported on this platform");
+#else
+    s_vpi_time simtime;
+    simtime.type = vpiSimTime;
+    vpi_get_time(nullptr, &simtime);
+    unsigned long long current_time = (simtime.high * (1ULL << 32)) + simtime.low;
+
+    bool remote = false;
+    bool streaming = false;
+    for (const auto &partition : session->partitions()) {
+        remote = remote || partition->ngspice().is_remote();
+        streaming = streaming || partition->waveform_stream() != nullptr || partition->analog_trace() != nullptr;
+    }
+
+    if (num_children < 1) {
+        ERROR("$spicebind_checkpoint: number of children must be positive (got %d)", num_children);
+    } else if (remote) {
+        ERROR("$spicebind_checkpoint: not supported with SPICE_TRANSPORT=server");
+    } else if (streaming) {
+        // the stream and trace writer threads do not survive fork()
+        ERROR("$spicebind_checkpoint: not supported with SPICE_DUMP=stream or SPICE_FST");
+    } else if (!session->pause_spice(current_time)) {
+        ERROR("$spicebind_checkpoint: failed to pause ngspice at t=%llu", current_time);
+    } else {
+        INFO("Checkpoint at t=%llu, forking %d children", current_time, num_children);
+
+        // avoid duplicating buffered output in the children
+        Logger::instance().flush();
+        vpi_flush();
+        std::fflush(nullptr);
+
+        for (int i = 1; i <= num_children; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                // child: nothing to wait for from the parent's checkpoints
+                checkpoint_children_.clear();
+                checkpoint_index_ = i;
+                ret_val.value.integer = i;
+                break;
+            }
+            if (pid < 0) {
+                ERROR("$spicebind_checkpoint: fork failed for child %d", i);
+                break;
+            }
+            checkpoint_children_.push_back(pid);
+        }
+
+        // ngspice has no background thread after fork, start a new one from the paused state
+        session->resume_spice();
+        TRACE(General, "checkpoint index=%d resumed at t=%llu", checkpoint_index_, current_time);
+    }
+#endif
+
+    vpi_put_value(systf, &ret_val, nullptr, vpiNoDelay);
+    return 0;
+}
+
+void register_checkpoint_systf(CoSimSession *session) {
+    s_vpi_systf_data tf_data;
+    tf_data.type = vpiSysFunc;
+    tf_data.sysfunctype = vpiSysFuncInt;
+    tf_data.tfname = "$spicebind_checkpoint";
+    tf_data.calltf = checkpoint_calltf;
+    tf_data.compiletf = nullptr;
+    tf_data.sizetf = nullptr;
+    tf_data.user_data = reinterpret_cast<PLI_BYTE8 *>(session);
+    vpi_register_systf(&tf_data);
+}
+
+auto checkpoint_index() -> int {
+    return checkpoint_index_;
+}
+
+void wait_for_checkpoint_children() {
+#ifndef _WIN32
+    for (pid_t pid : checkpoint_children_) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0) {
+            ERROR("failed to wait for checkpoint child %d", (int)pid);
+            continue;
+        }
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            INFO("Checkpoint child %d finished", (int)pid);
+        } else {
+            ERROR("checkpoint child %d failed with status %d", (int)pid, status);
+        }
+    }
+    checkpoint_children_.clear();
+#endif
+}
+
+} // namespace spice_vpi
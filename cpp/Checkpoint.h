@@ -0,0 +1,51 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "vpi_user.h"
+
+namespace spice_vpi {
+
+class CoSimSession;
+
+/**
+ * @brief Fork-based checkpointing of the whole co-simulation
+ * 
+ * The $spicebind_checkpoint(n) system function quiesces ngspice at the current
+ * HDL time and fork()s n child processes. Each process resumes ngspice from the
+ * shared state, so a common power-up/reset prefix is simulated only once.
+ * 
+ * The function returns 0 in the parent and 1..n in the children, which the
+ * testbench uses to select the test to continue with:
+ * 
+ * @code
+ * integer test_id;
+ * initial begin
+ *     // ... shared reset sequence ...
+ *     test_id = $spicebind_checkpoint(3);
+ *     case (test_id) ...
+ * end
+ * @endcode
+ */
+
+/**
+ * @brief Register the $spicebind_checkpoint system function
+ * @param session Co-simulation session to checkpoint
+ */
+void register_checkpoint_systf(CoSimSession *session);
+
+/**
+ * @brief Checkpoint index of this process
+ * @return 0 in the original process, 1..n in forked children
+ */
+int checkpoint_index();
+
+/**
+ * @brief Wait for all children forked by this process and report their status
+ * 
+ * Called at the end of simulation so the parent finishes after its children.
+ */
+void wait_for_checkpoint_children();
+
+} // namespace spice_vpi
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,412 @@
+#include "CoSimSession.h"
+#include "Checkpoint.h"
+#include "Debug.h"
+#include "NgSpiceRemote.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace spice_vpi {
+
+void CoSimSession::configure(unsigned long long time_precision) {
+    config_ = Config::load_from_environment();
+    config_.time_precision = time_precision;
+
+    Logger::Level log_level = Logger::Level::Spice;
+    Logger::parse_level(config_.log_level, log_level);
+    Logger::instance().configure(log_level, config_.log_file, config_.log_repeat_limit);
+
+    uint32_t trace_categories = 0;
+    Tracer::parse_categories(config_.event_trace, trace_categories);
+    Tracer::configure(trace_categories, config_.event_trace_events);
+    Tracer::name_thread("hdl");
+    TRACE(Barrier, "time precision=%llu", time_precision);  // lets spicebind-trace --chrome convert ticks to seconds
+
+    // the recorded outputs stand in for all partitions, ngspice is never started
+    if (!config_.output_stub.empty()) {
+        output_stub_ = std::make_unique<OutputStub>(config_.output_stub);
+        started_ = true;
+        stopped_ = false;
+        return;
+    }
+
+    surrogate_ = !config_.surrogate_paths.empty();
+    std::vector<Config::Settings> partition_configs = Config::partitions(config_);
+    barrier_.reset(static_cast<int>(partition_configs.size()));
+
+    if (config_.spice_transport != libraries_transport_) {
+        libraries_.clear();
+        links_.clear();
+        libraries_transport_ = config_.spice_transport;
+    }
+
+    // in process the first partition uses the linked libngspice, others need private copies
+    while (libraries_.size() < partition_configs.size()) {
+        if (config_.spice_transport == "server") {
+            libraries_.push_back(NgSpiceRemote::launch(config_.spice_server_path, std::to_string(libraries_.size())));
+        } else if (libraries_.empty()) {
+            libraries_.push_back(NgSpiceLibrary::linked());
+        } else {
+            libraries_.push_back(NgSpiceLibrary::load_copy(std::to_string(libraries_.size())));
+        }
+        links_.push_back(std::make_unique<EngineLink>());
+    }
+
+    for (size_t i = 0; i < partition_configs.size(); ++i) {
+        int engine_id = Barrier::SPICE_ENGINE_ID + static_cast<int>(i);
+        partitions_.push_back(std::make_unique<SpicePartition>(engine_id, partition_configs[i], barrier_, *libraries_[i], *links_[i]));
+    }
+    port_watches_.reserve(2 * partitions_.size());
+    for (const auto &partition : partitions_) {
+        port_watches_.push_back(PortWatch{this, partition.get(), false});
+        port_watches_.push_back(PortWatch{this, partition.get(), true});
+    }
+
+    if (!config_.output_record.empty()) {
+        output_recorder_ = std::make_unique<OutputRecorder>(output_file_name(nullptr, config_.output_record), time_precision);
+        for (const auto &partition : partitions_) {
+            if (!partition->is_corner()) {
+                partition->interface().set_output_recorder(output_recorder_.get());
+            }
+        }
+    }
+
+    started_ = true;
+    stopped_ = false;
+}
+
+auto CoSimSession::start_spice() -> bool {
+    for (const auto &partition : partitions_) {
+        if (config_.dump_mode == "stream") {
+            try {
+                partition->open_waveform_stream(output_file_name(partition.get(), "dump.raw"));
+            } catch (const std::exception &e) {
+                ERROR("%s", e.what());
+                return false;
+            }
+        }
+        if (!config_.trace_file.empty()) {
+            try {
+                partition->open_analog_trace(output_file_name(partition.get(), config_.trace_file));
+            } catch (const std::exception &e) {
+                ERROR("%s", e.what());
+                return false;
+            }
+        }
+        if (!config_.stimulus_record.empty()) {
+            try {
+                partition->open_stimulus_record(output_file_name(partition.get(), config_.stimulus_record));
+            } catch (const std::exception &e) {
+                ERROR("%s", e.what());
+                return false;
+            }
+        }
+        if (!partition->start()) {
+            return false;
+        }
+    }
+    stats_->wall_start = std::chrono::steady_clock::now();
+
+    // wait for the first sync/source callback of every engine instead of a fixed delay
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(config_.spice_startup_timeout));
+    auto start_state = barrier_.wait_for_spice_start(timeout);
+    if (start_state == Barrier::SpiceStartState::Stopped) {
+        ERROR("ngspice stopped before the first time step, check the netlist %s", config_.spice_netlist_path.c_str());
+        return false;
+    }
+    if (start_state != Barrier::SpiceStartState::Ready) {
+        ERROR("ngspice did not start within %g s (SPICE_STARTUP_TIMEOUT)", config_.spice_startup_timeout);
+        for (const auto &partition : partitions_) {
+            partition->halt();
+        }
+        return false;
+    }
+
+    return true;
+}
+
+auto CoSimSession::is_stub() const -> bool {
+    return output_stub_ != nullptr;
+}
+
+auto CoSimSession::start_stub() -> bool {
+    stats_->wall_start = std::chrono::steady_clock::now();
+    return output_stub_->start(config_.time_precision);
+}
+
+auto CoSimSession::is_surrogate() const -> bool {
+    return surrogate_;
+}
+
+auto CoSimSession::start_surrogate() -> bool {
+    for (const auto &partition : partitions_) {
+        const std::string &path = partition->config().surrogate_path;
+        try {
+            auto model = std::make_unique<SurrogateModel>(SurrogateModel::load(path));
+            for (const SurrogateModel::Output &output : model->outputs()) {
+                INFO("Surrogate %s: output %s max error %g V, %llu logic mismatches in validation, delay up to %g s", path.c_str(),
+                     output.name.c_str(), output.max_error, output.mismatches, output.max_delay);
+            }
+            partition->interface().set_surrogate(std::move(model));
+        } catch (const std::exception &e) {
+            ERROR("%s", e.what());
+            return false;
+        }
+        partition->interface().update_all_digital_inputs();
+        partition->stats().output_events.add(partition->interface().surrogate_update());
+    }
+    stats_->wall_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+auto CoSimSession::output_recorder() const -> OutputRecorder * {
+    return output_recorder_.get();
+}
+
+auto CoSimSession::pause_spice(unsigned long long current_time) -> bool {
+    // the engines may already have accepted steps up to the HDL time in the barrier
+    const unsigned long long pause_time = std::max(current_time, barrier_.get_time(Barrier::HDL_ENGINE_ID));
+
+    // roll the pending steps back to the pause time (same as an input change),
+    // ng_sync then stops each analysis once it has accepted its step there
+    for (const auto &partition : partitions_) {
+        if (partition->ngspice().running()) {
+            partition->request_pause(pause_time);
+            barrier_.update_no_wait(partition->engine_id(), pause_time);
+            barrier_.set_needs_redo(true, partition->engine_id());
+        }
+    }
+    // one tick ahead as after a timestep, so an engine that had already accepted
+    // its step at the pause time can take the one step it needs to pause
+    barrier_.update_no_wait(Barrier::HDL_ENGINE_ID, pause_time + 1);
+
+    // the background threads end at their breakpoints, allow as long as the startup
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(config_.spice_startup_timeout));
+    if (!barrier_.wait_for_spice_halt(timeout) && !barrier_.is_shutdown()) {
+        WARN("ngspice did not pause within %g s (SPICE_STARTUP_TIMEOUT)", config_.spice_startup_timeout);
+    }
+
+    bool paused = true;
+    for (const auto &partition : partitions_) {
+        partition->clear_pause();
+        if (partition->ngspice().running()) {
+            paused = false;
+        } else {
+            // joins the background thread that ended at the breakpoint
+            partition->halt();
+        }
+    }
+    TRACE(Sync, "pause at pause_time=%llu current_time=%llu paused=%d", pause_time, current_time, paused);
+    return paused;
+}
+
+void CoSimSession::resume_spice() {
+    for (const auto &partition : partitions_) {
+        barrier_.set_spice_running(true, partition->engine_id());
+        partition->ngspice().command("bg_resume");
+    }
+}
+
+void CoSimSession::apply_adaptive_tolerances(unsigned long long current_time) {
+    bool needs_switch = false;
+    for (const auto &partition : partitions_) {
+        needs_switch = needs_switch || partition->adaptive().needs_switch();
+    }
+    if (!needs_switch) {
+        return;
+    }
+
+    if (!pause_spice(current_time)) {
+        WARN("Adaptive tolerances: failed to pause ngspice at t=%llu, keeping the current tolerances", current_time);
+        resume_spice();
+        return;
+    }
+    for (const auto &partition : partitions_) {
+        if (partition->adaptive().needs_switch()) {
+            std::string command = partition->adaptive().apply();
+            TRACE(General, "engine=%d t=%llu %s", partition->engine_id(), current_time, command.c_str());
+            partition->ngspice().command(command);
+        }
+    }
+    resume_spice();
+}
+
+void CoSimSession::stop() {
+    if (stopped_) {
+        return;
+    }
+    stopped_ = true;
+
+    const unsigned long long hdl_time = barrier_.get_time(Barrier::HDL_ENGINE_ID);
+    const double end_time = static_cast<double>(hdl_time) / static_cast<double>(config_.time_precision);
+
+    // pause where the HDL side ended so the waveforms do not run past it
+    if (!surrogate_ && !barrier_.is_shutdown()) {
+        pause_spice(hdl_time);
+    }
+    barrier_.shutdown();
+
+    // surrogate partitions never started ngspice
+    if (!surrogate_) {
+        for (const auto &partition : partitions_) {
+            if (partition->ngspice().running()) {
+                partition->halt();
+            }
+            partition->close_analog_trace();
+            partition->close_stimulus_record(end_time);
+            if (config_.dump_mode == "stream") {
+                partition->close_waveform_stream();
+            } else if (config_.dump_mode == "raw") {
+                partition->write(output_file_name(partition.get(), "dump.raw"));
+            }
+        }
+    }
+    if (output_recorder_ != nullptr) {
+        output_recorder_->close();
+    }
+    if (output_stub_ != nullptr) {
+        output_stub_->finish();
+    }
+
+    if (!config_.event_trace.empty()) {
+        std::string trace_file = output_file_name(nullptr, config_.event_trace_file);
+        if (Tracer::write(trace_file)) {
+            INFO("Trace written to %s, decode with spicebind-trace", trace_file.c_str());
+        } else {
+            ERROR("Failed to write trace file %s", trace_file.c_str());
+        }
+    }
+}
+
+// file_name with a per-partition and per-checkpoint suffix, e.g. dump.raw -> dump_ff.raw
+// (no partition suffix for files of the whole session)
+auto CoSimSession::output_file_name(const SpicePartition *partition, const std::string &file_name) const -> std::string {
+    size_t dot = file_name.rfind('.');
+    size_t slash = file_name.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        dot = file_name.size();
+    }
+    std::string name = file_name.substr(0, dot);
+    if (partition != nullptr && partition->is_corner()) {
+        name += "_" + partition->config().corner_name;
+    } else if (partition != nullptr && config_.spice_netlist_paths.size() > 1) {
+        name += "_" + partition->config().hdl_instance_names.front();
+    }
+    if (checkpoint_index() != 0) {
+        name += "_" + std::to_string(checkpoint_index());
+    }
+    return name + file_name.substr(dot);
+}
+
+void CoSimSession::report_stats(unsigned long long hdl_time) {
+    StatsReport report = StatsReport::collect(*this, hdl_time, stopped_);
+    report.print();
+    if (!config_.stats_file.empty()) {
+        std::string stats_file = output_file_name(nullptr, config_.stats_file);
+        if (!report.write_json(stats_file)) {
+            ERROR("Failed to write stats file %s", stats_file.c_str());
+        }
+    }
+}
+
+void CoSimSession::report_corners() const {
+    for (const auto &partition : partitions_) {
+        if (!partition->is_corner()) {
+            continue;
+        }
+
+        auto divergences = partition->interface().divergences();
+        if (divergences.empty()) {
+            INFO("Corner %s: outputs match the driving netlist", partition->config().corner_name.c_str());
+            continue;
+        }
+        for (const auto &[name, divergence] : divergences) {
+            WARN("Corner %s: output %s diverged %llu time(s), first at %g s",
+                       partition->config().corner_name.c_str(), name.c_str(), divergence.count,
+                       static_cast<double>(divergence.first_time) / static_cast<double>(config_.time_precision));
+        }
+    }
+}
+
+void CoSimSession::reset() {
+    if (started_) {
+        stop();
+    }
+
+    for (vpiHandle cb_handle : port_cb_handles_) {
+        vpi_remove_cb(cb_handle);
+    }
+    port_cb_handles_.clear();
+    if (next_time_cb_handle_ != nullptr) {
+        vpi_remove_cb(next_time_cb_handle_);
+        next_time_cb_handle_ = nullptr;
+    }
+    add_ngspice_timestep_ = false;
+    stats_ = std::make_unique<SessionStats>();
+
+    // keep libngspice loaded, drop the circuits and their vectors
+    for (const auto &partition : partitions_) {
+        if (!surrogate_) {
+            partition->remove_circuit();
+        }
+    }
+    port_watches_.clear();
+    partitions_.clear();
+    output_recorder_.reset();
+    output_stub_.reset();
+
+    barrier_.reset();
+    config_ = Config::Settings();
+
+    started_ = false;
+    stopped_ = false;
+    surrogate_ = false;
+}
+
+auto CoSimSession::has_started() const -> bool {
+    return started_;
+}
+
+auto CoSimSession::barrier() -> Barrier & {
+    return barrier_;
+}
+
+auto CoSimSession::config() const -> const Config::Settings & {
+    return config_;
+}
+
+auto CoSimSession::partitions() const -> const std::vector<std::unique_ptr<SpicePartition>> & {
+    return partitions_;
+}
+
+auto CoSimSession::stats() -> SessionStats & {
+    return *stats_;
+}
+
+auto CoSimSession::port_watch(size_t index, bool no_redo) -> PortWatch * {
+    return &port_watches_.at(2 * index + (no_redo ? 1 : 0));
+}
+
+void CoSimSession::track_port_callback(vpiHandle cb_handle) {
+    if (cb_handle != nullptr) {
+        port_cb_handles_.push_back(cb_handle);
+    }
+}
+
+auto CoSimSession::add_ngspice_timestep() const -> bool {
+    return add_ngspice_timestep_;
+}
+
+void CoSimSession::set_add_ngspice_timestep(bool add) {
+    add_ngspice_timestep_ = add;
+}
+
+auto CoSimSession::next_time_cb_handle() const -> vpiHandle {
+    return next_time_cb_handle_;
+}
+
+void CoSimSession::set_next_time_cb_handle(vpiHandle handle) {
+    next_time_cb_handle_ = handle;
+}
+
+} // namespace spice_vpi
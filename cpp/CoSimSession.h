@@ -0,0 +1,190 @@
+#ifndef CO_SIM_SESSION_H
+#define CO_SIM_SESSION_H
+
+#include "TimeBarrier.h"
+#include "Config.h"
+#include "NgSpiceLibrary.h"
+#include "OutputStub.h"
+#include "SpicePartition.h"
+#include "Stats.h"
+#include "vpi_user.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spice_vpi {
+
+class CoSimSession;
+
+/**
+ * @brief User data of the input value-change callbacks of one partition
+ */
+struct PortWatch {
+    CoSimSession *session;
+    SpicePartition *partition;
+    bool no_redo;  // inputs applied at the next SPICE step without a redo
+};
+
+/**
+ * @brief State and lifecycle of one HDL/SPICE co-simulation
+ *
+ * Owns the time barrier, configuration, SPICE partitions and the ngspice
+ * lifecycle. Each partition runs its own ngspice library instance; the
+ * libraries are loaded once per process. A session that has run can be reset
+ * (halt, remcirc, destroy plots) and started again, so back-to-back
+ * simulations in one process reuse the loaded libraries.
+ *
+ * The session is passed as user data to the VPI callbacks.
+ */
+class CoSimSession {
+public:
+    using Barrier = TimeBarrier<unsigned long long>;
+
+    CoSimSession() = default;
+    CoSimSession(const CoSimSession &) = delete;
+    CoSimSession &operator=(const CoSimSession &) = delete;
+
+    /**
+     * @brief Load configuration from the environment and create the partitions
+     * @param time_precision HDL time precision in ticks per second
+     * @throws std::exception if the configuration is invalid or ngspice cannot be loaded
+     */
+    void configure(unsigned long long time_precision);
+
+    /**
+     * @brief Start all partitions and wait for their first time step
+     * @return false on error (already reported)
+     */
+    bool start_spice();
+
+    /**
+     * @brief Check if recorded outputs replace ngspice (SPICE_STUB_OUTPUTS)
+     */
+    bool is_stub() const;
+
+    /**
+     * @brief Start replaying the recorded outputs instead of ngspice
+     * @return false on error (already reported)
+     */
+    bool start_stub();
+
+    /**
+     * @brief Check if characterised tables replace ngspice (SPICE_SURROGATE)
+     */
+    bool is_surrogate() const;
+
+    /**
+     * @brief Load the table of each partition and drive the initial outputs from it
+     * @return false on error (already reported)
+     */
+    bool start_surrogate();
+
+    /**
+     * @brief Recorder of the outputs and inputs (SPICE_RECORD_OUTPUTS), or null
+     */
+    OutputRecorder *output_recorder() const;
+
+    /**
+     * @brief Bring all ngspice partitions to a paused state at the given HDL time
+     *
+     * The pending steps are rolled back to the current time (as for an input
+     * change) and each engine pauses itself once it has accepted its step
+     * there, without running ahead of the HDL side.
+     *
+     * @param current_time HDL time in simulator ticks
+     * @return false if an engine is still running
+     */
+    bool pause_spice(unsigned long long current_time);
+
+    /**
+     * @brief Continue the partitions paused by pause_spice()
+     */
+    void resume_spice();
+
+    /**
+     * @brief Switch the solver tolerances of partitions whose activity changed (SPICE_ADAPTIVE)
+     *
+     * ngspice reads reltol and abstol when its analysis resumes, so all
+     * partitions are paused for the switch.
+     *
+     * @param current_time HDL time in simulator ticks
+     */
+    void apply_adaptive_tolerances(unsigned long long current_time);
+
+    /**
+     * @brief Stop the co-simulation: pause ngspice at the HDL time, release the barrier and write waveforms
+     */
+    void stop();
+
+    /**
+     * @brief Print the outputs of each corner that diverged from the driving netlist
+     */
+    void report_corners() const;
+
+    /**
+     * @brief Print the performance counters and write them to SPICE_STATS_JSON
+     *
+     * The ngspice history is included once the session has stopped.
+     *
+     * @param hdl_time Current HDL time in simulator ticks
+     */
+    void report_stats(unsigned long long hdl_time);
+
+    /**
+     * @brief Remove the circuits and reset all state so the session can be configured again
+     */
+    void reset();
+
+    /**
+     * @brief Check if the session has been configured since the last reset
+     */
+    bool has_started() const;
+
+    Barrier &barrier();
+    const Config::Settings &config() const;
+    const std::vector<std::unique_ptr<SpicePartition>> &partitions() const;
+    SessionStats &stats();
+
+    /**
+     * @brief Value-change callback user data for the partition at the given index
+     * @param no_redo true for inputs bound without redo
+     */
+    PortWatch *port_watch(size_t index, bool no_redo);
+
+    /**
+     * @brief Register a value-change callback to be removed on reset
+     */
+    void track_port_callback(vpiHandle cb_handle);
+
+    // VPI scheduling state
+    bool add_ngspice_timestep() const;
+    void set_add_ngspice_timestep(bool add);
+    vpiHandle next_time_cb_handle() const;
+    void set_next_time_cb_handle(vpiHandle handle);
+
+private:
+    Barrier barrier_;
+    Config::Settings config_;
+    std::vector<std::unique_ptr<NgSpiceLibrary>> libraries_;  // kept across resets
+    std::vector<std::unique_ptr<EngineLink>> links_;          // callback link per library, kept with them
+    std::string libraries_transport_;                          // transport the libraries were created for
+    std::vector<std::unique_ptr<SpicePartition>> partitions_;
+    std::vector<PortWatch> port_watches_;  // redo and no-redo watch per partition, stable while configured
+
+    bool started_ = false;
+    bool stopped_ = false;
+    bool surrogate_ = false;  // ngspice is not started, only the partitions' interfaces are used
+
+    bool add_ngspice_timestep_ = false;
+    vpiHandle next_time_cb_handle_ = nullptr;
+    std::vector<vpiHandle> port_cb_handles_;
+    std::unique_ptr<SessionStats> stats_ = std::make_unique<SessionStats>();
+    std::unique_ptr<OutputRecorder> output_recorder_;
+    std::unique_ptr<OutputStub> output_stub_;
+
+    std::string output_file_name(const SpicePartition *partition, const std::string &file_name) const;
+};
+
+} // namespace spice_vpi
+
+#endif // CO_SIM_SESSION_H
@@ -1,5 +1,8 @@
 #include "Config.h"
+#include "AnalogTrace.h"
 #include "Debug.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <stdexcept>
 #include <sstream>
@@ -9,7 +12,10 @@ namespace spice_vpi {
 auto Config::load_from_environment() -> Config::Settings {
     Settings settings;
     
-    settings.spice_netlist_path = get_required_env_var("SPICE_NETLIST");
+    settings.spice_netlist_paths = parse_netlist_paths(get_required_env_var("SPICE_NETLIST"));
+    if (!settings.spice_netlist_paths.empty()) {
+        settings.spice_netlist_path = settings.spice_netlist_paths.front();
+    }
     
     // Parse HDL_INSTANCE environment variable
     std::string hdl_instances_str = get_required_env_var("HDL_INSTANCE");
@@ -18,6 +24,102 @@ auto Config::load_from_environment() -> Config::Settings {
     settings.vcc_voltage = get_optional_env_double("VCC", 1.0);
     settings.logic_threshold_low = get_optional_env_double("LOGIC_THRESHOLD_LOW", 0.3 * settings.vcc_voltage);
     settings.logic_threshold_high = get_optional_env_double("LOGIC_THRESHOLD_HIGH", 0.7 * settings.vcc_voltage);
+    settings.spice_startup_timeout = get_optional_env_double("SPICE_STARTUP_TIMEOUT", 60.0);
+
+    settings.op_cache_dir = get_optional_env_var("SPICE_OP_CACHE");
+    settings.op_cache_time = get_optional_env_double("SPICE_OP_CACHE_TIME", 0.0);
+    settings.op_cache_mode = get_optional_env_var("SPICE_OP_CACHE_MODE", "ic");
+    std::transform(settings.op_cache_mode.begin(), settings.op_cache_mode.end(), settings.op_cache_mode.begin(), ::tolower);
+
+    std::string corners_str = get_optional_env_var("SPICE_CORNERS");
+    if (!corners_str.empty()) {
+        settings.spice_corner_paths = parse_netlist_paths(corners_str);
+    }
+    settings.corner_tolerance = get_optional_env_double("SPICE_CORNER_TOLERANCE", 0.1 * settings.vcc_voltage);
+
+    settings.spice_transport = get_optional_env_var("SPICE_TRANSPORT", "inprocess");
+    std::transform(settings.spice_transport.begin(), settings.spice_transport.end(), settings.spice_transport.begin(), ::tolower);
+    settings.spice_server_path = get_optional_env_var("SPICE_SERVER");
+
+    for (std::string name : parse_netlist_paths(get_optional_env_var("SPICE_NO_REDO_INPUTS"))) {
+        if (!name.empty()) {
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            settings.no_redo_input_names.push_back(name);
+        }
+    }
+
+    settings.dump_mode = get_optional_env_var("SPICE_DUMP", "raw");
+    std::transform(settings.dump_mode.begin(), settings.dump_mode.end(), settings.dump_mode.begin(), ::tolower);
+    for (const std::string &name : parse_netlist_paths(get_optional_env_var("SPICE_DUMP_VECTORS"))) {
+        if (!name.empty()) {
+            settings.dump_vectors.push_back(name);
+        }
+    }
+    settings.save_mode = get_optional_env_var("SPICE_SAVE", "all");
+    std::transform(settings.save_mode.begin(), settings.save_mode.end(), settings.save_mode.begin(), ::tolower);
+    for (const std::string &name : parse_netlist_paths(get_optional_env_var("SPICE_SAVE_NODES"))) {
+        if (!name.empty()) {
+            settings.save_nodes.push_back(name);
+        }
+    }
+    settings.save_grid = get_optional_env_var("SPICE_SAVE_GRID", "off");
+    std::transform(settings.save_grid.begin(), settings.save_grid.end(), settings.save_grid.begin(), ::tolower);
+
+    settings.dump_chunk_points = static_cast<size_t>(std::max(0.0, get_optional_env_double("SPICE_DUMP_CHUNK", 4096.0)));
+
+    settings.trace_file = get_optional_env_var("SPICE_FST");
+    for (const std::string &name : parse_netlist_paths(get_optional_env_var("SPICE_FST_NODES"))) {
+        if (!name.empty()) {
+            settings.trace_nodes.push_back(name);
+        }
+    }
+    settings.trace_tolerance = get_optional_env_double("SPICE_FST_TOLERANCE", 1e-3);
+
+#ifdef DEBUG
+    settings.event_trace = get_optional_env_var("SPICE_TRACE", "all");  // the debug build traces everything by default
+#else
+    settings.event_trace = get_optional_env_var("SPICE_TRACE");
+#endif
+    settings.event_trace_file = get_optional_env_var("SPICE_TRACE_FILE", "spicebind.trace");
+    settings.event_trace_events = static_cast<size_t>(std::max(0.0, get_optional_env_double("SPICE_TRACE_EVENTS", 65536.0)));
+
+    settings.log_level = get_optional_env_var("SPICE_LOG_LEVEL", "all");
+    std::transform(settings.log_level.begin(), settings.log_level.end(), settings.log_level.begin(), ::tolower);
+    settings.log_file = get_optional_env_var("SPICE_LOG_FILE");
+    settings.log_repeat_limit = static_cast<unsigned>(std::max(0.0, get_optional_env_double("SPICE_LOG_REPEAT", 20.0)));
+
+    settings.stats_file = get_optional_env_var("SPICE_STATS_JSON");
+    settings.stimulus_record = get_optional_env_var("SPICE_RECORD_STIMULUS");
+    settings.output_record = get_optional_env_var("SPICE_RECORD_OUTPUTS");
+    settings.output_stub = get_optional_env_var("SPICE_STUB_OUTPUTS");
+    settings.solver = get_optional_env_var("SPICE_SOLVER", "default");
+    std::transform(settings.solver.begin(), settings.solver.end(), settings.solver.begin(), ::tolower);
+    std::string threads_str = get_optional_env_var("SPICE_THREADS");
+    std::transform(threads_str.begin(), threads_str.end(), threads_str.begin(), ::tolower);
+    settings.threads_auto = (threads_str == "auto");
+    if (!settings.threads_auto) {
+        double threads = get_optional_env_double("SPICE_THREADS", 0.0);
+        if (threads < 0.0 || threads != std::floor(threads)) {
+            throw std::invalid_argument("SPICE_THREADS must be a thread count or 'auto' (got '" + threads_str + "')");
+        }
+        settings.threads = static_cast<unsigned>(threads);
+    }
+    settings.tune_steps = static_cast<size_t>(std::max(0.0, get_optional_env_double("SPICE_TUNE_STEPS", 200.0)));
+
+    settings.adaptive = get_optional_env_var("SPICE_ADAPTIVE", "off");
+    std::transform(settings.adaptive.begin(), settings.adaptive.end(), settings.adaptive.begin(), ::tolower);
+    settings.adaptive_reltol = get_optional_env_double("SPICE_ADAPTIVE_RELTOL", 1e-3);
+    settings.adaptive_abstol = get_optional_env_double("SPICE_ADAPTIVE_ABSTOL", 1e-12);
+    settings.adaptive_loose_reltol = get_optional_env_double("SPICE_ADAPTIVE_LOOSE_RELTOL", 1e-2);
+    settings.adaptive_loose_abstol = get_optional_env_double("SPICE_ADAPTIVE_LOOSE_ABSTOL", 1e-9);
+    settings.adaptive_max_step = get_optional_env_double("SPICE_ADAPTIVE_MAX_STEP", 0.0);
+    settings.adaptive_margin = get_optional_env_double("SPICE_ADAPTIVE_MARGIN", 0.1 * settings.vcc_voltage);
+    settings.adaptive_hold = get_optional_env_double("SPICE_ADAPTIVE_HOLD", 10e-9);
+    std::string surrogates_str = get_optional_env_var("SPICE_SURROGATE");
+    if (!surrogates_str.empty()) {
+        settings.surrogate_paths = parse_netlist_paths(surrogates_str);
+        settings.surrogate_path = settings.surrogate_paths.front();
+    }
     
     validate(settings);
     return settings;
@@ -32,6 +134,16 @@ void Config::validate(const Settings& settings) {
         throw std::invalid_argument("HDL instance names cannot be empty");
     }
     
+    if (settings.spice_netlist_paths.size() > 1 && settings.spice_netlist_paths.size() != settings.hdl_instance_names.size()) {
+        throw std::invalid_argument("SPICE_NETLIST must list one netlist per HDL instance when several are given");
+    }
+
+    for (const auto& netlist_path : settings.spice_netlist_paths) {
+        if (netlist_path.empty()) {
+            throw std::invalid_argument("SPICE netlist path cannot be empty");
+        }
+    }
+
     // Check that all instance names are non-empty
     for (const auto& instance_name : settings.hdl_instance_names) {
         if (instance_name.empty()) {
@@ -50,6 +162,157 @@ void Config::validate(const Settings& settings) {
     if (settings.logic_threshold_low < 0.0 || settings.logic_threshold_high > settings.vcc_voltage) {
         throw std::invalid_argument("Logic thresholds must be within [0, VCC] range");
     }
+
+    if (settings.spice_startup_timeout <= 0.0) {
+        throw std::invalid_argument("SPICE startup timeout must be positive");
+    }
+
+    if (settings.op_cache_time < 0.0) {
+        throw std::invalid_argument("Operating point cache time must not be negative");
+    }
+
+    if (settings.op_cache_mode != "ic" && settings.op_cache_mode != "nodeset") {
+        throw std::invalid_argument("Operating point cache mode must be 'ic' or 'nodeset'");
+    }
+
+    if (!settings.spice_corner_paths.empty() && settings.spice_netlist_paths.size() > 1) {
+        throw std::invalid_argument("SPICE_CORNERS requires a single SPICE_NETLIST");
+    }
+
+    std::vector<std::string> corner_names;
+    for (const auto& corner_path : settings.spice_corner_paths) {
+        if (corner_path.empty()) {
+            throw std::invalid_argument("SPICE corner netlist path cannot be empty");
+        }
+        std::string name = corner_name(corner_path);
+        if (std::find(corner_names.begin(), corner_names.end(), name) != corner_names.end()) {
+            throw std::invalid_argument("SPICE corner netlist names must be unique: " + name);
+        }
+        corner_names.push_back(name);
+    }
+
+    if (settings.corner_tolerance <= 0.0) {
+        throw std::invalid_argument("SPICE corner tolerance must be positive");
+    }
+
+    if (settings.dump_mode != "raw" && settings.dump_mode != "stream" && settings.dump_mode != "none") {
+        throw std::invalid_argument("SPICE_DUMP must be 'raw', 'stream' or 'none' (got '" + settings.dump_mode + "')");
+    }
+
+    if (settings.save_mode != "all" && settings.save_mode != "bound") {
+        throw std::invalid_argument("SPICE_SAVE must be 'all' or 'bound' (got '" + settings.save_mode + "')");
+    }
+
+    if (settings.save_grid != "on" && settings.save_grid != "off") {
+        throw std::invalid_argument("SPICE_SAVE_GRID must be 'on' or 'off' (got '" + settings.save_grid + "')");
+    }
+
+    if (settings.dump_chunk_points == 0) {
+        throw std::invalid_argument("SPICE_DUMP_CHUNK must be at least 1");
+    }
+
+    if (settings.trace_tolerance < 0.0) {
+        throw std::invalid_argument("SPICE_FST_TOLERANCE must not be negative");
+    }
+
+    if (!settings.output_stub.empty() && !settings.output_record.empty()) {
+        throw std::invalid_argument("SPICE_STUB_OUTPUTS and SPICE_RECORD_OUTPUTS cannot be used together");
+    }
+
+    if (settings.solver != "default" && settings.solver != "klu" && settings.solver != "sparse" && settings.solver != "auto") {
+        throw std::invalid_argument("SPICE_SOLVER must be 'default', 'klu', 'sparse' or 'auto' (got '" + settings.solver + "')");
+    }
+
+    if ((settings.solver == "auto" || settings.threads_auto) && settings.tune_steps < 2) {
+        throw std::invalid_argument("SPICE_TUNE_STEPS must be at least 2");
+    }
+
+    if (settings.adaptive != "on" && settings.adaptive != "off") {
+        throw std::invalid_argument("SPICE_ADAPTIVE must be 'on' or 'off' (got '" + settings.adaptive + "')");
+    }
+
+    if (settings.adaptive_reltol <= 0.0 || settings.adaptive_abstol <= 0.0 || settings.adaptive_loose_reltol <= 0.0 ||
+        settings.adaptive_loose_abstol <= 0.0) {
+        throw std::invalid_argument("SPICE_ADAPTIVE tolerances must be positive");
+    }
+
+    if (settings.adaptive_max_step < 0.0 || settings.adaptive_margin < 0.0 || settings.adaptive_hold < 0.0) {
+        throw std::invalid_argument("SPICE_ADAPTIVE_MAX_STEP, SPICE_ADAPTIVE_MARGIN and SPICE_ADAPTIVE_HOLD must not be negative");
+    }
+
+    if (!settings.surrogate_paths.empty()) {
+        if (settings.surrogate_paths.size() != settings.spice_netlist_paths.size()) {
+            throw std::invalid_argument("SPICE_SURROGATE must list one table per SPICE_NETLIST netlist");
+        }
+        if (!settings.spice_corner_paths.empty() || !settings.output_stub.empty()) {
+            throw std::invalid_argument("SPICE_SURROGATE cannot be combined with SPICE_CORNERS or SPICE_STUB_OUTPUTS");
+        }
+    }
+
+    uint32_t trace_categories = 0;
+    if (!Tracer::parse_categories(settings.event_trace, trace_categories)) {
+        throw std::invalid_argument("SPICE_TRACE must list 'general', 'sync', 'redo', 'srcdata', 'port', 'barrier' or 'all' (got '" +
+                                    settings.event_trace + "')");
+    }
+    if (trace_categories != 0 && settings.event_trace_events == 0) {
+        throw std::invalid_argument("SPICE_TRACE_EVENTS must be at least 1");
+    }
+
+    Logger::Level log_level;
+    if (!Logger::parse_level(settings.log_level, log_level)) {
+        throw std::invalid_argument("SPICE_LOG_LEVEL must be 'error', 'warning', 'info' or 'all' (got '" + settings.log_level + "')");
+    }
+
+#ifndef SPICEBIND_HAVE_FST
+    if (!settings.trace_file.empty() && !AnalogTrace::is_vcd_file(settings.trace_file)) {
+        throw std::invalid_argument("spicebind was built without FST support, use a .vcd file for SPICE_FST (got '" +
+                                    settings.trace_file + "')");
+    }
+#endif
+
+    if (settings.spice_transport != "inprocess" && settings.spice_transport != "server") {
+        throw std::invalid_argument("SPICE transport must be 'inprocess' or 'server'");
+    }
+}
+
+auto Config::partitions(const Settings& settings) -> std::vector<Settings> {
+    std::vector<Settings> partitions;
+    if (settings.spice_netlist_paths.size() <= 1) {
+        partitions.push_back(settings);
+    } else {
+        for (size_t i = 0; i < settings.spice_netlist_paths.size(); ++i) {
+            Settings partition = settings;
+            partition.spice_netlist_path = settings.spice_netlist_paths[i];
+            partition.spice_netlist_paths = {settings.spice_netlist_paths[i]};
+            partition.hdl_instance_names = {settings.hdl_instance_names[i]};
+            if (!settings.surrogate_paths.empty()) {
+                partition.surrogate_path = settings.surrogate_paths[i];
+            }
+            // each netlist binds a single instance, so ports keep their plain names
+            partition.full_path_discovery = false;
+            partitions.push_back(partition);
+        }
+    }
+
+    // corners see the same instances as the driving netlist
+    for (const auto& corner_path : settings.spice_corner_paths) {
+        Settings corner = settings;
+        corner.spice_netlist_path = corner_path;
+        corner.spice_netlist_paths = {corner_path};
+        corner.corner_name = corner_name(corner_path);
+        partitions.push_back(corner);
+    }
+    return partitions;
+}
+
+auto Config::corner_name(const std::string& netlist_path) -> std::string {
+    size_t slash = netlist_path.find_last_of("/\\");
+    std::string name = (slash == std::string::npos) ? netlist_path : netlist_path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name = name.substr(0, dot);
+    }
+    return name;
 }
 
 auto Config::get_required_env_var(const char* name) -> std::string {
@@ -82,6 +345,19 @@ auto Config::get_optional_env_double(const char* name, double default_value) ->
     }
 }
 
+auto Config::parse_netlist_paths(const std::string& env_value) -> std::vector<std::string> {
+    std::vector<std::string> paths;
+    std::istringstream stream(env_value);
+    std::string path;
+
+    while (std::getline(stream, path, ',')) {
+        size_t start = path.find_first_not_of(" \t\r\n");
+        size_t end = path.find_last_not_of(" \t\r\n");
+        paths.push_back(start == std::string::npos ? std::string() : path.substr(start, end - start + 1));
+    }
+    return paths;
+}
+
 void Config::parse_instance_names(const std::string& env_value, 
                                  std::vector<std::string>& instance_names,
                                  bool& full_path_discovery) {
@@ -14,7 +14,8 @@ namespace spice_vpi {
 class Config {
 public:
     struct Settings {
-        std::string spice_netlist_path;
+        std::string spice_netlist_path;                 // first (or only) netlist
+        std::vector<std::string> spice_netlist_paths;   // one netlist per partition, or a single shared netlist
         std::vector<std::string> hdl_instance_names;
         bool full_path_discovery = false;  // indicates if HDL_INSTANCE env var had any comma
         double vcc_voltage = 1.0;
@@ -22,6 +23,49 @@ public:
         double logic_threshold_high = 0.7;
         double min_analog_change_threshold = 1e-9;
         unsigned long long time_precision = 1e12;
+        double spice_startup_timeout = 60.0;  // seconds to wait for the first ngspice time step
+        std::string op_cache_dir;             // operating point cache directory (empty = disabled)
+        double op_cache_time = 0.0;           // SPICE time (s) at which node voltages are cached
+        std::string op_cache_mode = "ic";     // inject cached values as "ic" or "nodeset"
+        std::vector<std::string> spice_corner_paths;  // corner netlists run in lockstep with the driving netlist
+        std::string corner_name;              // set for corner partitions (empty = drives the HDL outputs)
+        double corner_tolerance = 0.1;        // real output divergence threshold in volts
+        std::string spice_transport = "inprocess";  // "inprocess" or "server" (ngspice in a helper process)
+        std::string spice_server_path;        // server executable (empty = next to the VPI module)
+        std::vector<std::string> no_redo_input_names;  // 1-bit inputs applied at the next step without a redo ("*" = all)
+        std::string dump_mode = "raw";        // "raw" (write at the end), "stream" or "none"
+        std::vector<std::string> dump_vectors;  // vectors streamed to the dump file (empty = all)
+        size_t dump_chunk_points = 4096;      // points per chunk handed to the stream writer
+        std::string save_mode = "all";        // "all" or "bound" (only bound outputs and listed nodes are kept)
+        std::vector<std::string> save_nodes;  // extra vectors kept with save_mode "bound"
+        std::string save_grid = "off";        // "on" keeps the history only on the .tran step grid (ngspice interp)
+        std::string trace_file;               // FST (or .vcd) file of analog nodes in HDL time (empty = disabled)
+        std::vector<std::string> trace_nodes; // vectors traced in addition to the bound ports
+        double trace_tolerance = 1e-3;        // volts a traced value must move before a change is written
+        std::string event_trace;              // SPICE_TRACE categories, e.g. "sync,redo" or "all" (empty = off)
+        std::string event_trace_file = "spicebind.trace";  // binary trace written at the end of simulation
+        size_t event_trace_events = 65536;    // ring buffer capacity per thread
+        std::string log_level = "all";        // "error", "warning", "info" or "all" (with ngspice output)
+        std::string log_file;                 // log file instead of the simulator console (empty = console)
+        unsigned log_repeat_limit = 20;       // messages per call site before repeats are suppressed (0 = no limit)
+        std::string stats_file;               // JSON file of the performance counters (empty = report only)
+        std::string stimulus_record;          // file of the source values ngspice consumed, for spicebind_replay (empty = off)
+        std::string output_record;            // file of the outputs written to the HDL and the inputs read (empty = off)
+        std::string output_stub;              // replay this output recording instead of running ngspice (empty = off)
+        std::vector<std::string> surrogate_paths;  // characterised tables evaluated instead of each netlist (empty = off)
+        std::string surrogate_path;           // table of this partition
+        std::string solver = "default";       // matrix solver: "default" (the netlist's), "klu", "sparse" or "auto"
+        unsigned threads = 0;                 // ngspice device evaluation threads (0 = ngspice's default)
+        bool threads_auto = false;            // time 1, 2, 4, ... threads and keep the fastest
+        size_t tune_steps = 200;              // steps timed per candidate when tuning
+        std::string adaptive = "off";         // "on" switches the tolerances with the activity of the bound ports
+        double adaptive_reltol = 1e-3;        // reltol while outputs are near a threshold or inputs change
+        double adaptive_abstol = 1e-12;       // abstol while outputs are near a threshold or inputs change
+        double adaptive_loose_reltol = 1e-2;  // reltol while idle
+        double adaptive_loose_abstol = 1e-9;  // abstol while idle
+        double adaptive_max_step = 0.0;       // step limit in seconds while not idle (0 = the netlist's)
+        double adaptive_margin = 0.1;         // volts around the logic thresholds counted as near
+        double adaptive_hold = 10e-9;         // SPICE seconds without activity before loosening
     };
 
     /**
@@ -38,6 +82,19 @@ public:
      */
     static void validate(const Settings& settings);
 
+    /**
+     * @brief Split settings into one set per SPICE partition
+     * 
+     * With a single SPICE_NETLIST all instances share one partition. With a
+     * comma-separated list, instance i is bound to netlist i in its own partition.
+     * Each SPICE_CORNERS netlist adds a corner partition bound to all instances,
+     * after the driving partitions.
+     * 
+     * @param settings Validated configuration
+     * @return Settings of each partition
+     */
+    static std::vector<Settings> partitions(const Settings& settings);
+
 private:
     static std::string get_required_env_var(const char* name);
     static std::string get_optional_env_var(const char* name, const std::string& default_value = "");
@@ -52,6 +109,20 @@ private:
     static void parse_instance_names(const std::string& env_value, 
                                    std::vector<std::string>& instance_names,
                                    bool& full_path_discovery);
+
+    /**
+     * @brief Parse comma-separated netlist paths from environment variable
+     * @param env_value The value from SPICE_NETLIST environment variable
+     * @return Trimmed netlist paths
+     */
+    static std::vector<std::string> parse_netlist_paths(const std::string& env_value);
+
+    /**
+     * @brief Name of a corner derived from its netlist file name
+     * @param netlist_path Corner netlist path
+     * @return File name without directory and extension
+     */
+    static std::string corner_name(const std::string& netlist_path);
 };
 
 } // namespace spice_vpi
@@ -2,35 +2,16 @@
 #define DEBUG_H
 
 // NOLINTBEGIN
+#include "Logger.h"
+#include "Tracer.h"
 #include "vpi_user.h"
 
-// Uncomment the following line to enable debug output
-// #define DEBUG
+// Debug output is recorded with TRACE(category, ...) at runtime (SPICE_TRACE), see Tracer.h
 
-#ifdef DEBUG
-#define DBG(...)                                                                                                                                                                                       \
-    do {                                                                                                                                                                                               \
-        vpi_printf("[DBG] %s:%d:%s(): ", __FILE__, __LINE__, __func__);                                                                                                                                \
-        vpi_printf(__VA_ARGS__);                                                                                                                                                                       \
-        vpi_printf("\n");                                                                                                                                                                              \
-    } while (0)
-#else
-#define DBG(...) ((void)0)
-#endif
-
-#define ERROR(...)                                                                                                                                                                                     \
-    do {                                                                                                                                                                                               \
-        vpi_printf("** Error: %s:%d:%s(): ", __FILE__, __LINE__, __func__);                                                                                                                            \
-        vpi_printf(__VA_ARGS__);                                                                                                                                                                       \
-        vpi_printf("\n");                                                                                                                                                                              \
-    } while (0)
-
-#define INFO(...)                                                                                                                                                                                      \
-    do {                                                                                                                                                                                               \
-        vpi_printf("** Info: ");                                                                                                                                                                       \
-        vpi_printf(__VA_ARGS__);                                                                                                                                                                       \
-        vpi_printf("\n");                                                                                                                                                                              \
-    } while (0)
+// Errors, warnings and infos go through the buffered logger (SPICE_LOG_LEVEL, SPICE_LOG_FILE)
+#define ERROR(...) spice_vpi::Logger::instance().logf(spice_vpi::Logger::Level::Error, __FILE__, __LINE__, __func__, __VA_ARGS__)
+#define WARN(...) spice_vpi::Logger::instance().logf(spice_vpi::Logger::Level::Warning, __FILE__, __LINE__, __func__, __VA_ARGS__)
+#define INFO(...) spice_vpi::Logger::instance().logf(spice_vpi::Logger::Level::Info, __FILE__, __LINE__, __func__, __VA_ARGS__)
 // NOLINTEND
 
 #endif // DEBUG_H 
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "Logger.h"
+#include "vpi_user.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace spice_vpi {
+
+struct Logger::RepeatCount {
+    std::atomic<size_t> key{0};  // 0 = free
+    std::atomic<unsigned> count{0};
+};
+
+struct Logger::Slot {
+    std::atomic<size_t> sequence{0};
+    std::string text;
+};
+
+auto Logger::instance() -> Logger & {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : repeats_(new RepeatCount[REPEAT_BUCKETS]), slots_(new Slot[QUEUE_SLOTS]) {
+    for (size_t i = 0; i < QUEUE_SLOTS; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+void Logger::configure(Level level, const std::string &file_name, unsigned repeat_limit) {
+    flush();
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if (!file_name.empty()) {
+        file_ = std::fopen(file_name.c_str(), "w");
+        if (file_ == nullptr) {
+            vpi_printf("** Warning: cannot open log file %s, logging to the console\n", file_name.c_str());
+        }
+    }
+
+    level_.store(static_cast<int>(level));
+    repeat_limit_.store(repeat_limit);
+    for (size_t i = 0; i < REPEAT_BUCKETS; ++i) {
+        repeats_[i].key.store(0, std::memory_order_relaxed);
+        repeats_[i].count.store(0, std::memory_order_relaxed);
+    }
+    suppressed_.store(0);
+    dropped_.store(0);
+}
+
+void Logger::set_output_thread() {
+    output_thread_ = std::this_thread::get_id();
+}
+
+auto Logger::enabled(Level level) const -> bool {
+    return static_cast<int>(level) <= level_.load(std::memory_order_relaxed);
+}
+
+auto Logger::parse_level(const std::string &name, Level &level) -> bool {
+    if (name == "error") {
+        level = Level::Error;
+    } else if (name == "warning") {
+        level = Level::Warning;
+    } else if (name == "info") {
+        level = Level::Info;
+    } else if (name == "all") {
+        level = Level::Spice;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Logger::logf(Level level, const char *file, int line, const char *func, const char *format, ...) {
+    if (!enabled(level)) {
+        return;
+    }
+
+    char buffer[512];
+    int prefix = 0;
+    if (level == Level::Error) {
+        prefix = std::snprintf(buffer, sizeof(buffer), "** Error: %s:%d:%s(): ", file, line, func);
+    } else if (level == Level::Warning) {
+        prefix = std::snprintf(buffer, sizeof(buffer), "** Warning: ");
+    } else {
+        prefix = std::snprintf(buffer, sizeof(buffer), "** Info: ");
+    }
+    std::string text(buffer, static_cast<size_t>(std::max(0, std::min(prefix, static_cast<int>(sizeof(buffer)) - 1))));
+
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    if (length >= static_cast<int>(sizeof(buffer))) {
+        std::string message(static_cast<size_t>(length) + 1, '\0');
+        std::vsnprintf(&message[0], message.size(), format, copy);
+        message.resize(static_cast<size_t>(length));
+        text += message;
+    } else if (length > 0) {
+        text.append(buffer, static_cast<size_t>(length));
+    }
+    va_end(copy);
+    va_end(args);
+
+    size_t key = std::hash<const void *>()(file) * 31 + static_cast<size_t>(line);
+    log(level, key, std::move(text));
+}
+
+void Logger::log_spice(const char *text) {
+    // ngspice prefixes its stderr lines with "stderr"
+    Level level = Level::Spice;
+    if (std::strncmp(text, "stderr", 6) == 0) {
+        level = (std::strstr(text, "rror") != nullptr) ? Level::Error : Level::Warning;
+    }
+    if (!enabled(level)) {
+        return;
+    }
+    size_t key = std::hash<std::string_view>()(std::string_view(text));
+    log(level, key, std::string("NGSPICE: ") + text);
+}
+
+void Logger::log(Level level, size_t key, std::string text) {
+    if (!admit(key, text)) {
+        return;
+    }
+    if (output_thread_ == std::thread::id() || std::this_thread::get_id() == output_thread_) {
+        flush();
+        print(text);
+    } else if (!push(std::move(text))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Repeat limit per call site; the last admitted repeat says that more follow
+auto Logger::admit(size_t key, std::string &text) -> bool {
+    unsigned limit = repeat_limit_.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    key = (key == 0) ? 1 : key;
+
+    RepeatCount *entry = nullptr;
+    for (size_t probe = 0; probe < REPEAT_PROBES && entry == nullptr; ++probe) {
+        RepeatCount &candidate = repeats_[(key + probe) % REPEAT_BUCKETS];
+        size_t current = candidate.key.load(std::memory_order_acquire);
+        if (current == 0 && candidate.key.compare_exchange_strong(current, key)) {
+            current = key;
+        }
+        if (current == key) {
+            entry = &candidate;
+        }
+    }
+    if (entry == nullptr) {
+        return true;  // table full around this key, not limited
+    }
+
+    unsigned count = entry->count.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count < limit) {
+        return true;
+    }
+    if (count == limit) {
+        text += " (further repeats suppressed)";
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+auto Logger::push(std::string &&text) -> bool {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot &slot = slots_[pos & (QUEUE_SLOTS - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.text = std::move(text);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::flush() {
+    while (true) {
+        Slot &slot = slots_[dequeue_pos_ & (QUEUE_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            break;
+        }
+        std::string text = std::move(slot.text);
+        slot.text.clear();
+        slot.sequence.store(dequeue_pos_ + QUEUE_SLOTS, std::memory_order_release);
+        dequeue_pos_++;
+        print(text);
+    }
+    if (file_ != nullptr) {
+        std::fflush(file_);
+    }
+}
+
+void Logger::close() {
+    flush();
+    unsigned long long suppressed = suppressed_.exchange(0);
+    unsigned long long dropped = dropped_.exchange(0);
+    if (suppressed != 0 || dropped != 0) {
+        print("** Info: " + std::to_string(suppressed) + " repeated log messages suppressed, " + std::to_string(dropped) +
+              " dropped while the log queue was full");
+    }
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void Logger::print(const std::string &text) {
+    if (file_ != nullptr) {
+        std::fprintf(file_, "%s\n", text.c_str());
+    } else {
+        vpi_printf("%s\n", text.c_str());
+    }
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,121 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace spice_vpi {
+
+/**
+ * @brief Buffered log of ngspice output and bridge diagnostics
+ *
+ * Messages from the ngspice threads go into a lock-free bounded queue and are
+ * printed by the HDL thread at its next sync point (flush()), so they never
+ * block ngspice on simulator output and never interleave with it. Messages
+ * logged on the HDL thread are printed right away, after the queued ones.
+ *
+ * Messages below the configured level are dropped where they are logged.
+ * Each call site (or ngspice line) prints at most a configured number of
+ * times; further repeats are counted and reported by close(). When the queue
+ * is full new messages are dropped and counted as well.
+ */
+class Logger {
+public:
+    enum class Level {
+        Error = 0,
+        Warning = 1,
+        Info = 2,
+        Spice = 3,  // ngspice output
+    };
+
+    static Logger &instance();
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * @brief Set up the level, output file and repeat limit (HDL thread)
+     * @param level Most verbose level printed
+     * @param file_name Log file instead of the simulator console (empty = console)
+     * @param repeat_limit Messages printed per call site before repeats are suppressed (0 = no limit)
+     */
+    void configure(Level level, const std::string &file_name, unsigned repeat_limit);
+
+    /**
+     * @brief Mark the calling thread as the one that prints (the HDL thread)
+     */
+    void set_output_thread();
+
+    /**
+     * @brief Log a formatted bridge message
+     *
+     * The call site (file and line) is the key for the repeat limit.
+     */
+    void logf(Level level, const char *file, int line, const char *func, const char *format, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 6, 7)))
+#endif
+        ;
+
+    /**
+     * @brief Log one line of ngspice output; identical lines count as repeats
+     */
+    void log_spice(const char *text);
+
+    /**
+     * @brief Print the queued messages (HDL thread)
+     */
+    void flush();
+
+    /**
+     * @brief Flush, report suppressed messages and close the log file (HDL thread)
+     */
+    void close();
+
+    /**
+     * @brief Check if a message of this level would be printed
+     */
+    bool enabled(Level level) const;
+
+    /**
+     * @brief Parse a SPICE_LOG_LEVEL value ("error", "warning", "info" or "all")
+     * @return false for an unknown name
+     */
+    static bool parse_level(const std::string &name, Level &level);
+
+private:
+    struct Slot;
+    struct RepeatCount;
+    static constexpr size_t QUEUE_SLOTS = 8192;     // power of two
+    static constexpr size_t REPEAT_BUCKETS = 4096;  // call sites and ngspice lines tracked for the repeat limit
+    static constexpr size_t REPEAT_PROBES = 16;
+
+    Logger();
+    ~Logger();
+
+    std::atomic<int> level_{static_cast<int>(Level::Spice)};
+    std::atomic<unsigned> repeat_limit_{0};
+    std::unique_ptr<RepeatCount[]> repeats_;  // open addressing table, keys are never removed while configured
+    std::atomic<unsigned long long> suppressed_{0};
+    std::atomic<unsigned long long> dropped_{0};
+
+    // bounded multi-producer queue, single consumer (the output thread)
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> enqueue_pos_{0};
+    size_t dequeue_pos_ = 0;
+
+    std::thread::id output_thread_;
+    FILE *file_ = nullptr;
+
+    void log(Level level, size_t key, std::string text);
+    bool admit(size_t key, std::string &text);
+    bool push(std::string &&text);
+    void print(const std::string &text);
+};
+
+} // namespace spice_vpi
+
+#endif // LOGGER_H
@@ -1,77 +1,121 @@
 #include "NgSpiceCallbacks.h"
 #include "Debug.h"
-#include "TimeBarrier.h"
-#include "AnalogDigitalInterface.h"
+#include "SpicePartition.h"
 #include "vpi_user.h"
 #include <cmath>
+#include <cstdio>
 #include <string>
 
 
 // TODO:  Maybe add another step after redo with 1 unit time for fast pulses
 
-extern spice_vpi::TimeBarrier<unsigned long long> g_time_barrier;
-extern std::unique_ptr<spice_vpi::AnalogDigitalInterface> g_interface;
-extern spice_vpi::Config::Settings g_config;
-
 namespace spice_vpi {
 
 int ng_sync(double actual_time, double *delta_time, double old_delta_time, int redostep, int identification_number, int location, void *user_data) {
 
-    unsigned long long delta_time_spice = static_cast<unsigned long long>(std::llround(*delta_time * g_config.time_precision));
-    unsigned long long time_spice = static_cast<unsigned long long>(std::llround(actual_time * g_config.time_precision));
+    auto *partition = static_cast<SpicePartition *>(user_data);
+    auto &barrier = partition->barrier();
+    const auto &config = partition->config();
+    const int engine_id = partition->engine_id();
+    PartitionStats &stats = partition->stats();
+
+    barrier.set_spice_ready(engine_id);
+
+    unsigned long long delta_time_spice = static_cast<unsigned long long>(std::llround(*delta_time * config.time_precision));
+    unsigned long long time_spice = static_cast<unsigned long long>(std::llround(actual_time * config.time_precision));
 
-    unsigned long long next_spice_time = g_time_barrier.get_next_spice_step_time();
-    unsigned long long get_spice_engine_time = g_time_barrier.get_time(spice_vpi::TimeBarrier<unsigned long long>::SPICE_ENGINE_ID);
-    DBG("time_spice=%lld next_spice_step=%lld  get_spice_engine_time=%lld actual_time=%g delta_time=%g delta_time_spice=%lld old_delta_time=%g redostep=%d identification_number=%d location=%d ", time_spice, next_spice_time, get_spice_engine_time, actual_time,
-        *delta_time, delta_time_spice, old_delta_time, redostep, identification_number, location);
+    unsigned long long next_spice_time = barrier.get_next_spice_step_time(engine_id);
+    unsigned long long get_spice_engine_time = barrier.get_time(engine_id);
+    TRACE(Sync, "engine=%d location=%d redostep=%d time_spice=%llu next_spice_step=%llu get_spice_engine_time=%llu", engine_id, location, redostep,
+          time_spice, next_spice_time, get_spice_engine_time);
+    TRACE(Sync, "actual_time=%g delta_time=%g delta_time_spice=%llu old_delta_time=%g", actual_time, *delta_time, delta_time_spice, old_delta_time);
 
     if (redostep) {
-        DBG("return ngspice redostep=%d", redostep);
+        stats.sync_redostep.add();
+        TRACE(Sync, "return ngspice redostep=%d", redostep);
         return 0;
     }
 
+    if (location == 0) {
+        stats.sync_end_of_step.add();
+    } else {
+        stats.sync_start_of_step.add();
+    }
+
     auto next_time_spice = time_spice + delta_time_spice;
     if (get_spice_engine_time > next_time_spice) {
-        DBG("return ngspice get_spice_engine_time=%lld > next_time_spice=%lld", get_spice_engine_time, next_time_spice);
+        TRACE(Sync, "return ngspice get_spice_engine_time=%lld > next_time_spice=%lld", get_spice_engine_time, next_time_spice);
         return 0;
     }
 
     // add new timestep -> redo
-    if (location == 1 and g_time_barrier.needs_redo()) {
+    if (location == 1 and barrier.needs_redo(engine_id)) {
 
         // Skip redo since the actual step is before next time step
         if (time_spice < get_spice_engine_time) {
-            DBG("return ngspice cancel redo time_spice=%lld < get_spice_engine_time=%lld", time_spice, get_spice_engine_time);
+            stats.redos_cancelled.add();
+            TRACE(Redo, "return ngspice cancel redo time_spice=%lld < get_spice_engine_time=%lld", time_spice, get_spice_engine_time);
+            TRACE(Timeline, "event=%d redo cancelled engine=%d time_spice=%llu", Tracer::RedoCancelled, engine_id, time_spice);
             return 0;
         }
 
-        unsigned long long old_delta_time_spice = std::llround(old_delta_time * g_config.time_precision);
+        unsigned long long old_delta_time_spice = std::llround(old_delta_time * config.time_precision);
         unsigned long long new_delta_time_spice = old_delta_time_spice - (time_spice - get_spice_engine_time);
 
-        double redo_time_db = ((double)get_spice_engine_time) * 1.0/g_config.time_precision;
+        double redo_time_db = ((double)get_spice_engine_time) * 1.0/config.time_precision;
         double new_delta_time = old_delta_time - (actual_time - redo_time_db);
 
-        new_delta_time = std::max(new_delta_time, 1.0/g_config.time_precision);
+        new_delta_time = std::max(new_delta_time, 1.0/config.time_precision);
 
         *delta_time = new_delta_time;
 
-        g_time_barrier.set_needs_redo(false);
-        DBG("REDO redo_time_db=%g new_delta_time=%g time_spice=%lld delta_time_spice=%lld new_delta_time_spice=%lld", redo_time_db, *delta_time, time_spice,
+        barrier.set_needs_redo(false, engine_id);
+        stats.redos_performed.add();
+        partition->redo_cost().performed(old_delta_time, actual_time);
+        TRACE(Redo, "REDO redo_time_db=%g new_delta_time=%g time_spice=%lld delta_time_spice=%lld new_delta_time_spice=%lld", redo_time_db, *delta_time, time_spice,
             delta_time_spice, new_delta_time_spice);
+        TRACE(Timeline, "event=%d redo engine=%d time_spice=%llu redo_time=%llu", Tracer::RedoPerformed, engine_id, time_spice, get_spice_engine_time);
 
         return 1;
     }
 
+    // a requested pause: ngspice checks its breakpoints on the point it is about
+    // to accept and pauses before the next step, so nothing runs past this time
+    unsigned long long pause_time = partition->pause_time();
+    if (location == 1 && pause_time != SpicePartition::NO_PAUSE && time_spice >= pause_time) {
+        partition->clear_pause();
+        char command[64];
+        std::snprintf(command, sizeof(command), "stop when time eq %.17g", actual_time);
+        partition->ngspice().command(command);
+        TRACE(Sync, "engine=%d pause at time_spice=%llu pause_time=%llu", engine_id, time_spice, pause_time);
+        TRACE(Timeline, "event=%d breakpoint engine=%d time_spice=%llu", Tracer::Breakpoint, engine_id, time_spice);
+    }
+
     // end step
     if (location == 0) {
 
-        DBG("set_next_spice_step_time");
-        g_time_barrier.set_next_spice_step_time(time_spice + delta_time_spice);
+        AdaptiveTolerance &adaptive = partition->adaptive();
+        if (adaptive.enabled()) {
+            adaptive.on_step(actual_time, partition->interface().outputs_near_threshold(config.adaptive_margin), delta_time);
+            delta_time_spice = static_cast<unsigned long long>(std::llround(*delta_time * config.time_precision));
+        }
+
+        // do not step over a requested pause
+        if (pause_time != SpicePartition::NO_PAUSE && time_spice < pause_time && time_spice + delta_time_spice > pause_time) {
+            *delta_time = static_cast<double>(pause_time) / config.time_precision - actual_time;
+            delta_time_spice = pause_time - time_spice;
+        }
+
+        TRACE(Sync, "set_next_spice_step_time");
+        barrier.set_next_spice_step_time(time_spice + delta_time_spice, engine_id);
 
         //
         // read/update analog outputs values
         //
-        g_interface->analog_outputs_update();
+        partition->interface().analog_outputs_update();
+
+        partition->op_cache().on_step(actual_time);
+        partition->redo_cost().step_accepted();
     }
 
     return 0;
@@ -79,33 +123,116 @@ int ng_sync(double actual_time, double *delta_time, double old_delta_time, int r
 
 int ng_srcdata(double *vp, double time, char *source, int id, void *udp) {
 
-    unsigned long long time_spice_to_vpi = std::llround(time * g_config.time_precision);
+    auto *partition = static_cast<SpicePartition *>(udp);
+    auto &barrier = partition->barrier();
+    const auto &config = partition->config();
+    const int engine_id = partition->engine_id();
+
+    barrier.set_spice_ready(engine_id);
+
+    unsigned long long time_spice_to_vpi = std::llround(time * config.time_precision);
 
-    unsigned long long time_spice_engine = g_time_barrier.get_time(spice_vpi::TimeBarrier<unsigned long long>::SPICE_ENGINE_ID);   
-    DBG("enter source=%s vp=%g time_spice_engine=%lld time_spice=%lld redo_step=%d  time_spice_to_vpi=%lld", source, *vp, time_spice_engine, time_spice_to_vpi, g_time_barrier.needs_redo(), time_spice_to_vpi);
+    unsigned long long time_spice_engine = barrier.get_time(engine_id);   
+    TRACE(SrcData, "enter source=%s vp=%g time_spice_engine=%lld time_spice=%lld redo_step=%d  time_spice_to_vpi=%lld", source, *vp, time_spice_engine, time_spice_to_vpi, barrier.needs_redo(engine_id), time_spice_to_vpi);
 
-    if (!g_time_barrier.needs_redo()) {
-        DBG("update time_spice_to_vpi=%lld time_spice_engine=%lld", time_spice_to_vpi, time_spice_engine);
-        g_time_barrier.update(spice_vpi::TimeBarrier<unsigned long long>::SPICE_ENGINE_ID, time_spice_to_vpi);
+    if (!barrier.needs_redo(engine_id)) {
+        TRACE(SrcData, "update time_spice_to_vpi=%lld time_spice_engine=%lld", time_spice_to_vpi, time_spice_engine);
+        barrier.update(engine_id, time_spice_to_vpi);
     }
 
     //
     // set analog inputs values
     //
-    g_interface->set_analog_input(source + 1, vp);
+    partition->interface().set_analog_input(source + 1, vp);
+    if (StimulusRecorder *recorder = partition->stimulus_recorder()) {
+        recorder->record(source, time, *vp);
+    }
+
+    TRACE(SrcData, "end source=%s time_spice_to_vpi=%lld time=%g vp=%g time_ns=%g", source, time_spice_to_vpi, time, *vp, time * 1e9);
 
-    DBG("end source=%s time_spice_to_vpi=%lld time=%g vp=%g time_ns=%g", source, time_spice_to_vpi, time, *vp, time * 1e9);
+    return 0;
+}
+
+int ng_tune_sync(double actual_time, double *delta_time, double old_delta_time, int redostep, int identification_number, int location, void *user_data) {
+    if (location == 0 && !redostep) {
+        static_cast<SpicePartition *>(user_data)->solver_tuner().step();
+    }
+    return 0;
+}
 
+int ng_tune_srcdata(double *vp, double time, char *source, int id, void *udp) {
+    static_cast<SpicePartition *>(udp)->interface().get_analog_input(source + 1, vp);
+    return 0;
+}
+
+int ng_evt_init(int index, int max_index, char *name, char *type, int ident, void *userdata) {
+    auto *partition = static_cast<SpicePartition *>(userdata);
+    TRACE(General, "event node index=%d name=%s type=%s", index, name, type);
+    partition->interface().bind_event_output(index, name, type);
+    return 0;
+}
+
+int ng_evt_data(int index, double step, double dvalue, char *svalue, void *pvalue, int plen, int mode, int ident, void *userdata) {
+    auto *partition = static_cast<SpicePartition *>(userdata);
+    TRACE(Port, "event index=%d step=%g value=%s mode=%d", index, step, svalue, mode);
+    partition->interface().event_output_update(index, svalue);
+    return 0;
+}
+
+int ng_init_data(pvecinfoall info, int id, void *userdata) {
+    auto *link = static_cast<EngineLink *>(userdata);
+    SpicePartition *partition = link->tuning ? nullptr : link->partition.load();
+    if (partition != nullptr && partition->waveform_stream() != nullptr) {
+        partition->waveform_stream()->begin_plot(info);
+    }
+    if (partition != nullptr && partition->analog_trace() != nullptr) {
+        partition->analog_trace()->begin_plot(info);
+    }
+    return 0;
+}
+
+int ng_data(pvecvaluesall values, int count, int id, void *userdata) {
+    auto *link = static_cast<EngineLink *>(userdata);
+    SpicePartition *partition = link->tuning ? nullptr : link->partition.load();
+    if (partition != nullptr && partition->waveform_stream() != nullptr) {
+        partition->waveform_stream()->add_point(values);
+    }
+    if (partition != nullptr && partition->analog_trace() != nullptr) {
+        partition->analog_trace()->add_point(values);
+    }
     return 0;
 }
 
 int ng_printf(char *output, int ident, void *userdata) {
-    vpi_printf("NGSPICE: %s\n", output);
+    // queued from the ngspice thread, printed by the HDL thread at its next sync point
+    Logger::instance().log_spice(output);
     return 0;
 }
 
-int ng_exit(int status, bool immediate, bool quit, int id, void *data) { 
-    return 0; 
+int ng_exit(int status, bool immediate, bool quit, int id, void *data) {
+    // ngspice cannot continue after a controlled exit, do not let the HDL side wait for it
+    ERROR("ngspice exited with status %d", status);
+    static_cast<EngineLink *>(data)->barrier->shutdown();
+    return 0;
+}
+
+int ng_bgthread_running(bool noruns, int id, void *userdata) {
+    TRACE(General, "noruns=%d", noruns);
+    auto *link = static_cast<EngineLink *>(userdata);
+    if (noruns && link->tuning) {
+        // the end of a tuning run, the co-simulation has not started
+        SpicePartition *partition = link->partition.load();
+        if (partition != nullptr) {
+            partition->solver_tuner().finished();
+        }
+    } else if (noruns) {
+        link->barrier->set_spice_running(false, id);
+        link->barrier->set_spice_stopped(id);
+    } else {
+        link->barrier->set_spice_running(true, id);
+        Tracer::name_thread("ngspice " + std::to_string(id));
+    }
+    return 0;
 }
 
 } // namespace spice_vpi 
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef NGSPICE_CALLBACKS_H
 #define NGSPICE_CALLBACKS_H
 
+#include "ngspice/sharedspice.h"
+
 namespace spice_vpi {
 
 /**
@@ -44,6 +46,83 @@ int ng_sync(double actual_time, double *delta_time, double old_delta_time,
  */
 int ng_srcdata(double *vp, double time, char *source, int id, void *udp);
 
+/**
+ * @brief Synchronization callback of the solver tuning runs
+ *
+ * Counts the accepted steps of the partition's solver tuner; the run is
+ * not synchronized with the HDL simulator.
+ *
+ * @return 0, ngspice chooses its own steps
+ */
+int ng_tune_sync(double actual_time, double *delta_time, double old_delta_time,
+                 int redostep, int identification_number, int location, void *user_data);
+
+/**
+ * @brief Source data callback of the solver tuning runs
+ *
+ * Holds every input at its value at the start of the simulation.
+ */
+int ng_tune_srcdata(double *vp, double time, char *source, int id, void *udp);
+
+/**
+ * @brief XSPICE event node registration callback
+ * 
+ * Called once per event node when the simulation starts. Digital nodes
+ * named like an HDL output are bound as event outputs.
+ * 
+ * @param index Node index used by later event callbacks
+ * @param max_index Highest node index
+ * @param name Node name
+ * @param type Node type ("d" for digital)
+ * @param ident Identification number
+ * @param userdata Partition of the engine
+ * @return 0 on success
+ */
+int ng_evt_init(int index, int max_index, char *name, char *type, int ident, void *userdata);
+
+/**
+ * @brief XSPICE event node data callback
+ * 
+ * Called when an event node changes its value.
+ * 
+ * @param index Node index
+ * @param step Simulation time of the change
+ * @param dvalue Real value of the node
+ * @param svalue Node value as a string (e.g. "1s" for a strong one)
+ * @param pvalue Binary node value
+ * @param plen Size of the binary value
+ * @param mode Analysis mode (0 operating point, 1 DC sweep, 2 transient)
+ * @param ident Identification number
+ * @param userdata Partition of the engine
+ * @return 0 on success
+ */
+int ng_evt_data(int index, double step, double dvalue, char *svalue, void *pvalue, int plen, int mode, int ident, void *userdata);
+
+/**
+ * @brief NGSPICE vector initialisation callback
+ * 
+ * Called when a new plot is created; starts a plot in the waveform stream.
+ * 
+ * @param info Vectors of the new plot
+ * @param id Identification number (SPICE engine id)
+ * @param userdata Engine link of the library instance
+ * @return 0 on success
+ */
+int ng_init_data(pvecinfoall info, int id, void *userdata);
+
+/**
+ * @brief NGSPICE vector data callback
+ * 
+ * Called for every new point of the current plot; appends it to the waveform stream.
+ * 
+ * @param values Values of all vectors at this point
+ * @param count Number of vectors
+ * @param id Identification number (SPICE engine id)
+ * @param userdata Engine link of the library instance
+ * @return 0 on success
+ */
+int ng_data(pvecvaluesall values, int count, int id, void *userdata);
+
 /**
  * @brief NGSPICE printf callback
  * 
@@ -59,17 +138,31 @@ int ng_printf(char *output, int ident, void *userdata);
 /**
  * @brief NGSPICE exit callback
  * 
- * Called when NGSPICE simulation terminates.
+ * Called when NGSPICE exits (quit or fatal error, or a lost ngspice server).
+ * Shuts down the time barrier so the HDL simulator does not wait for it.
  * 
  * @param status Exit status
  * @param immediate Immediate exit flag
  * @param quit Quit flag
  * @param id Process identifier
- * @param data User data pointer
+ * @param data Engine link of the library instance
  * @return 0 on success
  */
 int ng_exit(int status, bool immediate, bool quit, int id, void *data);
 
+/**
+ * @brief NGSPICE background thread status callback
+ * 
+ * Called when the background thread started by bg_run starts or ends.
+ * A thread that ends before the first time step marks startup as failed.
+ * 
+ * @param noruns True if the background thread is not running (ended)
+ * @param id Identification number (SPICE engine id)
+ * @param userdata Engine link of the library instance
+ * @return 0 on success
+ */
+int ng_bgthread_running(bool noruns, int id, void *userdata);
+
 } // namespace spice_vpi
 
 #endif // NGSPICE_CALLBACKS_H 
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "NgSpiceLibrary.h"
+#include "Debug.h"
+#include <filesystem>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+namespace spice_vpi {
+
+#ifndef _WIN32
+// Symbols of the linked libngspice that only exist in some builds
+static auto find_linked_symbol(const char *name) -> void * {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&::ngSpice_Init), &info) == 0 || info.dli_fname == nullptr) {
+        return nullptr;
+    }
+    void *handle = dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD);
+    if (handle == nullptr) {
+        return nullptr;
+    }
+    void *symbol = dlsym(handle, name);
+    dlclose(handle);
+    return symbol;
+}
+#endif
+
+auto NgSpiceLibrary::linked() -> std::unique_ptr<NgSpiceLibrary> {
+    std::unique_ptr<NgSpiceLibrary> lib(new NgSpiceLibrary());
+    lib->init_ = ::ngSpice_Init;
+    lib->init_sync_ = ::ngSpice_Init_Sync;
+    lib->command_ = ::ngSpice_Command;
+    lib->get_vec_info_ = ::ngGet_Vec_Info;
+    lib->circ_ = ::ngSpice_Circ;
+    lib->cur_plot_ = ::ngSpice_CurPlot;
+    lib->all_vecs_ = ::ngSpice_AllVecs;
+    lib->running_ = ::ngSpice_running;
+#ifndef _WIN32
+    lib->init_evt_ = reinterpret_cast<decltype(lib->init_evt_)>(find_linked_symbol("ngSpice_Init_Evt"));
+#endif
+    return lib;
+}
+
+#ifdef _WIN32
+
+auto NgSpiceLibrary::load_copy(const std::string &tag) -> std::unique_ptr<NgSpiceLibrary> {
+    throw std::runtime_error("multiple ngspice instances are not supported on this platform");
+}
+
+NgSpiceLibrary::~NgSpiceLibrary() = default;
+
+#else
+
+template<typename FuncT>
+static void load_symbol(void *handle, const char *name, FuncT &func) {
+    func = reinterpret_cast<FuncT>(dlsym(handle, name));
+    if (func == nullptr) {
+        throw std::runtime_error(std::string("symbol ") + name + " not found in ngspice library copy");
+    }
+}
+
+auto NgSpiceLibrary::load_copy(const std::string &tag) -> std::unique_ptr<NgSpiceLibrary> {
+    namespace fs = std::filesystem;
+
+    // locate the libngspice file the VPI module is linked against
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&::ngSpice_Init), &info) == 0 || info.dli_fname == nullptr) {
+        throw std::runtime_error("cannot locate the linked ngspice library");
+    }
+
+    // the dynamic loader only creates a new instance for a different file
+#ifdef __APPLE__
+    const std::string extension = ".dylib";
+#else
+    const std::string extension = ".so";
+#endif
+    fs::path copy_path = fs::temp_directory_path() / ("spicebind_ngspice_" + std::to_string(getpid()) + "_" + tag + extension);
+    std::error_code ec;
+    fs::copy_file(info.dli_fname, copy_path, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        throw std::runtime_error("cannot copy " + std::string(info.dli_fname) + " to " + copy_path.string() + ": " + ec.message());
+    }
+
+    std::unique_ptr<NgSpiceLibrary> lib(new NgSpiceLibrary());
+    lib->copy_path_ = copy_path.string();
+    // the linked library is already in the global scope; without RTLD_DEEPBIND the
+    // copy would resolve its own global functions and variables to the linked instance
+    int flags = RTLD_NOW | RTLD_LOCAL;
+#ifdef RTLD_DEEPBIND
+    flags |= RTLD_DEEPBIND;
+#endif
+    lib->handle_ = dlopen(lib->copy_path_.c_str(), flags);
+    if (lib->handle_ == nullptr) {
+        throw std::runtime_error("cannot load " + lib->copy_path_ + ": " + dlerror());
+    }
+
+    load_symbol(lib->handle_, "ngSpice_Init", lib->init_);
+    load_symbol(lib->handle_, "ngSpice_Init_Sync", lib->init_sync_);
+    load_symbol(lib->handle_, "ngSpice_Command", lib->command_);
+    load_symbol(lib->handle_, "ngGet_Vec_Info", lib->get_vec_info_);
+    load_symbol(lib->handle_, "ngSpice_Circ", lib->circ_);
+    load_symbol(lib->handle_, "ngSpice_CurPlot", lib->cur_plot_);
+    load_symbol(lib->handle_, "ngSpice_AllVecs", lib->all_vecs_);
+    load_symbol(lib->handle_, "ngSpice_running", lib->running_);
+    lib->init_evt_ = reinterpret_cast<decltype(lib->init_evt_)>(dlsym(lib->handle_, "ngSpice_Init_Evt"));
+
+    TRACE(General, "Loaded ngspice instance %s", lib->copy_path_.c_str());
+    return lib;
+}
+
+NgSpiceLibrary::~NgSpiceLibrary() {
+    if (handle_ != nullptr) {
+        dlclose(handle_);
+    }
+    if (!copy_path_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(copy_path_, ec);
+    }
+}
+
+#endif
+
+auto NgSpiceLibrary::init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata,
+                          SendInitData *sinitdata, BGThreadRunning *bgtrun, void *user_data) -> int {
+    int ret = init_(printfcn, statfcn, ngexit, sdata, sinitdata, bgtrun, user_data);
+    initialized_ = (ret == 0);
+    return ret;
+}
+
+auto NgSpiceLibrary::init_sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *user_data) -> int {
+    return init_sync_(vsrcdat, isrcdat, syncdat, ident, user_data);
+}
+
+auto NgSpiceLibrary::init_evt(EvtDataCallback *evtdata, EvtInitDataCallback *evtinitdata, void *user_data) -> int {
+    if (init_evt_ == nullptr) {
+        return -1;
+    }
+    return init_evt_(evtdata, evtinitdata, user_data);
+}
+
+auto NgSpiceLibrary::command(const std::string &command) -> int {
+    return command_(const_cast<char *>(command.c_str()));
+}
+
+auto NgSpiceLibrary::get_vec_info(const std::string &vec_name) -> pvector_info {
+    return get_vec_info_(const_cast<char *>(vec_name.c_str()));
+}
+
+auto NgSpiceLibrary::vec_length(const std::string &vec_name) -> int {
+    pvector_info info = get_vec_info(vec_name);
+    return (info != nullptr) ? info->v_length : 0;
+}
+
+auto NgSpiceLibrary::circ(char **circarray) -> int {
+    return circ_(circarray);
+}
+
+auto NgSpiceLibrary::cur_plot() -> char * {
+    return cur_plot_();
+}
+
+auto NgSpiceLibrary::all_vecs(char *plot_name) -> char ** {
+    return all_vecs_(plot_name);
+}
+
+auto NgSpiceLibrary::running() -> bool {
+    return running_();
+}
+
+void NgSpiceLibrary::set_data_callbacks_enabled(bool enabled) {
+    (void)enabled;
+}
+
+auto NgSpiceLibrary::is_remote() const -> bool {
+    return false;
+}
+
+auto NgSpiceLibrary::initialized() const -> bool {
+    return initialized_;
+}
+
+} // namespace spice_vpi
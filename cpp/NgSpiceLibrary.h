@@ -0,0 +1,105 @@
+#ifndef NGSPICE_LIBRARY_H
+#define NGSPICE_LIBRARY_H
+
+#include "ngspice/sharedspice.h"
+#include <memory>
+#include <string>
+
+namespace spice_vpi {
+
+// XSPICE event callbacks, sharedspice.h only declares them for XSPICE builds
+using EvtDataCallback = int(int, double, double, char *, void *, int, int, int, void *);
+using EvtInitDataCallback = int(int, int, char *, char *, int, void *);
+
+/**
+ * @brief One instance of the ngspice shared library API
+ *
+ * ngspice keeps its simulator state in library globals, so each concurrently
+ * running engine needs its own copy of the library. The first engine uses the
+ * libngspice linked into the VPI module; further engines dlopen() private
+ * copies of that file, each with its own globals and background thread.
+ * Subclasses may run the engine elsewhere (see NgSpiceRemote).
+ */
+class NgSpiceLibrary {
+public:
+    /**
+     * @brief The libngspice linked into the VPI module
+     */
+    static std::unique_ptr<NgSpiceLibrary> linked();
+
+    /**
+     * @brief Load a private copy of the linked libngspice as a separate instance
+     * @param tag Suffix used for the name of the copied library file
+     * @throws std::runtime_error if the library cannot be copied or loaded
+     */
+    static std::unique_ptr<NgSpiceLibrary> load_copy(const std::string &tag);
+
+    NgSpiceLibrary(const NgSpiceLibrary &) = delete;
+    NgSpiceLibrary &operator=(const NgSpiceLibrary &) = delete;
+    virtual ~NgSpiceLibrary();
+
+    virtual int init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata,
+                     SendInitData *sinitdata, BGThreadRunning *bgtrun, void *user_data);
+    virtual int init_sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *user_data);
+
+    /**
+     * @brief Register the XSPICE event node callbacks (ngSpice_Init_Evt)
+     * @return 0 on success, -1 if this ngspice was built without XSPICE
+     */
+    virtual int init_evt(EvtDataCallback *evtdata, EvtInitDataCallback *evtinitdata, void *user_data);
+    virtual int command(const std::string &command);
+    virtual pvector_info get_vec_info(const std::string &vec_name);
+
+    /**
+     * @brief Number of points of a vector, 0 if it does not exist
+     *
+     * Unlike get_vec_info(), also the full length for an engine in another process.
+     */
+    virtual int vec_length(const std::string &vec_name);
+    virtual int circ(char **circarray);
+    virtual char *cur_plot();
+    virtual char **all_vecs(char *plot_name);
+    virtual bool running();
+
+    /**
+     * @brief Tell the engine whether the SendData/SendInitData callbacks are used in this run
+     *
+     * In process they are always delivered; an engine in another process only
+     * forwards them when enabled.
+     */
+    virtual void set_data_callbacks_enabled(bool enabled);
+
+    /**
+     * @brief Check if the engine runs in another process (no fork() checkpoints)
+     */
+    virtual bool is_remote() const;
+
+    /**
+     * @brief Check if init() has been called on this instance
+     */
+    bool initialized() const;
+
+protected:
+    NgSpiceLibrary() = default;
+
+    bool initialized_ = false;
+
+private:
+
+    void *handle_ = nullptr;  // dlopen handle (nullptr for the linked library)
+    std::string copy_path_;   // temporary library copy removed on destruction
+
+    decltype(&::ngSpice_Init) init_ = nullptr;
+    decltype(&::ngSpice_Init_Sync) init_sync_ = nullptr;
+    decltype(&::ngSpice_Command) command_ = nullptr;
+    decltype(&::ngGet_Vec_Info) get_vec_info_ = nullptr;
+    decltype(&::ngSpice_Circ) circ_ = nullptr;
+    decltype(&::ngSpice_CurPlot) cur_plot_ = nullptr;
+    decltype(&::ngSpice_AllVecs) all_vecs_ = nullptr;
+    decltype(&::ngSpice_running) running_ = nullptr;
+    int (*init_evt_)(EvtDataCallback *, EvtInitDataCallback *, void *) = nullptr;  // optional
+};
+
+} // namespace spice_vpi
+
+#endif // NGSPICE_LIBRARY_H
@@ -0,0 +1,515 @@
+#include "NgSpiceRemote.h"
+#include "Debug.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char **environ;
+#endif
+
+namespace spice_vpi {
+
+static constexpr std::chrono::milliseconds POLL_INTERVAL(100);
+static constexpr std::chrono::seconds CONNECT_TIMEOUT(30);
+static constexpr std::chrono::seconds QUIT_TIMEOUT(2);
+
+#ifdef _WIN32
+
+auto NgSpiceRemote::launch(const std::string &server_path, const std::string &tag) -> std::unique_ptr<NgSpiceRemote> {
+    throw std::runtime_error("the ngspice server transport is not supported on this platform");
+}
+
+NgSpiceRemote::~NgSpiceRemote() = default;
+
+auto NgSpiceRemote::server_running() -> bool {
+    return false;
+}
+
+#else
+
+// The server is installed next to the VPI module
+static auto default_server_path() -> std::string {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&default_server_path), &info) == 0 || info.dli_fname == nullptr) {
+        throw std::runtime_error("cannot locate the spicebind VPI module");
+    }
+    std::string module_path = info.dli_fname;
+    size_t slash = module_path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : module_path.substr(0, slash);
+    return dir + "/spicebind_ngspice_server";
+}
+
+auto NgSpiceRemote::launch(const std::string &server_path, const std::string &tag) -> std::unique_ptr<NgSpiceRemote> {
+    std::string path = server_path.empty() ? default_server_path() : server_path;
+    std::string name = "/spicebind_" + std::to_string(getpid()) + "_" + tag;
+
+    ShmChannel channel = ShmChannel::create(name);
+
+    char *argv[] = {const_cast<char *>(path.c_str()), const_cast<char *>(name.c_str()), nullptr};
+    pid_t pid = 0;
+    int err = posix_spawn(&pid, path.c_str(), nullptr, nullptr, argv, environ);
+    if (err != 0) {
+        throw std::runtime_error("cannot start ngspice server " + path + ": " + std::strerror(err));
+    }
+
+    std::unique_ptr<NgSpiceRemote> remote(new NgSpiceRemote(std::move(channel), pid));
+
+    // the server reports once libngspice is initialised
+    auto deadline = std::chrono::steady_clock::now() + CONNECT_TIMEOUT;
+    ShmMessage message;
+    while (true) {
+        if (remote->channel_.receive(message, POLL_INTERVAL)) {
+            if (message.type == ShmMessage::Ready) {
+                break;
+            }
+            continue;
+        }
+        if (!remote->server_running()) {
+            throw std::runtime_error("ngspice server " + path + " exited during startup");
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            throw std::runtime_error("ngspice server " + path + " did not respond");
+        }
+    }
+    if (message.arg != 0) {
+        throw std::runtime_error("ngspice server failed to initialize ngspice");
+    }
+
+    remote->pump_ = std::thread(&NgSpiceRemote::pump, remote.get());
+    TRACE(General, "Started ngspice server pid=%d channel=%s", (int)pid, name.c_str());
+    return remote;
+}
+
+NgSpiceRemote::~NgSpiceRemote() {
+    stop_.store(true);
+    if (alive_.load()) {
+        ShmMessage quit;
+        quit.type = ShmMessage::Quit;
+        send(quit);
+    }
+    if (pump_.joinable()) {
+        pump_.join();
+    }
+    // also releases server threads still waiting for a callback reply
+    channel_.close();
+
+    auto deadline = std::chrono::steady_clock::now() + QUIT_TIMEOUT;
+    while (server_running() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // whoever takes the pid reaps it; until then the zombie keeps the pid from being reused
+    int pid = pid_.exchange(0);
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+// Reap the server if it has exited
+auto NgSpiceRemote::server_running() -> bool {
+    int pid = pid_.load();
+    if (pid <= 0) {
+        return false;
+    }
+    siginfo_t info{};
+    if (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid != pid) {
+        return true;
+    }
+    if (!pid_.compare_exchange_strong(pid, 0)) {
+        return false;  // taken by another thread
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!stop_.load()) {
+        server_lost(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+    return false;
+}
+
+#endif
+
+NgSpiceRemote::NgSpiceRemote(ShmChannel channel, int pid) : channel_(std::move(channel)), pid_(pid) {}
+
+void NgSpiceRemote::pump() {
+    ShmMessage message;
+    while (!stop_.load() && alive_.load()) {
+        if (channel_.receive(message, POLL_INTERVAL)) {
+            dispatch(message);
+        } else if (channel_.is_closed() || !server_running()) {
+            break;
+        }
+    }
+}
+
+void NgSpiceRemote::dispatch(const ShmMessage &message) {
+    switch (message.type) {
+    case ShmMessage::SrcData: {
+        std::string source = message.payload_string();
+        double value = message.value;
+        int ret = (vsrcdat_ != nullptr) ? vsrcdat_(&value, message.time, &source[0], ident_, sync_user_data_) : 0;
+        ShmMessage reply;
+        reply.type = ShmMessage::SrcReply;
+        reply.requester = ShmMessage::Callback;
+        reply.arg = ret;
+        reply.value = value;
+        send(reply);
+        break;
+    }
+    case ShmMessage::SyncData: {
+        double delta_time = message.value;
+        int ret = (syncdat_ != nullptr) ? syncdat_(message.time, &delta_time, message.value2, message.arg, ident_, message.arg2, sync_user_data_) : 0;
+        ShmMessage reply;
+        reply.type = ShmMessage::SyncReply;
+        reply.requester = ShmMessage::Callback;
+        reply.arg = ret;
+        reply.value = delta_time;
+        send(reply);
+        break;
+    }
+    case ShmMessage::BgThread:
+        if (bgtrun_ != nullptr) {
+            bgtrun_(message.arg != 0, ident_, user_data_);
+        }
+        break;
+    case ShmMessage::Print:
+        if (printfcn_ != nullptr) {
+            std::string output = message.payload_string();
+            printfcn_(&output[0], ident_, user_data_);
+        }
+        break;
+    case ShmMessage::EvtNode:
+        if (evtinitdata_ != nullptr) {
+            // name and type are stored back to back
+            std::string name = message.payload_string();
+            std::string type;
+            if (message.length > name.size() + 1) {
+                type = std::string(message.payload + name.size() + 1);
+            }
+            evtinitdata_(message.arg, message.arg2, &name[0], &type[0], ident_, evt_user_data_);
+        }
+        break;
+    case ShmMessage::EvtData:
+        if (evtdata_ != nullptr) {
+            std::string state = message.payload_string();
+            evtdata_(message.arg, message.time, message.value, &state[0], nullptr, 0, message.arg2, ident_, evt_user_data_);
+        }
+        break;
+    case ShmMessage::PlotInit: {
+        plot_ = RemotePlot();
+        plot_.type = message.payload_string();
+        if (message.length > plot_.type.size() + 1) {
+            plot_.title = std::string(message.payload + plot_.type.size() + 1);
+        }
+        plot_.expected = static_cast<size_t>(message.arg);
+        if (plot_.expected == 0) {
+            plot_ready();
+        }
+        break;
+    }
+    case ShmMessage::VecInit:
+        plot_.names.push_back(message.payload_string());
+        if (plot_.names.size() == plot_.expected) {
+            plot_ready();
+        }
+        break;
+    case ShmMessage::VecValues: {
+        size_t first = static_cast<size_t>(message.arg);
+        size_t count = message.length / sizeof(double);
+        const auto *values = reinterpret_cast<const double *>(message.payload);
+        for (size_t i = 0; i < count && first + i < plot_.values.size(); ++i) {
+            plot_.values[first + i].creal = values[i];
+        }
+        // the last part of a point completes it
+        if (first + count >= static_cast<size_t>(message.arg2) && sdata_ != nullptr && !plot_.value_ptrs.empty()) {
+            vecvaluesall all{static_cast<int>(plot_.value_ptrs.size()), plot_.point++, plot_.value_ptrs.data()};
+            sdata_(&all, all.veccount, ident_, user_data_);
+        }
+        break;
+    }
+    case ShmMessage::Exit:
+        server_lost(message.arg);
+        break;
+    case ShmMessage::CommandDone:
+    case ShmMessage::ListItem:
+    case ShmMessage::ListEnd:
+    case ShmMessage::VecInfo: {
+        std::lock_guard<std::mutex> lock(replies_mutex_);
+        replies_.push_back(message);
+        replies_cv_.notify_all();
+        break;
+    }
+    default:
+        TRACE(General, "unexpected message type=%u from ngspice server", message.type);
+        break;
+    }
+}
+
+// All vector names of a new plot arrived: report it like SendInitData
+void NgSpiceRemote::plot_ready() {
+    size_t count = plot_.names.size();
+    plot_.infos.assign(count, vecinfo{});
+    plot_.values.assign(count, vecvalues{});
+    plot_.info_ptrs.clear();
+    plot_.value_ptrs.clear();
+    for (size_t i = 0; i < count; ++i) {
+        char *name = &plot_.names[i][0];
+        plot_.infos[i].number = static_cast<int>(i);
+        plot_.infos[i].vecname = name;
+        plot_.infos[i].is_real = true;
+        plot_.values[i].name = name;
+        plot_.values[i].is_scale = (plot_.names[i] == "time");
+        plot_.info_ptrs.push_back(&plot_.infos[i]);
+        plot_.value_ptrs.push_back(&plot_.values[i]);
+    }
+
+    if (sinitdata_ != nullptr) {
+        vecinfoall all{};
+        all.type = &plot_.type[0];
+        all.title = &plot_.title[0];
+        all.name = all.type;
+        all.date = const_cast<char *>("");
+        all.veccount = static_cast<int>(count);
+        all.vecs = plot_.info_ptrs.data();
+        sinitdata_(&all, ident_, user_data_);
+    }
+}
+
+// The server exited or ngspice called controlled_exit: the engine is gone for good
+void NgSpiceRemote::server_lost(int status) {
+    if (!alive_.exchange(false)) {
+        return;
+    }
+    ERROR("ngspice server %s stopped with status %d", channel_.name().c_str(), status);
+    {
+        std::lock_guard<std::mutex> lock(replies_mutex_);
+        replies_cv_.notify_all();
+    }
+    if (bgtrun_ != nullptr) {
+        bgtrun_(true, ident_, user_data_);
+    }
+    if (ngexit_ != nullptr) {
+        ngexit_(status, true, false, ident_, user_data_);
+    }
+}
+
+auto NgSpiceRemote::send(const ShmMessage &message) -> bool {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return channel_.send(message);
+}
+
+auto NgSpiceRemote::on_pump_thread() const -> bool {
+    return std::this_thread::get_id() == pump_.get_id();
+}
+
+// Wait for the next reply to a request; the pump thread reads the channel itself
+auto NgSpiceRemote::next_reply(uint32_t requester, ShmMessage &reply) -> bool {
+    if (requester == ShmMessage::Callback) {
+        while (alive_.load()) {
+            if (channel_.receive(reply, POLL_INTERVAL)) {
+                if (reply.requester == ShmMessage::Callback) {
+                    return true;
+                }
+                dispatch(reply);
+            } else if (channel_.is_closed() || !server_running()) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(replies_mutex_);
+    replies_cv_.wait(lock, [&] { return !replies_.empty() || !alive_.load(); });
+    if (replies_.empty()) {
+        return false;
+    }
+    reply = replies_.front();
+    replies_.pop_front();
+    return true;
+}
+
+auto NgSpiceRemote::request(ShmMessage message, ShmMessage &reply) -> bool {
+    std::unique_lock<std::mutex> lock(call_mutex_, std::defer_lock);
+    if (on_pump_thread()) {
+        message.requester = ShmMessage::Callback;
+    } else {
+        lock.lock();
+        message.requester = ShmMessage::Simulator;
+    }
+
+    if (!alive_.load() || !send(message)) {
+        return false;
+    }
+    return next_reply(message.requester, reply);
+}
+
+auto NgSpiceRemote::request_list(ShmMessage message) -> std::vector<std::string> {
+    std::unique_lock<std::mutex> lock(call_mutex_, std::defer_lock);
+    if (on_pump_thread()) {
+        message.requester = ShmMessage::Callback;
+    } else {
+        lock.lock();
+        message.requester = ShmMessage::Simulator;
+    }
+
+    std::vector<std::string> items;
+    if (!alive_.load() || !send(message)) {
+        return items;
+    }
+    ShmMessage reply;
+    while (next_reply(message.requester, reply) && reply.type == ShmMessage::ListItem) {
+        items.push_back(reply.payload_string());
+    }
+    return items;
+}
+
+auto NgSpiceRemote::init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata,
+                         SendInitData *sinitdata, BGThreadRunning *bgtrun, void *user_data) -> int {
+    // the server has initialised ngspice already, only keep the callbacks
+    printfcn_ = printfcn;
+    ngexit_ = ngexit;
+    bgtrun_ = bgtrun;
+    sdata_ = sdata;
+    sinitdata_ = sinitdata;
+    user_data_ = user_data;
+    initialized_ = true;
+    return 0;
+}
+
+auto NgSpiceRemote::init_sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *user_data) -> int {
+    vsrcdat_ = vsrcdat;
+    syncdat_ = syncdat;
+    ident_ = (ident != nullptr) ? *ident : 0;
+    sync_user_data_ = user_data;
+    return 0;
+}
+
+auto NgSpiceRemote::init_evt(EvtDataCallback *evtdata, EvtInitDataCallback *evtinitdata, void *user_data) -> int {
+    evtdata_ = evtdata;
+    evtinitdata_ = evtinitdata;
+    evt_user_data_ = user_data;
+
+    ShmMessage message;
+    message.type = ShmMessage::InitEvt;
+    ShmMessage reply;
+    return request(message, reply) ? reply.arg : -1;
+}
+
+void NgSpiceRemote::set_data_callbacks_enabled(bool enabled) {
+    ShmMessage message;
+    message.type = ShmMessage::DataEnable;
+    message.arg = enabled ? 1 : 0;
+    send(message);
+}
+
+auto NgSpiceRemote::command(const std::string &command) -> int {
+    ShmMessage message;
+    message.type = ShmMessage::Command;
+    if (!message.set_payload(command)) {
+        ERROR("ngspice command too long for the server transport: %s", command.c_str());
+        return 1;
+    }
+    ShmMessage reply;
+    return request(message, reply) ? reply.arg : 1;
+}
+
+auto NgSpiceRemote::get_vec_info(const std::string &vec_name) -> pvector_info {
+    ShmMessage message;
+    message.type = ShmMessage::GetVec;
+    if (!message.set_payload(vec_name)) {
+        return nullptr;
+    }
+    ShmMessage reply;
+    if (!request(message, reply) || reply.arg < 0) {
+        return nullptr;
+    }
+
+    RemoteVector &vec = vectors_[vec_name];
+    vec.name = vec_name;
+    vec.value = reply.value;
+    vec.info.v_name = &vec.name[0];
+    vec.info.v_type = reply.arg2;
+    vec.info.v_realdata = &vec.value;
+    vec.info.v_compdata = nullptr;
+    vec.info.v_length = (reply.arg > 0) ? 1 : 0;
+    vec.length = reply.arg;
+    return &vec.info;
+}
+
+auto NgSpiceRemote::vec_length(const std::string &vec_name) -> int {
+    return (get_vec_info(vec_name) != nullptr) ? vectors_[vec_name].length : 0;
+}
+
+auto NgSpiceRemote::circ(char **circarray) -> int {
+    std::unique_lock<std::mutex> lock(call_mutex_, std::defer_lock);
+    uint32_t requester = ShmMessage::Callback;
+    if (!on_pump_thread()) {
+        lock.lock();
+        requester = ShmMessage::Simulator;
+    }
+
+    for (char **line = circarray; *line != nullptr; ++line) {
+        ShmMessage message;
+        message.type = ShmMessage::CircLine;
+        message.requester = requester;
+        if (!message.set_payload(*line)) {
+            ERROR("netlist line too long for the server transport: %s", *line);
+            return 1;
+        }
+        if (!send(message)) {
+            return 1;
+        }
+    }
+
+    ShmMessage message;
+    message.type = ShmMessage::CircEnd;
+    message.requester = requester;
+    ShmMessage reply;
+    if (!send(message) || !next_reply(requester, reply)) {
+        return 1;
+    }
+    return reply.arg;
+}
+
+auto NgSpiceRemote::cur_plot() -> char * {
+    ShmMessage message;
+    message.type = ShmMessage::CurPlot;
+    std::vector<std::string> items = request_list(message);
+    if (items.empty()) {
+        return nullptr;
+    }
+    cur_plot_ = items.front();
+    return &cur_plot_[0];
+}
+
+auto NgSpiceRemote::all_vecs(char *plot_name) -> char ** {
+    ShmMessage message;
+    message.type = ShmMessage::AllVecs;
+    message.set_payload(plot_name != nullptr ? plot_name : "");
+    list_ = request_list(message);
+
+    list_ptrs_.clear();
+    for (std::string &item : list_) {
+        list_ptrs_.push_back(&item[0]);
+    }
+    list_ptrs_.push_back(nullptr);
+    return list_ptrs_.data();
+}
+
+auto NgSpiceRemote::running() -> bool {
+    ShmMessage message;
+    message.type = ShmMessage::Running;
+    ShmMessage reply;
+    return request(message, reply) && reply.arg != 0;
+}
+
+auto NgSpiceRemote::is_remote() const -> bool {
+    return true;
+}
+
+} // namespace spice_vpi
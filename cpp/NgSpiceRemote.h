@@ -0,0 +1,127 @@
+#ifndef NGSPICE_REMOTE_H
+#define NGSPICE_REMOTE_H
+
+#include "NgSpiceLibrary.h"
+#include "ShmChannel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief ngspice running in a separate server process
+ *
+ * The server (spicebind_ngspice_server) hosts libngspice and forwards its
+ * source and sync callbacks over a shared-memory channel. A pump thread in
+ * the VPI module invokes the registered callbacks, so the time barrier
+ * works the same way as with an in-process engine. A crash or controlled
+ * exit of ngspice only ends the server; it is reported through the exit and
+ * background thread callbacks.
+ *
+ * Vector queries return only the latest sample (v_length == 1).
+ */
+class NgSpiceRemote : public NgSpiceLibrary {
+public:
+    /**
+     * @brief Start a server process and connect to it
+     * @param server_path Server executable, empty to look next to the VPI module
+     * @param tag Suffix used for the shared memory name
+     * @throws std::runtime_error if the server cannot be started
+     */
+    static std::unique_ptr<NgSpiceRemote> launch(const std::string &server_path, const std::string &tag);
+
+    ~NgSpiceRemote() override;
+
+    int init(SendChar *printfcn, SendStat *statfcn, ControlledExit *ngexit, SendData *sdata,
+             SendInitData *sinitdata, BGThreadRunning *bgtrun, void *user_data) override;
+    int init_sync(GetVSRCData *vsrcdat, GetISRCData *isrcdat, GetSyncData *syncdat, int *ident, void *user_data) override;
+    int init_evt(EvtDataCallback *evtdata, EvtInitDataCallback *evtinitdata, void *user_data) override;
+    int command(const std::string &command) override;
+    pvector_info get_vec_info(const std::string &vec_name) override;
+    int vec_length(const std::string &vec_name) override;
+    int circ(char **circarray) override;
+    char *cur_plot() override;
+    char **all_vecs(char *plot_name) override;
+    bool running() override;
+    void set_data_callbacks_enabled(bool enabled) override;
+    bool is_remote() const override;
+
+private:
+    // host copy of the latest sample of a remote vector
+    struct RemoteVector {
+        std::string name;
+        double value = 0.0;
+        int length = 0;  // points on the server, info only holds the latest
+        vector_info info{};
+    };
+
+    // plot of the vector data callbacks, rebuilt from PlotInit/VecInit messages
+    struct RemotePlot {
+        std::string type;
+        std::string title;
+        size_t expected = 0;
+        std::vector<std::string> names;
+        std::vector<vecinfo> infos;
+        std::vector<pvecinfo> info_ptrs;
+        std::vector<vecvalues> values;
+        std::vector<pvecvalues> value_ptrs;
+        int point = 0;
+    };
+
+    NgSpiceRemote(ShmChannel channel, int pid);
+
+    ShmChannel channel_;
+    std::atomic<int> pid_;  // 0 once taken for reaping
+    std::atomic<bool> alive_{true};
+    std::atomic<bool> stop_{false};
+    std::thread pump_;
+
+    std::mutex send_mutex_;
+    std::mutex call_mutex_;  // one outstanding request from the simulator threads
+    std::mutex replies_mutex_;
+    std::condition_variable replies_cv_;
+    std::deque<ShmMessage> replies_;
+
+    // callbacks registered by init()/init_sync()
+    SendChar *printfcn_ = nullptr;
+    ControlledExit *ngexit_ = nullptr;
+    BGThreadRunning *bgtrun_ = nullptr;
+    SendData *sdata_ = nullptr;
+    SendInitData *sinitdata_ = nullptr;
+    void *user_data_ = nullptr;
+    GetVSRCData *vsrcdat_ = nullptr;
+    GetSyncData *syncdat_ = nullptr;
+    int ident_ = 0;
+    void *sync_user_data_ = nullptr;
+    EvtDataCallback *evtdata_ = nullptr;
+    EvtInitDataCallback *evtinitdata_ = nullptr;
+    void *evt_user_data_ = nullptr;
+
+    std::unordered_map<std::string, RemoteVector> vectors_;
+    RemotePlot plot_;  // used by the pump thread only
+    std::string cur_plot_;
+    std::vector<std::string> list_;
+    std::vector<char *> list_ptrs_;
+
+    void pump();
+    void dispatch(const ShmMessage &message);
+    void server_lost(int status);
+    void plot_ready();
+    bool server_running();
+    bool send(const ShmMessage &message);
+    bool next_reply(uint32_t requester, ShmMessage &reply);
+    bool request(ShmMessage message, ShmMessage &reply);
+    std::vector<std::string> request_list(ShmMessage message);
+    bool on_pump_thread() const;
+};
+
+} // namespace spice_vpi
+
+#endif // NGSPICE_REMOTE_H
@@ -0,0 +1,159 @@
+#include "OperatingPointCache.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace spice_vpi {
+
+// ngspice vector type of node voltages (SV_VOLTAGE in ngspice/sim.h)
+static constexpr int NGSPICE_SV_VOLTAGE = 3;
+
+static auto read_lines(const std::string& path) -> std::vector<std::string> {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot read file '" + path + "'");
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static auto fnv1a_64(const std::string& data, uint64_t hash = 14695981039346656037ULL) -> uint64_t {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+OperatingPointCache::OperatingPointCache(const Config::Settings& config, NgSpiceLibrary& ngspice)
+    : config_(&config), ngspice_(&ngspice) {
+    if (!enabled()) {
+        return;
+    }
+    path_ = config_->op_cache_dir + "/" + compute_key() + ".op";
+    hit_ = std::ifstream(path_).good();
+    done_.store(hit_);
+}
+
+auto OperatingPointCache::enabled() const -> bool {
+    return !config_->op_cache_dir.empty();
+}
+
+auto OperatingPointCache::has_cache() const -> bool {
+    return hit_;
+}
+
+auto OperatingPointCache::path() const -> const std::string& {
+    return path_;
+}
+
+auto OperatingPointCache::compute_key() const -> std::string {
+    std::ostringstream key;
+    for (const auto& line : read_lines(config_->spice_netlist_path)) {
+        key << line << '\n';
+    }
+    // bias settings that change the settled state
+    key << std::setprecision(17) << config_->vcc_voltage << ' ' << config_->logic_threshold_low << ' '
+        << config_->logic_threshold_high << ' ' << config_->op_cache_time;
+
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << fnv1a_64(key.str());
+    return hex.str();
+}
+
+auto OperatingPointCache::netlist_lines(const std::vector<std::string>& extra_lines) const -> std::vector<std::string> {
+    std::vector<std::string> inserted;
+    if (hit_) {
+        for (const auto& line : read_lines(path_)) {
+            if (!line.empty() && line[0] != '*') {
+                inserted.push_back("." + config_->op_cache_mode + " " + line);
+            }
+        }
+    }
+    size_t ic_count = inserted.size();
+    inserted.insert(inserted.end(), extra_lines.begin(), extra_lines.end());
+
+    std::vector<std::string> lines = read_lines(config_->spice_netlist_path);
+
+    // insert before .end (or append if the netlist has none)
+    auto end_it = std::find_if(lines.begin(), lines.end(), [](const std::string& line) {
+        std::string trimmed = line.substr(0, line.find_last_not_of(" \t") + 1);
+        std::transform(trimmed.begin(), trimmed.end(), trimmed.begin(), ::tolower);
+        return trimmed == ".end";
+    });
+    bool has_end = (end_it != lines.end());
+    lines.insert(end_it, inserted.begin(), inserted.end());
+    if (!has_end) {
+        lines.emplace_back(".end");
+    }
+
+    TRACE(General, "Injected %zu cached initial conditions and %zu extra lines", ic_count, extra_lines.size());
+    return lines;
+}
+
+void OperatingPointCache::on_step(double actual_time) {
+    if (done_.load() || actual_time < config_->op_cache_time) {
+        return;
+    }
+    done_.store(true);
+
+    try {
+        save();
+    } catch (const std::exception& e) {
+        ERROR("Operating point cache: %s", e.what());
+    }
+}
+
+void OperatingPointCache::save() const {
+    char** vecs = ngspice_->all_vecs(ngspice_->cur_plot());
+    if (vecs == nullptr) {
+        throw std::runtime_error("no vectors in current plot");
+    }
+
+    std::ostringstream content;
+    content << std::setprecision(std::numeric_limits<double>::max_digits10);
+    content << "* spicebind operating point cache\n";
+    content << "* netlist: " << config_->spice_netlist_path << "\n";
+
+    size_t count = 0;
+    for (char** vec = vecs; *vec != nullptr; ++vec) {
+        pvector_info info = ngspice_->get_vec_info(*vec);
+        if (info == nullptr || info->v_type != NGSPICE_SV_VOLTAGE || info->v_realdata == nullptr || info->v_length <= 0) {
+            continue;
+        }
+        content << "v(" << *vec << ")=" << info->v_realdata[info->v_length - 1] << "\n";
+        count++;
+    }
+
+    // write to a temporary file and rename so that parallel runs never see a partial cache
+    std::string tmp_path = path_ + ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream file(tmp_path);
+        if (!file) {
+            throw std::runtime_error("cannot write '" + tmp_path + "'");
+        }
+        file << content.str();
+    }
+    if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("cannot write '" + path_ + "'");
+    }
+
+    INFO("Saved operating point cache %s (%zu nodes)", path_.c_str(), count);
+}
+
+} // namespace spice_vpi
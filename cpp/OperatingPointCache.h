@@ -0,0 +1,75 @@
+#ifndef OPERATING_POINT_CACHE_H
+#define OPERATING_POINT_CACHE_H
+
+#include "Config.h"
+#include "NgSpiceLibrary.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Warm-start cache of settled SPICE node voltages
+ *
+ * The cache file is keyed on a hash of the netlist text and the bias settings.
+ * On a miss, node voltages are captured once SPICE time reaches the configured
+ * save time. On a hit, the cached values are injected into the netlist as
+ * .ic or .nodeset lines before the simulation starts.
+ */
+class OperatingPointCache {
+public:
+    /**
+     * @brief Constructor
+     * @param config Configuration settings (cache directory, save time, mode)
+     * @param ngspice ngspice instance the node voltages are read from
+     */
+    OperatingPointCache(const Config::Settings& config, NgSpiceLibrary& ngspice);
+
+    /**
+     * @brief Check if the cache is enabled (SPICE_OP_CACHE is set)
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Check if a cache file exists for the current netlist and bias settings
+     */
+    bool has_cache() const;
+
+    /**
+     * @brief Path of the cache file for the current netlist and bias settings
+     */
+    const std::string& path() const;
+
+    /**
+     * @brief Read the netlist and insert the cached initial conditions (on a hit) and extra lines before .end
+     * @param extra_lines Lines inserted after the initial conditions, e.g. solver options
+     * @return Netlist lines ready to be passed to ngSpice_Circ
+     * @throws std::runtime_error if the netlist or cache file cannot be read
+     */
+    std::vector<std::string> netlist_lines(const std::vector<std::string>& extra_lines) const;
+
+    /**
+     * @brief Save node voltages once SPICE time reaches the save time
+     *
+     * Called from the ngspice thread at the end of each step. Does nothing on
+     * a cache hit or after the values have been saved.
+     *
+     * @param actual_time Current SPICE simulation time in seconds
+     */
+    void on_step(double actual_time);
+
+private:
+    const Config::Settings* config_;
+    NgSpiceLibrary* ngspice_;
+    std::string path_;
+    bool hit_ = false;
+    std::atomic<bool> done_{false};
+
+    std::string compute_key() const;
+    void save() const;
+};
+
+} // namespace spice_vpi
+
+#endif // OPERATING_POINT_CACHE_H
@@ -0,0 +1,465 @@
+#include "OutputStub.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace spice_vpi {
+
+namespace {
+
+constexpr char OUTPUTS_MAGIC[8] = {'S', 'B', 'O', 'U', 'T', 'S', '0', '1'};
+constexpr size_t WRITE_BUFFER = 1 << 16;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+template <typename T>
+void put(FILE *file, T value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T>
+auto get(FILE *file, T &value) -> bool {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+void put_string(FILE *file, const std::string &value) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+    put<uint16_t>(file, length);
+    std::fwrite(value.data(), 1, length, file);
+}
+
+auto get_string(FILE *file, std::string &value) -> bool {
+    uint16_t length = 0;
+    if (!get(file, length)) {
+        return false;
+    }
+    value.assign(length, '\0');
+    return length == 0 || std::fread(&value[0], 1, length, file) == length;
+}
+
+auto hash_bytes(uint64_t hash, const void *data, size_t size) -> uint64_t {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+auto current_time() -> unsigned long long {
+    s_vpi_time simtime;
+    simtime.type = vpiSimTime;
+    vpi_get_time(nullptr, &simtime);
+    return (simtime.high * (1ULL << 32)) + simtime.low;
+}
+
+// Input value as compared between runs: all bits including x/z, or the real value
+auto input_value(vpiHandle net, bool real) -> std::string {
+    s_vpi_value val;
+    if (real) {
+        val.format = vpiRealVal;
+        vpi_get_value(net, &val);
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.17g", val.value.real);
+        return text;
+    }
+    val.format = vpiBinStrVal;
+    vpi_get_value(net, &val);
+    return (val.value.str != nullptr) ? val.value.str : "";
+}
+
+} // namespace
+
+void InputLog::change(uint16_t id, unsigned long long time, const std::string &value, std::vector<Change> &settled) {
+    if (!pending_.empty() && time != time_) {
+        flush(settled);
+    }
+    time_ = time;
+    pending_[id] = value;
+}
+
+void InputLog::flush(std::vector<Change> &settled) {
+    for (auto &[id, value] : pending_) {
+        auto last = last_.find(id);
+        if (last != last_.end() && last->second == value) {
+            continue;  // changed back within the time step
+        }
+        last_[id] = value;
+
+        hash_ = hash_bytes(hash_, &time_, sizeof(time_));
+        hash_ = hash_bytes(hash_, &id, sizeof(id));
+        hash_ = hash_bytes(hash_, value.c_str(), value.size() + 1);
+        ++count_;
+        settled.push_back(Change{time_, id, value});
+    }
+    pending_.clear();
+}
+
+auto InputLog::hash() const -> uint64_t {
+    return hash_;
+}
+
+auto InputLog::count() const -> unsigned long long {
+    return count_;
+}
+
+OutputRecorder::OutputRecorder(const std::string &file_name, unsigned long long time_precision) : file_name_(file_name) {
+    file_ = std::fopen(file_name_.c_str(), "wb");
+    if (file_ == nullptr) {
+        throw std::runtime_error("cannot create output recording " + file_name_);
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER);
+    std::fwrite(OUTPUTS_MAGIC, 1, sizeof(OUTPUTS_MAGIC), file_);
+    put<uint64_t>(file_, time_precision);
+}
+
+OutputRecorder::~OutputRecorder() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+auto OutputRecorder::port(vpiHandle handle, int direction, int bit_index) -> Port * {
+    auto it = ids_.find(handle);
+    if (it != ids_.end()) {
+        return &ports_[it->second];
+    }
+
+    const char *full_name = vpi_get_str(vpiFullName, handle);
+    if (full_name == nullptr) {
+        return nullptr;
+    }
+    // vector bits are found again by index on their net, as add_port binds them
+    std::string name = full_name;
+    if (bit_index >= 0 && !name.empty() && name.back() == ']') {
+        name = name.substr(0, name.rfind('['));
+    }
+    std::string key = name + "#" + std::to_string(bit_index);
+
+    auto named = names_.find(key);
+    if (named != names_.end()) {
+        ids_[handle] = named->second;
+        return &ports_[named->second];
+    }
+    if (ports_.size() >= UINT16_MAX) {
+        return nullptr;
+    }
+
+    Port entry;
+    entry.id = static_cast<uint16_t>(ports_.size());
+    entry.real = vpi_get(vpiType, handle) == vpiRealVar;
+    ports_.push_back(entry);
+    ids_[handle] = entry.id;
+    names_[key] = entry.id;
+
+    if (file_ != nullptr) {
+        put<char>(file_, 'P');
+        put<uint16_t>(file_, entry.id);
+        put<uint8_t>(file_, static_cast<uint8_t>(direction == vpiInput ? 'i' : 'o'));
+        put<uint8_t>(file_, entry.real ? 1 : 0);
+        put<int32_t>(file_, bit_index);
+        put_string(file_, name);
+    }
+    return &ports_.back();
+}
+
+void OutputRecorder::add_input(vpiHandle net) {
+    port(net, vpiInput, -1);
+}
+
+void OutputRecorder::input_changed(vpiHandle net) {
+    Port *input = port(net, vpiInput, -1);
+    if (input == nullptr || file_ == nullptr) {
+        return;
+    }
+    inputs_.change(input->id, current_time(), input_value(net, input->real), settled_);
+    write_changes();
+}
+
+void OutputRecorder::write_changes() {
+    for (const InputLog::Change &change : settled_) {
+        put<char>(file_, 'I');
+        put<uint16_t>(file_, change.id);
+        put<uint64_t>(file_, change.time);
+        put_string(file_, change.value);
+    }
+    settled_.clear();
+}
+
+void OutputRecorder::output(vpiHandle handle, int bit_index, const s_vpi_value &value) {
+    Port *output = port(handle, vpiOutput, bit_index);
+    if (output == nullptr || file_ == nullptr) {
+        return;
+    }
+    double new_value = (value.format == vpiRealVal) ? value.value.real : static_cast<double>(value.value.scalar);
+    if (output->written && output->last_value == new_value) {
+        return;  // same logic level as before
+    }
+    output->written = true;
+    output->last_value = new_value;
+
+    put<char>(file_, 'O');
+    put<uint16_t>(file_, output->id);
+    put<uint64_t>(file_, current_time());
+    put<double>(file_, new_value);
+}
+
+void OutputRecorder::close() {
+    if (file_ == nullptr) {
+        return;
+    }
+    inputs_.flush(settled_);
+    write_changes();
+    put<char>(file_, 'E');
+    put<uint64_t>(file_, current_time());
+    put<uint64_t>(file_, inputs_.hash());
+    put<uint64_t>(file_, inputs_.count());
+    std::fclose(file_);
+    file_ = nullptr;
+    INFO("Outputs recorded to %s (stimulus hash %016llx)", file_name_.c_str(), static_cast<unsigned long long>(inputs_.hash()));
+}
+
+auto OutputRecorder::file_name() const -> const std::string & {
+    return file_name_;
+}
+
+OutputStub::OutputStub(const std::string &file_name) : file_name_(file_name) {
+    FILE *file = std::fopen(file_name.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot open output recording " + file_name);
+    }
+
+    char magic[sizeof(OUTPUTS_MAGIC)];
+    uint64_t time_precision = 0;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, OUTPUTS_MAGIC, sizeof(magic)) != 0 ||
+        !get(file, time_precision)) {
+        std::fclose(file);
+        throw std::runtime_error(file_name + " is not a spicebind output recording");
+    }
+    time_precision_ = time_precision;
+
+    char type = 0;
+    while (get(file, type)) {
+        if (type == 'P') {
+            uint16_t id = 0;
+            uint8_t direction = 0;
+            uint8_t real = 0;
+            int32_t bit_index = -1;
+            Port port;
+            if (!get(file, id) || !get(file, direction) || !get(file, real) || !get(file, bit_index) || !get_string(file, port.name)) {
+                break;
+            }
+            port.direction = (direction == 'i') ? vpiInput : vpiOutput;
+            port.real = real != 0;
+            port.bit_index = bit_index;
+            ports_.resize(std::max<size_t>(ports_.size(), id + 1u));
+            ports_[id] = port;
+        } else if (type == 'I') {
+            InputLog::Change change;
+            uint64_t time = 0;
+            if (!get(file, change.id) || !get(file, time) || !get_string(file, change.value)) {
+                break;
+            }
+            change.time = time;
+            recorded_inputs_.push_back(change);
+            end_time_ = std::max<unsigned long long>(end_time_, time);
+        } else if (type == 'O') {
+            OutputEvent event{};
+            uint64_t time = 0;
+            if (!get(file, event.id) || !get(file, time) || !get(file, event.value)) {
+                break;
+            }
+            event.time = time;
+            outputs_.push_back(event);
+            end_time_ = std::max<unsigned long long>(end_time_, time);
+        } else if (type == 'E') {
+            uint64_t time = 0;
+            uint64_t hash = 0;
+            uint64_t changes = 0;
+            has_end_ = get(file, time) && get(file, hash) && get(file, changes);
+            end_time_ = time;
+            recorded_hash_ = hash;
+            break;
+        } else {
+            break;
+        }
+    }
+    std::fclose(file);
+}
+
+auto OutputStub::start(unsigned long long time_precision) -> bool {
+    if (time_precision != time_precision_) {
+        ERROR("%s was recorded with a time precision of %llu ticks/s, the simulator uses %llu", file_name_.c_str(), time_precision_, time_precision);
+        return false;
+    }
+    if (!has_end_) {
+        WARN("%s has no end record, the recording run did not finish", file_name_.c_str());
+    }
+
+    watches_.reserve(ports_.size());
+    size_t inputs = 0;
+    for (size_t id = 0; id < ports_.size(); ++id) {
+        Port &port = ports_[id];
+        vpiHandle net = vpi_handle_by_name(const_cast<char *>(port.name.c_str()), nullptr);
+        port.handle = (net != nullptr && port.bit_index >= 0) ? vpi_handle_by_index(net, port.bit_index) : net;
+        if (port.handle == nullptr) {
+            ERROR("port %s of %s not found in the design", port.name.c_str(), file_name_.c_str());
+            return false;
+        }
+
+        if (port.direction == vpiInput) {
+            watches_.push_back(InputWatch{this, static_cast<uint16_t>(id)});
+            s_cb_data cb_data_s;
+            cb_data_s.reason = cbValueChange;
+            cb_data_s.cb_rtn = input_cb;
+            cb_data_s.obj = port.handle;
+            cb_data_s.time = nullptr;
+            cb_data_s.value = nullptr;
+            cb_data_s.user_data = reinterpret_cast<PLI_BYTE8 *>(&watches_.back());
+            callbacks_.push_back(vpi_register_cb(&cb_data_s));
+            ++inputs;
+        }
+    }
+
+    INFO("Replaying %zu output values until %g s from %s, watching %zu inputs (ngspice is not started)", outputs_.size(),
+         static_cast<double>(end_time_) / static_cast<double>(time_precision_), file_name_.c_str(), inputs);
+    started_ = true;
+    schedule_outputs(current_time());
+    return true;
+}
+
+void OutputStub::schedule_outputs(unsigned long long current_time) {
+    if (next_output_ >= outputs_.size()) {
+        return;
+    }
+    unsigned long long delay = outputs_[next_output_].time - current_time;
+
+    s_vpi_time next_delay;
+    next_delay.type = vpiSimTime;
+    next_delay.high = static_cast<PLI_UINT32>(delay >> 32);
+    next_delay.low = static_cast<PLI_UINT32>(delay & 0xffffffffULL);
+
+    s_cb_data cb_data_s;
+    cb_data_s.reason = cbAfterDelay;
+    cb_data_s.cb_rtn = output_cb;
+    cb_data_s.obj = nullptr;
+    cb_data_s.time = &next_delay;
+    cb_data_s.value = nullptr;
+    cb_data_s.user_data = reinterpret_cast<PLI_BYTE8 *>(this);
+    output_cb_handle_ = vpi_register_cb(&cb_data_s);
+}
+
+auto OutputStub::output_cb(p_cb_data cb_data_p) -> PLI_INT32 {
+    auto *stub = reinterpret_cast<OutputStub *>(cb_data_p->user_data);
+    stub->output_cb_handle_ = nullptr;
+    unsigned long long now = current_time();
+
+    while (stub->next_output_ < stub->outputs_.size() && stub->outputs_[stub->next_output_].time <= now) {
+        const OutputEvent &event = stub->outputs_[stub->next_output_++];
+        const Port &port = stub->ports_[event.id];
+
+        s_vpi_value val;
+        if (port.real) {
+            val.format = vpiRealVal;
+            val.value.real = event.value;
+        } else {
+            val.format = vpiScalarVal;
+            val.value.scalar = static_cast<PLI_INT32>(event.value);
+        }
+        vpi_put_value(port.handle, &val, nullptr, vpiNoDelay);
+        TRACE(Port, "Stub output %s = %g", port.name.c_str(), event.value);
+    }
+
+    stub->schedule_outputs(now);
+    return 0;
+}
+
+auto OutputStub::input_cb(p_cb_data cb_data_p) -> PLI_INT32 {
+    auto *watch = reinterpret_cast<InputWatch *>(cb_data_p->user_data);
+    OutputStub *stub = watch->stub;
+    const Port &port = stub->ports_[watch->id];
+
+    stub->inputs_.change(watch->id, current_time(), input_value(port.handle, port.real), stub->settled_);
+    stub->compare(stub->settled_);
+    stub->settled_.clear();
+    return 0;
+}
+
+auto OutputStub::describe(const InputLog::Change &change) const -> std::string {
+    char time[32];
+    std::snprintf(time, sizeof(time), "%g", static_cast<double>(change.time) / static_cast<double>(time_precision_));
+    std::string name = (change.id < ports_.size()) ? ports_[change.id].name : "?";
+    return name + " = " + change.value + " at " + time + " s";
+}
+
+void OutputStub::compare(const std::vector<InputLog::Change> &settled) {
+    for (const InputLog::Change &change : settled) {
+        if (diverged_) {
+            return;
+        }
+        if (next_input_ >= recorded_inputs_.size()) {
+            report_divergence(describe(change) + " after the last recorded change");
+            return;
+        }
+
+        const InputLog::Change &expected = recorded_inputs_[next_input_];
+        if (expected.time == change.time && expected.id == change.id && expected.value == change.value) {
+            ++next_input_;
+            continue;
+        }
+        report_divergence(describe(change) + ", recorded " + describe(expected));
+    }
+}
+
+void OutputStub::report_divergence(const std::string &message) {
+    diverged_ = true;
+    ERROR("Stub inputs diverged from %s: %s; the replayed outputs no longer follow the inputs", file_name_.c_str(), message.c_str());
+}
+
+void OutputStub::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    for (vpiHandle cb_handle : callbacks_) {
+        vpi_remove_cb(cb_handle);
+    }
+    callbacks_.clear();
+    if (output_cb_handle_ != nullptr) {
+        vpi_remove_cb(output_cb_handle_);
+        output_cb_handle_ = nullptr;
+    }
+    if (!started_) {
+        return;
+    }
+
+    inputs_.flush(settled_);
+    compare(settled_);
+    settled_.clear();
+
+    unsigned long long now = current_time();
+    auto seconds = [this](unsigned long long ticks) { return static_cast<double>(ticks) / static_cast<double>(time_precision_); };
+    if (!diverged_ && next_input_ < recorded_inputs_.size() && recorded_inputs_[next_input_].time <= now) {
+        report_divergence("recorded " + describe(recorded_inputs_[next_input_]) + " did not happen");
+    }
+    if (diverged_) {
+        return;
+    }
+
+    if (next_input_ == recorded_inputs_.size() && inputs_.hash() == recorded_hash_) {
+        INFO("Stub inputs match %s (stimulus hash %016llx), %zu of %zu output values replayed", file_name_.c_str(),
+             static_cast<unsigned long long>(recorded_hash_), next_output_, outputs_.size());
+    } else {
+        INFO("Stub inputs match %s up to %g s (the recording ends at %g s)", file_name_.c_str(), seconds(now), seconds(end_time_));
+    }
+    if (has_end_ && now > end_time_) {
+        WARN("Simulation ran %g s past the end of %s, the outputs held their last recorded values", seconds(now - end_time_),
+             file_name_.c_str());
+    }
+}
+
+auto OutputStub::diverged() const -> bool {
+    return diverged_;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,220 @@
+#ifndef OUTPUT_STUB_H
+#define OUTPUT_STUB_H
+
+#include "vpi_user.h"
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Settled input changes of the HDL instances and their running hash
+ *
+ * Value changes are collected per HDL time step; when time advances, each
+ * input whose final value in the step differs from its previous one yields a
+ * change, in input id order. Delta-cycle glitches and the order of changes
+ * within a step therefore do not matter, and the recorded and the stubbed run
+ * produce the same sequence as long as their inputs match.
+ */
+class InputLog {
+public:
+    struct Change {
+        unsigned long long time;  // HDL time in ticks
+        uint16_t id;
+        std::string value;
+    };
+
+    /**
+     * @brief Note a value change
+     * @param settled Receives the changes settled by earlier time steps
+     */
+    void change(uint16_t id, unsigned long long time, const std::string &value, std::vector<Change> &settled);
+
+    /**
+     * @brief Settle the changes of the current time step
+     */
+    void flush(std::vector<Change> &settled);
+
+    /**
+     * @brief FNV-1a hash of all settled changes so far, the key of the stimulus
+     */
+    uint64_t hash() const;
+
+    /**
+     * @brief Number of settled changes so far
+     */
+    unsigned long long count() const;
+
+private:
+    unsigned long long time_ = 0;
+    std::map<uint16_t, std::string> pending_;
+    std::unordered_map<uint16_t, std::string> last_;
+    uint64_t hash_ = 14695981039346656037ULL;
+    unsigned long long count_ = 0;
+};
+
+/**
+ * @brief Records the outputs written to the HDL and the inputs read from it (SPICE_RECORD_OUTPUTS)
+ *
+ * The recording lets a later run replace the SPICE partitions by an
+ * OutputStub. Outputs are recorded from set_digital_output, inputs from their
+ * value-change callbacks of the driving partitions. Called from the HDL thread.
+ *
+ * File layout (little endian):
+ *
+ *     "SBOUTS01"  u64 time precision (HDL ticks per second)
+ *     'P' u16 id  u8 direction  u8 real  i32 bit  u16 length  name   port (bit -1 for scalars)
+ *     'I' u16 id  u64 time  u16 length  value    settled input change (binary string or %.17g)
+ *     'O' u16 id  u64 time  f64 value            output written (volts for real ports, else vpi0/vpi1/vpiX)
+ *     'E' u64 time  u64 hash  u64 changes        end of the recording with the input hash
+ */
+class OutputRecorder {
+public:
+    /**
+     * @brief Create the file and write its header
+     * @throws std::runtime_error if the file cannot be created
+     */
+    OutputRecorder(const std::string &file_name, unsigned long long time_precision);
+
+    OutputRecorder(const OutputRecorder &) = delete;
+    OutputRecorder &operator=(const OutputRecorder &) = delete;
+    ~OutputRecorder();
+
+    /**
+     * @brief Register an input net, so inputs that never change are known to the stub
+     */
+    void add_input(vpiHandle net);
+
+    /**
+     * @brief Record the new value of an input net
+     */
+    void input_changed(vpiHandle net);
+
+    /**
+     * @brief Record a value written to an output
+     * @param handle Output net or bit
+     * @param bit_index Bit of a vector port, -1 for scalars
+     * @param value Value passed to vpi_put_value
+     */
+    void output(vpiHandle handle, int bit_index, const s_vpi_value &value);
+
+    /**
+     * @brief Settle the last inputs, write the end record and close the file
+     */
+    void close();
+
+    const std::string &file_name() const;
+
+private:
+    struct Port {
+        uint16_t id = 0;
+        bool real = false;
+        double last_value = 0.0;
+        bool written = false;
+    };
+
+    Port *port(vpiHandle handle, int direction, int bit_index);
+    void write_changes();
+
+    FILE *file_ = nullptr;
+    std::string file_name_;
+    std::vector<Port> ports_;
+    std::unordered_map<vpiHandle, uint16_t> ids_;
+    std::unordered_map<std::string, uint16_t> names_;  // callback handles may differ from the registered ones
+    InputLog inputs_;
+    std::vector<InputLog::Change> settled_;
+};
+
+/**
+ * @brief Replays recorded outputs into the HDL instead of running ngspice (SPICE_STUB_OUTPUTS)
+ *
+ * The recorded output values are written with vpi_put_value at their recorded
+ * times from a chain of delay callbacks. The inputs are watched and compared
+ * with the recording: the first input that no longer matches is reported, since
+ * the replayed outputs are only valid for the recorded stimulus.
+ */
+class OutputStub {
+public:
+    /**
+     * @brief Read a recording written by OutputRecorder
+     * @throws std::runtime_error if the file cannot be read or is not an output recording
+     */
+    explicit OutputStub(const std::string &file_name);
+
+    OutputStub(const OutputStub &) = delete;
+    OutputStub &operator=(const OutputStub &) = delete;
+
+    /**
+     * @brief Bind the recorded ports, watch the inputs and schedule the first outputs
+     * @param time_precision HDL time precision in ticks per second, must match the recording
+     * @return false on error (already reported)
+     */
+    bool start(unsigned long long time_precision);
+
+    /**
+     * @brief Settle the last inputs, compare them with the recording and remove the callbacks
+     */
+    void finish();
+
+    /**
+     * @brief Check if the inputs differed from the recording
+     */
+    bool diverged() const;
+
+private:
+    struct Port {
+        std::string name;
+        int direction;
+        bool real;
+        int bit_index;
+        vpiHandle handle = nullptr;
+    };
+
+    struct OutputEvent {
+        unsigned long long time;
+        uint16_t id;
+        double value;
+    };
+
+    struct InputWatch {
+        OutputStub *stub;
+        uint16_t id;
+    };
+
+    static PLI_INT32 output_cb(p_cb_data cb_data_p);
+    static PLI_INT32 input_cb(p_cb_data cb_data_p);
+
+    void schedule_outputs(unsigned long long current_time);
+    void compare(const std::vector<InputLog::Change> &settled);
+    void report_divergence(const std::string &message);
+    std::string describe(const InputLog::Change &change) const;
+
+    std::string file_name_;
+    unsigned long long time_precision_ = 0;
+    unsigned long long end_time_ = 0;
+    uint64_t recorded_hash_ = 0;
+    bool has_end_ = false;
+
+    std::vector<Port> ports_;
+    std::vector<OutputEvent> outputs_;
+    size_t next_output_ = 0;
+    std::vector<InputLog::Change> recorded_inputs_;
+    size_t next_input_ = 0;
+
+    InputLog inputs_;
+    std::vector<InputLog::Change> settled_;
+    std::vector<InputWatch> watches_;
+    std::vector<vpiHandle> callbacks_;
+    vpiHandle output_cb_handle_ = nullptr;
+    bool started_ = false;
+    bool diverged_ = false;
+    bool finished_ = false;
+};
+
+} // namespace spice_vpi
+
+#endif // OUTPUT_STUB_H
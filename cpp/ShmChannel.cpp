@@ -0,0 +1,278 @@
+#include "ShmChannel.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+
+namespace spice_vpi {
+
+static constexpr uint32_t SHM_MAGIC = 0x53424e47;  // "SBNG"
+static constexpr int SPIN_LIMIT = 2000;  // spins before sleeping on the doorbell (multi-core only)
+static constexpr std::chrono::milliseconds DOORBELL_SLICE(10);
+
+struct ShmChannel::Ring {
+    static constexpr uint32_t SLOTS = 64;
+
+    alignas(64) std::atomic<uint32_t> head{0};  // written by the producer
+    alignas(64) std::atomic<uint32_t> tail{0};  // written by the consumer
+    alignas(64) std::atomic<uint32_t> consumer_waiting{0};
+    std::atomic<uint32_t> producer_waiting{0};
+    ShmMessage slots[SLOTS];
+};
+
+struct ShmChannel::Layout {
+    uint32_t magic = SHM_MAGIC;
+    std::atomic<uint32_t> closed{0};
+    Ring to_server;
+    Ring to_host;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory atomics must be lock-free");
+
+auto ShmMessage::set_payload(const std::string &text) -> bool {
+    if (text.size() >= PAYLOAD_SIZE) {
+        return false;
+    }
+    std::memcpy(payload, text.c_str(), text.size() + 1);
+    length = static_cast<uint32_t>(text.size() + 1);
+    return true;
+}
+
+auto ShmMessage::payload_string() const -> std::string {
+    if (length == 0) {
+        return std::string();
+    }
+    return std::string(payload, strnlen(payload, std::min<size_t>(length, PAYLOAD_SIZE)));
+}
+
+// Spinning only helps when the other side runs on another core
+static auto spin_limit() -> int {
+    static const int limit = (std::thread::hardware_concurrency() > 1) ? SPIN_LIMIT : 0;
+    return limit;
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Sleep until the word no longer holds the expected value (or the timeout expires)
+static void doorbell_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout) {
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    (void)timeout;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+static void doorbell_ring(std::atomic<uint32_t> &word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+#ifdef _WIN32
+
+auto ShmChannel::create(const std::string &name) -> ShmChannel {
+    throw std::runtime_error("shared memory transport is not supported on this platform");
+}
+
+auto ShmChannel::open(const std::string &name) -> ShmChannel {
+    throw std::runtime_error("shared memory transport is not supported on this platform");
+}
+
+ShmChannel::~ShmChannel() = default;
+
+#else
+
+auto ShmChannel::create(const std::string &name) -> ShmChannel {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("cannot create shared memory " + name + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, sizeof(Layout)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("cannot size shared memory " + name + ": " + std::strerror(errno));
+    }
+    void *mem = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("cannot map shared memory " + name + ": " + std::strerror(errno));
+    }
+    return ShmChannel(name, new (mem) Layout(), Side::Host, true);
+}
+
+auto ShmChannel::open(const std::string &name) -> ShmChannel {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open shared memory " + name + ": " + std::strerror(errno));
+    }
+    void *mem = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        throw std::runtime_error("cannot map shared memory " + name + ": " + std::strerror(errno));
+    }
+    auto *layout = static_cast<Layout *>(mem);
+    if (layout->magic != SHM_MAGIC) {
+        munmap(mem, sizeof(Layout));
+        throw std::runtime_error("shared memory " + name + " is not a spicebind channel");
+    }
+    return ShmChannel(name, layout, Side::Server, false);
+}
+
+ShmChannel::~ShmChannel() {
+    if (layout_ != nullptr) {
+        munmap(layout_, sizeof(Layout));
+        if (owner_) {
+            shm_unlink(name_.c_str());
+        }
+    }
+}
+
+#endif
+
+ShmChannel::ShmChannel(const std::string &name, Layout *layout, Side side, bool owner)
+    : name_(name), layout_(layout), side_(side), owner_(owner) {}
+
+ShmChannel::ShmChannel(ShmChannel &&other) noexcept
+    : name_(std::move(other.name_)), layout_(other.layout_), side_(other.side_), owner_(other.owner_) {
+    other.layout_ = nullptr;
+    other.owner_ = false;
+}
+
+auto ShmChannel::operator=(ShmChannel &&other) noexcept -> ShmChannel & {
+    if (this != &other) {
+        std::swap(name_, other.name_);
+        std::swap(layout_, other.layout_);
+        std::swap(side_, other.side_);
+        std::swap(owner_, other.owner_);
+    }
+    return *this;
+}
+
+auto ShmChannel::tx() -> Ring & {
+    return side_ == Side::Host ? layout_->to_server : layout_->to_host;
+}
+
+auto ShmChannel::rx() -> Ring & {
+    return side_ == Side::Host ? layout_->to_host : layout_->to_server;
+}
+
+auto ShmChannel::send(const ShmMessage &message) -> bool {
+    Ring &ring = tx();
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+
+    int spins = 0;
+    while (head - ring.tail.load(std::memory_order_acquire) >= Ring::SLOTS) {
+        if (is_closed()) {
+            return false;
+        }
+        if (++spins < spin_limit()) {
+            cpu_relax();
+            continue;
+        }
+        ring.producer_waiting.store(1);
+        uint32_t tail = ring.tail.load();
+        if (head - tail >= Ring::SLOTS) {
+            doorbell_wait(ring.tail, tail, DOORBELL_SLICE);
+        }
+        ring.producer_waiting.store(0, std::memory_order_relaxed);
+    }
+
+    // copy the header and the used part of the payload only
+    size_t size = offsetof(ShmMessage, payload) + std::min<size_t>(message.length, ShmMessage::PAYLOAD_SIZE);
+    std::memcpy(&ring.slots[head % Ring::SLOTS], &message, size);
+    ring.head.store(head + 1);
+
+    if (ring.consumer_waiting.load() != 0) {
+        doorbell_ring(ring.head);
+    }
+    return true;
+}
+
+auto ShmChannel::receive(ShmMessage &message, std::chrono::milliseconds timeout) -> bool {
+    Ring &ring = rx();
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    int spins = 0;
+    while (ring.head.load(std::memory_order_acquire) == tail) {
+        if (is_closed()) {
+            return false;
+        }
+        if (++spins < spin_limit()) {
+            cpu_relax();
+            continue;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        ring.consumer_waiting.store(1);
+        if (ring.head.load() == tail) {
+            doorbell_wait(ring.head, tail, std::min(remaining, DOORBELL_SLICE));
+        }
+        ring.consumer_waiting.store(0, std::memory_order_relaxed);
+    }
+
+    const ShmMessage &slot = ring.slots[tail % Ring::SLOTS];
+    size_t size = offsetof(ShmMessage, payload) + std::min<size_t>(slot.length, ShmMessage::PAYLOAD_SIZE);
+    std::memcpy(&message, &slot, size);
+    ring.tail.store(tail + 1);
+
+    if (ring.producer_waiting.load() != 0) {
+        doorbell_ring(ring.tail);
+    }
+    return true;
+}
+
+void ShmChannel::close() {
+    if (layout_ == nullptr) {
+        return;
+    }
+    layout_->closed.store(1);
+    for (Ring *ring : {&layout_->to_server, &layout_->to_host}) {
+        doorbell_ring(ring->head);
+        doorbell_ring(ring->tail);
+    }
+}
+
+auto ShmChannel::is_closed() const -> bool {
+    return layout_ == nullptr || layout_->closed.load(std::memory_order_acquire) != 0;
+}
+
+auto ShmChannel::name() const -> const std::string & {
+    return name_;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,148 @@
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace spice_vpi {
+
+/**
+ * @brief Fixed-size message exchanged between the VPI module and the ngspice server
+ */
+struct ShmMessage {
+    enum Type : uint32_t {
+        // host -> server
+        Command = 1,     // payload: ngspice command, reply CommandDone
+        CircLine,        // payload: one netlist line
+        CircEnd,         // load the collected lines with ngSpice_Circ, reply CommandDone
+        Running,         // reply CommandDone with arg = ngSpice_running()
+        CurPlot,         // reply ListItem with the plot name + ListEnd
+        AllVecs,         // payload: plot name, reply ListItem per vector + ListEnd
+        GetVec,          // payload: vector name, reply VecInfo
+        SrcReply,        // value: source value
+        SyncReply,       // arg: return value, value: delta time
+        Quit,            // stop the server
+        InitEvt,         // register the XSPICE event callbacks, reply CommandDone (-1 without XSPICE)
+        DataEnable,      // arg: forward the vector data callbacks (1) or not (0), no reply
+        // server -> host
+        Ready,           // arg: ngSpice_Init return value
+        CommandDone,     // arg: return value
+        ListItem,        // payload: string
+        ListEnd,
+        VecInfo,         // arg: v_length (-1 if not found), arg2: v_type, value: last sample
+        SrcData,         // payload: source name, time, value: current source value
+        SyncData,        // time: actual time, value: delta, value2: old delta, arg: redostep, arg2: location
+        BgThread,        // arg: noruns
+        Print,           // payload: ngspice output line
+        Exit,            // arg: exit status
+        EvtNode,         // arg: node index, arg2: max index, payload: node name '\0' node type
+        EvtData,         // arg: node index, arg2: mode, time: step, value: real value, payload: state string
+        PlotInit,        // arg: vector count, payload: plot type '\0' title, followed by one VecInit per vector
+        VecInit,         // arg: vector number, payload: vector name
+        VecValues,       // arg: first vector, arg2: vector count, payload: real values (doubles)
+    };
+
+    // Thread that issued a request; replies carry the same value
+    enum Requester : uint32_t {
+        Simulator = 0,   // HDL simulator thread, served in order behind blocking commands
+        Callback = 1,    // ngspice callback in progress, served immediately
+    };
+
+    static constexpr size_t PAYLOAD_SIZE = 1024;
+
+    uint32_t type = 0;
+    uint32_t requester = Simulator;
+    int32_t arg = 0;
+    int32_t arg2 = 0;
+    uint32_t length = 0;
+    double time = 0.0;
+    double value = 0.0;
+    double value2 = 0.0;
+    char payload[PAYLOAD_SIZE] = {};
+
+    /**
+     * @brief Store a string in the payload
+     * @return false if the string does not fit
+     */
+    bool set_payload(const std::string &text);
+
+    /**
+     * @brief Payload as a string
+     */
+    std::string payload_string() const;
+};
+
+/**
+ * @brief Bidirectional message channel in POSIX shared memory
+ *
+ * Two single-producer/single-consumer rings, one per direction. Producers and
+ * consumers only touch their own index; a consumer that finds its ring empty
+ * spins briefly and then sleeps on a futex doorbell (Linux) or polls (other
+ * platforms). Several threads of one process may send on the same side if
+ * they serialise their calls to send().
+ */
+class ShmChannel {
+public:
+    enum class Side { Host, Server };
+
+    /**
+     * @brief Create and initialise a new channel (host side)
+     * @param name Shared memory object name (starting with '/')
+     * @throws std::runtime_error if the shared memory cannot be created
+     */
+    static ShmChannel create(const std::string &name);
+
+    /**
+     * @brief Attach to a channel created by the host (server side)
+     * @throws std::runtime_error if the shared memory cannot be opened
+     */
+    static ShmChannel open(const std::string &name);
+
+    ShmChannel(ShmChannel &&other) noexcept;
+    ShmChannel &operator=(ShmChannel &&other) noexcept;
+    ShmChannel(const ShmChannel &) = delete;
+    ShmChannel &operator=(const ShmChannel &) = delete;
+    ~ShmChannel();
+
+    /**
+     * @brief Send a message to the other side, waiting while the ring is full
+     * @return false if the channel was closed
+     */
+    bool send(const ShmMessage &message);
+
+    /**
+     * @brief Receive the next message from the other side
+     * @param message Output message
+     * @param timeout Maximum time to wait
+     * @return false on timeout or if the channel was closed
+     */
+    bool receive(ShmMessage &message, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Mark the channel closed and wake both sides
+     */
+    void close();
+
+    bool is_closed() const;
+    const std::string &name() const;
+
+private:
+    struct Layout;
+    struct Ring;
+
+    ShmChannel(const std::string &name, Layout *layout, Side side, bool owner);
+
+    std::string name_;
+    Layout *layout_ = nullptr;
+    Side side_ = Side::Host;
+    bool owner_ = false;  // unlinks the shared memory object on destruction
+
+    Ring &tx();
+    Ring &rx();
+};
+
+} // namespace spice_vpi
+
+#endif // SHM_CHANNEL_H
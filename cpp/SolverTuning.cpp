@@ -0,0 +1,113 @@
+#include "SolverTuning.h"
+#include <algorithm>
+#include <thread>
+
+namespace spice_vpi {
+
+auto SolverChoice::netlist_options() const -> std::vector<std::string> {
+    if (solver == "default") {
+        return {};
+    }
+    return {".options " + solver};
+}
+
+auto SolverChoice::threads_command() const -> std::string {
+    return (threads == 0) ? std::string() : "set num_threads=" + std::to_string(threads);
+}
+
+auto SolverChoice::describe() const -> std::string {
+    std::string text = (solver == "default") ? "netlist solver" : solver;
+    if (threads == 0) {
+        return text + ", default threads";
+    }
+    return text + ", " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+}
+
+auto SolverTuner::candidates(const Config::Settings &config) -> std::vector<SolverChoice> {
+    std::vector<std::string> solvers = {config.solver};
+    if (config.solver == "auto") {
+        solvers = {"klu", "sparse"};
+    }
+
+    std::vector<unsigned> threads = {config.threads};
+    if (config.threads_auto) {
+        // powers of two up to the hardware threads, plus the hardware threads themselves
+        unsigned hardware = std::max(1U, std::thread::hardware_concurrency());
+        threads.clear();
+        for (unsigned n = 1; n < hardware; n *= 2) {
+            threads.push_back(n);
+        }
+        threads.push_back(hardware);
+    }
+
+    std::vector<SolverChoice> candidates;
+    for (const std::string &solver : solvers) {
+        for (unsigned count : threads) {
+            candidates.push_back(SolverChoice{solver, count});
+        }
+    }
+    return candidates;
+}
+
+auto SolverTuner::fastest(const std::vector<SolverTrial> &trials) -> size_t {
+    size_t best = trials.size();
+    for (size_t i = 0; i < trials.size(); ++i) {
+        if (trials[i].steps > 0 && (best == trials.size() || trials[i].step_wall_s < trials[best].step_wall_s)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void SolverTuner::begin(size_t steps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    target_ = steps;
+    steps_ = 0;
+    done_ = false;
+}
+
+void SolverTuner::step() {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (done_) {
+            return;
+        }
+        // the first step ends after the operating point, time from there
+        if (steps_ == 0) {
+            first_ = now;
+        }
+        last_ = now;
+        if (++steps_ <= target_) {
+            return;
+        }
+        done_ = true;
+    }
+    cv_.notify_all();
+}
+
+void SolverTuner::finished() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    cv_.notify_all();
+}
+
+auto SolverTuner::wait(std::chrono::milliseconds timeout) -> bool {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [&] { return done_; });
+}
+
+auto SolverTuner::result(const SolverChoice &choice) const -> SolverTrial {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SolverTrial trial;
+    trial.choice = choice;
+    trial.steps = (steps_ > 0) ? steps_ - 1 : 0;
+    if (trial.steps > 0) {
+        trial.step_wall_s = std::chrono::duration<double>(last_ - first_).count() / static_cast<double>(trial.steps);
+    }
+    return trial;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,103 @@
+#ifndef SOLVER_TUNING_H
+#define SOLVER_TUNING_H
+
+#include "Config.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Matrix solver and device evaluation threads of an ngspice run (SPICE_SOLVER, SPICE_THREADS)
+ */
+struct SolverChoice {
+    std::string solver = "default";  // "default" keeps the netlist's options, else "klu" or "sparse"
+    unsigned threads = 0;            // 0 keeps ngspice's default
+
+    /**
+     * @brief Lines added to the netlist before .end, empty for the default solver
+     */
+    std::vector<std::string> netlist_options() const;
+
+    /**
+     * @brief ngspice command setting the thread count before the circuit is loaded, empty for the default
+     */
+    std::string threads_command() const;
+
+    /**
+     * @brief Readable form, e.g. "klu, 4 threads"
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief Timing of the first steps of one candidate
+ */
+struct SolverTrial {
+    SolverChoice choice;
+    size_t steps = 0;          // accepted steps timed, fewer than asked if the run ended or timed out
+    double step_wall_s = 0.0;  // wall time per accepted step
+};
+
+/**
+ * @brief Times the first accepted steps of a tuning run
+ *
+ * The ngspice thread reports each accepted step and the end of its run; the
+ * starting thread waits until the requested number of steps has been timed.
+ * The first step, which includes the operating point, is not timed.
+ */
+class SolverTuner {
+public:
+    /**
+     * @brief Candidates of the configured solver and thread settings, one if there is nothing to tune
+     */
+    static std::vector<SolverChoice> candidates(const Config::Settings &config);
+
+    /**
+     * @brief Index of the trial with the lowest wall time per step
+     * @return trials.size() if no trial timed a step
+     */
+    static size_t fastest(const std::vector<SolverTrial> &trials);
+
+    /**
+     * @brief Prepare for a run timing up to `steps` steps
+     */
+    void begin(size_t steps);
+
+    /**
+     * @brief An accepted step ended (ngspice thread)
+     */
+    void step();
+
+    /**
+     * @brief The background thread of the run ended (ngspice thread)
+     */
+    void finished();
+
+    /**
+     * @brief Wait for the steps to be timed or the run to end
+     * @return false on timeout
+     */
+    bool wait(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Timing of the run of a candidate
+     */
+    SolverTrial result(const SolverChoice &choice) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t target_ = 0;
+    size_t steps_ = 0;
+    bool done_ = false;
+    std::chrono::steady_clock::time_point first_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+} // namespace spice_vpi
+
+#endif // SOLVER_TUNING_H
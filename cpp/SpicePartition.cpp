@@ -0,0 +1,370 @@
+#include "SpicePartition.h"
+#include "Debug.h"
+#include "NgSpiceCallbacks.h"
+#include <chrono>
+#include <exception>
+#include <vector>
+
+namespace spice_vpi {
+
+SpicePartition::SpicePartition(int engine_id, const Config::Settings &config, Barrier &barrier, NgSpiceLibrary &ngspice, EngineLink &link)
+    : engine_id_(engine_id), config_(config), barrier_(barrier), ngspice_(ngspice), link_(link), adaptive_(config_) {
+    interface_ = std::make_unique<AnalogDigitalInterface>(config_, ngspice_);
+    op_cache_ = std::make_unique<OperatingPointCache>(config_, ngspice_);
+}
+
+SpicePartition::~SpicePartition() {
+    SpicePartition *self = this;
+    link_.partition.compare_exchange_strong(self, nullptr);
+}
+
+auto SpicePartition::start() -> bool {
+    // ngSpice_Init is called once per library instance, later runs reuse it, so its
+    // callbacks get the engine link (which outlives partitions) and the engine id as ident
+    link_.barrier = &barrier_;
+    link_.partition = this;
+    if (!ngspice_.initialized()) {
+        if (ngspice_.init(ng_printf, nullptr, ng_exit, ng_data, ng_init_data, ng_bgthread_running, &link_) != 0) {
+            ERROR("Failed to initialize ngspice.");
+            return false;
+        }
+    }
+    ngspice_.set_data_callbacks_enabled(waveform_stream_ != nullptr || analog_trace_ != nullptr);
+
+    // digital outputs driven by XSPICE event nodes, not available without XSPICE
+    if (ngspice_.init_evt(ng_evt_data, ng_evt_init, this) != 0) {
+        TRACE(General, "ngspice without XSPICE event callbacks");
+    }
+
+    if (!select_solver()) {
+        return false;
+    }
+    if (!solver_.threads_command().empty()) {
+        ngspice_.command(solver_.threads_command());
+    }
+
+    if (!load_netlist()) {
+        return false;
+    }
+
+    if (config_.save_mode == "bound") {
+        restrict_saves();
+    }
+
+    // keep the history on the .tran step grid instead of every accepted step
+    if (config_.save_grid == "on") {
+        ngspice_.command("set interp");
+    }
+
+    // start tight, the activity of the ports decides when to loosen
+    if (adaptive_.enabled()) {
+        ngspice_.command(adaptive_.tight_command());
+    }
+
+    if (ngspice_.init_sync(ng_srcdata, nullptr, ng_sync, &engine_id_, this) != 0) {
+        ERROR("Failed to initialize ngSpice_Init_Sync interface.");
+        return false;
+    }
+
+    barrier_.set_spice_running(true, engine_id_);
+    ngspice_.command("bg_run");
+    return true;
+}
+
+// Pick the configured solver, or time the first steps of each candidate and keep the fastest
+auto SpicePartition::select_solver() -> bool {
+    std::vector<SolverChoice> candidates = SolverTuner::candidates(config_);
+    solver_ = candidates.front();
+    solver_trials_.clear();
+
+    if (candidates.size() > 1) {
+        if (ngspice_.is_remote()) {
+            WARN("Solver tuning is not available with SPICE_TRANSPORT=server, using %s", solver_.describe().c_str());
+        } else if (!tune_solver(candidates)) {
+            return false;
+        }
+    }
+
+    if (solver_.solver != "default" || solver_.threads != 0) {
+        INFO("Solver for %s: %s", config_.spice_netlist_path.c_str(), solver_.describe().c_str());
+    }
+    return true;
+}
+
+// Run the netlist with each candidate on its own callbacks, outside the time barrier
+auto SpicePartition::tune_solver(const std::vector<SolverChoice> &candidates) -> bool {
+    const auto timeout = std::chrono::milliseconds(static_cast<long long>(config_.spice_startup_timeout * 1000.0));
+    link_.tuning = true;
+    for (const SolverChoice &candidate : candidates) {
+        solver_ = candidate;
+        if (!solver_.threads_command().empty()) {
+            ngspice_.command(solver_.threads_command());
+        }
+        if (!load_netlist()) {
+            link_.tuning = false;
+            return false;
+        }
+        if (ngspice_.init_sync(ng_tune_srcdata, nullptr, ng_tune_sync, &engine_id_, this) != 0) {
+            ERROR("Failed to initialize ngSpice_Init_Sync interface.");
+            link_.tuning = false;
+            return false;
+        }
+
+        solver_tuner_.begin(config_.tune_steps);
+        ngspice_.command("bg_run");
+        if (!solver_tuner_.wait(timeout)) {
+            WARN("Solver tuning: %s did not finish %zu steps in %g s", candidate.describe().c_str(), config_.tune_steps,
+                 config_.spice_startup_timeout);
+        }
+        halt();
+        solver_trials_.push_back(solver_tuner_.result(candidate));
+        remove_circuit();
+
+        const SolverTrial &trial = solver_trials_.back();
+        INFO("Solver tuning for %s: %s, %.3g us per step over %zu steps", config_.spice_netlist_path.c_str(), candidate.describe().c_str(),
+             trial.step_wall_s * 1e6, trial.steps);
+    }
+    link_.tuning = false;
+
+    size_t best = SolverTuner::fastest(solver_trials_);
+    if (best == solver_trials_.size()) {
+        WARN("Solver tuning: no candidate completed a step, using %s", candidates.front().describe().c_str());
+        best = 0;
+    }
+    solver_ = candidates[best];
+    return true;
+}
+
+auto SpicePartition::load_netlist() -> bool {
+    std::vector<std::string> options = solver_.netlist_options();
+    if (op_cache_->has_cache() || !options.empty()) {
+        return load_netlist_lines(options);
+    }
+    ngspice_.command(config_.spice_netlist_path);
+    return true;
+}
+
+// Load the netlist through ngSpice_Circ with the cached operating point and solver options injected
+auto SpicePartition::load_netlist_lines(const std::vector<std::string> &extra_lines) -> bool {
+    std::vector<std::string> lines;
+    try {
+        lines = op_cache_->netlist_lines(extra_lines);
+    } catch (const std::exception &e) {
+        ERROR("Loading %s: %s", config_.spice_netlist_path.c_str(), e.what());
+        return false;
+    }
+
+    // resolve .include/.lib relative to the netlist directory
+    std::string netlist_dir = config_.spice_netlist_path;
+    size_t slash = netlist_dir.find_last_of("/\\");
+    netlist_dir = (slash == std::string::npos) ? "." : netlist_dir.substr(0, slash);
+    ngspice_.command("set sourcepath = ( " + netlist_dir + " )");
+
+    std::vector<char *> circarray;
+    circarray.reserve(lines.size() + 1);
+    for (std::string &line : lines) {
+        circarray.push_back(const_cast<char *>(line.c_str()));
+    }
+    circarray.push_back(nullptr);
+
+    return ngspice_.circ(circarray.data()) == 0;
+}
+
+// Keep only the vectors the co-simulation reads or was asked for (SPICE_SAVE=bound)
+void SpicePartition::restrict_saves() {
+    if (op_cache_->enabled() && !op_cache_->has_cache()) {
+        INFO("SPICE_SAVE=bound ignored while the operating point cache is filled: it needs all node voltages");
+        return;
+    }
+
+    // the scale is always kept, ngspice does not accept it in the save list
+    std::string command = "save";
+    for (const std::string &name : interface_->get_analog_output_names()) {
+        command += " " + name;
+    }
+    for (const std::string &name : config_.save_nodes) {
+        command += " " + name;
+    }
+    for (const std::string &name : config_.dump_vectors) {
+        command += " " + name;
+    }
+    if (analog_trace_ != nullptr) {
+        for (const auto &[port, vector] : interface_->get_port_vectors()) {
+            command += " " + vector;
+        }
+        for (const std::string &name : config_.trace_nodes) {
+            command += " " + name;
+        }
+    }
+    if (command == "save") {
+        INFO("SPICE_SAVE=bound ignored for %s: no bound output or listed vector to keep", config_.spice_netlist_path.c_str());
+        return;
+    }
+    TRACE(General, "%s", command.c_str());
+    ngspice_.command(command);
+}
+
+auto SpicePartition::history_usage() -> HistoryUsage {
+    HistoryUsage usage;
+    char *plot = ngspice_.cur_plot();
+    char **vecs = (plot != nullptr) ? ngspice_.all_vecs(plot) : nullptr;
+    for (char **vec = vecs; vec != nullptr && *vec != nullptr; ++vec) {
+        usage.vectors++;
+    }
+    int points = ngspice_.vec_length("time");
+    if (points > 0) {
+        usage.points = static_cast<size_t>(points);
+    }
+    return usage;
+}
+
+void SpicePartition::halt() {
+    ngspice_.command("bg_halt");
+}
+
+void SpicePartition::request_pause(unsigned long long time) {
+    pause_time_.store(time);
+}
+
+auto SpicePartition::pause_time() const -> unsigned long long {
+    return pause_time_.load();
+}
+
+void SpicePartition::clear_pause() {
+    pause_time_.store(NO_PAUSE);
+}
+
+void SpicePartition::write(const std::string &file_name) {
+    // ngspice_.command("set filetype=ascii");
+    ngspice_.command("write " + file_name);
+}
+
+void SpicePartition::open_waveform_stream(const std::string &file_name) {
+    waveform_stream_ = std::make_unique<WaveformStream>(file_name, config_.dump_vectors, config_.dump_chunk_points);
+}
+
+void SpicePartition::close_waveform_stream() {
+    if (waveform_stream_ != nullptr) {
+        waveform_stream_->close();
+    }
+}
+
+auto SpicePartition::waveform_stream() -> WaveformStream * {
+    return waveform_stream_.get();
+}
+
+void SpicePartition::open_analog_trace(const std::string &file_name) {
+    analog_trace_ = std::make_unique<AnalogTrace>(file_name, config_.time_precision, config_.trace_tolerance);
+
+    // ports under their HDL instance, extra nodes under "spice"
+    for (const auto &[port, vector] : interface_->get_port_vectors()) {
+        size_t dot = port.rfind('.');
+        if (dot != std::string::npos) {
+            analog_trace_->add_signal(port.substr(0, dot), port.substr(dot + 1), vector);
+        } else {
+            analog_trace_->add_signal(config_.hdl_instance_names.front(), port, vector);
+        }
+    }
+    for (const std::string &name : config_.trace_nodes) {
+        analog_trace_->add_signal("spice", name, name);
+    }
+}
+
+void SpicePartition::close_analog_trace() {
+    if (analog_trace_ != nullptr) {
+        analog_trace_->close();
+    }
+}
+
+auto SpicePartition::analog_trace() -> AnalogTrace * {
+    return analog_trace_.get();
+}
+
+void SpicePartition::open_stimulus_record(const std::string &file_name) {
+    stimulus_recorder_ = std::make_unique<StimulusRecorder>(file_name, config_.time_precision);
+}
+
+void SpicePartition::close_stimulus_record(double end_time) {
+    if (stimulus_recorder_ != nullptr) {
+        stimulus_recorder_->close(end_time);
+    }
+}
+
+auto SpicePartition::stimulus_recorder() -> StimulusRecorder * {
+    return stimulus_recorder_.get();
+}
+
+void SpicePartition::remove_circuit() {
+    ngspice_.command("remcirc");
+    ngspice_.command("destroy all");
+}
+
+auto SpicePartition::is_corner() const -> bool {
+    return !config_.corner_name.empty();
+}
+
+auto SpicePartition::engine_id() const -> int {
+    return engine_id_;
+}
+
+auto SpicePartition::config() const -> const Config::Settings & {
+    return config_;
+}
+
+auto SpicePartition::barrier() -> Barrier & {
+    return barrier_;
+}
+
+auto SpicePartition::ngspice() -> NgSpiceLibrary & {
+    return ngspice_;
+}
+
+auto SpicePartition::interface() -> AnalogDigitalInterface & {
+    return *interface_;
+}
+
+auto SpicePartition::op_cache() -> OperatingPointCache & {
+    return *op_cache_;
+}
+
+auto SpicePartition::stats() -> PartitionStats & {
+    return stats_;
+}
+
+auto SpicePartition::redo_cost() -> RedoCost & {
+    return redo_cost_;
+}
+
+auto SpicePartition::solver() const -> const SolverChoice & {
+    return solver_;
+}
+
+auto SpicePartition::solver_trials() const -> const std::vector<SolverTrial> & {
+    return solver_trials_;
+}
+
+auto SpicePartition::solver_tuner() -> SolverTuner & {
+    return solver_tuner_;
+}
+
+auto SpicePartition::adaptive() -> AdaptiveTolerance & {
+    return adaptive_;
+}
+
+auto SpicePartition::inputs_changed() const -> bool {
+    return inputs_changed_;
+}
+
+void SpicePartition::set_inputs_changed(bool changed) {
+    inputs_changed_ = changed;
+}
+
+auto SpicePartition::no_redo_inputs_changed() const -> bool {
+    return no_redo_inputs_changed_;
+}
+
+void SpicePartition::set_no_redo_inputs_changed(bool changed) {
+    no_redo_inputs_changed_ = changed;
+}
+
+} // namespace spice_vpi
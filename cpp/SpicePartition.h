@@ -0,0 +1,251 @@
+#ifndef SPICE_PARTITION_H
+#define SPICE_PARTITION_H
+
+#include "TimeBarrier.h"
+#include "Config.h"
+#include "AdaptiveTolerance.h"
+#include "AnalogDigitalInterface.h"
+#include "AnalogTrace.h"
+#include "NgSpiceLibrary.h"
+#include "OperatingPointCache.h"
+#include "SolverTuning.h"
+#include "Stats.h"
+#include "StimulusRecord.h"
+#include "WaveformStream.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spice_vpi {
+
+class SpicePartition;
+
+/**
+ * @brief User data of the callbacks registered with ngSpice_Init
+ *
+ * ngSpice_Init is called once per library instance, so its callbacks get a
+ * link that outlives the partitions and points to the one currently using
+ * the library (nullptr between runs).
+ */
+struct EngineLink {
+    TimeBarrier<unsigned long long> *barrier = nullptr;
+    std::atomic<SpicePartition *> partition{nullptr};
+    std::atomic<bool> tuning{false};  // solver tuning runs, not part of the co-simulation
+};
+
+/**
+ * @brief One ngspice engine with its netlist and bound HDL instances
+ * 
+ * Each partition runs its own ngspice instance in its own background thread
+ * and takes part in the session's time barrier with its own engine id.
+ * The partition is passed as user data to the ngspice callbacks.
+ */
+class SpicePartition {
+public:
+    using Barrier = TimeBarrier<unsigned long long>;
+
+    static constexpr unsigned long long NO_PAUSE = ~0ULL;
+
+    /**
+     * @brief Analog history ngspice keeps for the current plot
+     */
+    struct HistoryUsage {
+        size_t points = 0;   // time points of the plot
+        size_t vectors = 0;  // saved vectors, including the scale
+        size_t bytes() const { return points * vectors * sizeof(double); }
+    };
+
+    /**
+     * @brief Constructor
+     * @param engine_id SPICE engine id in the time barrier
+     * @param config Settings of this partition (netlist and HDL instances)
+     * @param barrier Time barrier shared by all partitions of the session
+     * @param ngspice ngspice library instance used by this partition
+     * @param link Callback link of the library instance
+     */
+    SpicePartition(int engine_id, const Config::Settings &config, Barrier &barrier, NgSpiceLibrary &ngspice, EngineLink &link);
+
+    SpicePartition(const SpicePartition &) = delete;
+    SpicePartition &operator=(const SpicePartition &) = delete;
+    ~SpicePartition();
+
+    /**
+     * @brief Initialise ngspice, load the netlist and start the background run
+     * 
+     * Does not wait for ngspice to reach its first time step.
+     * 
+     * @return false on error (already reported)
+     */
+    bool start();
+
+    /**
+     * @brief Matrix solver and thread count of the run
+     */
+    const SolverChoice &solver() const;
+
+    /**
+     * @brief Timings of the candidates when the solver was tuned, empty otherwise
+     */
+    const std::vector<SolverTrial> &solver_trials() const;
+
+    /**
+     * @brief Step counter of the solver tuning runs, fed by ng_tune_sync
+     */
+    SolverTuner &solver_tuner();
+
+    /**
+     * @brief Halt the ngspice background thread
+     */
+    void halt();
+
+    /**
+     * @brief Ask ngspice to pause its analysis at the step ending at `time` (HDL thread)
+     *
+     * ng_sync keeps the steps from passing `time` and sets a stop breakpoint on
+     * the step ending there, so ngspice pauses right after accepting it.
+     */
+    void request_pause(unsigned long long time);
+
+    /**
+     * @brief Step end of the pending pause request, NO_PAUSE if there is none
+     */
+    unsigned long long pause_time() const;
+
+    /**
+     * @brief Drop the pending pause request once its breakpoint is set or it timed out
+     */
+    void clear_pause();
+
+    /**
+     * @brief Write all vectors of the current plot to a raw file
+     * @param file_name Output file name
+     */
+    void write(const std::string &file_name);
+
+    /**
+     * @brief Stream vectors to a raw file during the run (SPICE_DUMP=stream)
+     *
+     * Must be called before start().
+     *
+     * @param file_name Output file name
+     * @throws std::runtime_error if the file cannot be created
+     */
+    void open_waveform_stream(const std::string &file_name);
+
+    /**
+     * @brief Finish the raw file of open_waveform_stream()
+     */
+    void close_waveform_stream();
+
+    /**
+     * @brief Stream written from the ngspice data callbacks (nullptr if not streaming)
+     */
+    WaveformStream *waveform_stream();
+
+    /**
+     * @brief Trace the bound ports and SPICE_FST_NODES in HDL time (SPICE_FST)
+     *
+     * Must be called after the ports are bound and before start().
+     *
+     * @param file_name Output file name (".vcd" for VCD, FST otherwise)
+     * @throws std::runtime_error if the file cannot be created
+     */
+    void open_analog_trace(const std::string &file_name);
+
+    /**
+     * @brief Finish the file of open_analog_trace()
+     */
+    void close_analog_trace();
+
+    /**
+     * @brief Trace written from the ngspice data callbacks (nullptr if not tracing)
+     */
+    AnalogTrace *analog_trace();
+
+    /**
+     * @brief Record the source values ngspice consumes (SPICE_RECORD_STIMULUS)
+     * @param file_name Output file
+     * @throws std::runtime_error if the file cannot be created
+     */
+    void open_stimulus_record(const std::string &file_name);
+
+    /**
+     * @brief Finish the file of open_stimulus_record()
+     * @param end_time HDL time in seconds the recording is valid until
+     */
+    void close_stimulus_record(double end_time);
+
+    /**
+     * @brief Recorder written from ng_srcdata (nullptr if not recording)
+     */
+    StimulusRecorder *stimulus_recorder();
+
+    /**
+     * @brief Analog history retained by ngspice so far, in process or in the server
+     */
+    HistoryUsage history_usage();
+
+    /**
+     * @brief Remove the circuit and its vectors, keeping ngspice loaded
+     */
+    void remove_circuit();
+
+    /**
+     * @brief Check if this partition is a corner that only monitors its outputs
+     */
+    bool is_corner() const;
+
+    int engine_id() const;
+    const Config::Settings &config() const;
+    Barrier &barrier();
+    NgSpiceLibrary &ngspice();
+    AnalogDigitalInterface &interface();
+    OperatingPointCache &op_cache();
+    PartitionStats &stats();
+    RedoCost &redo_cost();
+    AdaptiveTolerance &adaptive();
+
+    /**
+     * @brief Flag set when an input of this partition changed since the last timestep
+     */
+    bool inputs_changed() const;
+    void set_inputs_changed(bool changed);
+
+    /**
+     * @brief Flag set when an input without redo (SPICE_NO_REDO_INPUTS) changed since the last timestep
+     */
+    bool no_redo_inputs_changed() const;
+    void set_no_redo_inputs_changed(bool changed);
+
+private:
+    int engine_id_;
+    Config::Settings config_;
+    Barrier &barrier_;
+    NgSpiceLibrary &ngspice_;
+    EngineLink &link_;
+    std::unique_ptr<AnalogDigitalInterface> interface_;
+    std::unique_ptr<OperatingPointCache> op_cache_;
+    std::unique_ptr<WaveformStream> waveform_stream_;
+    std::unique_ptr<AnalogTrace> analog_trace_;
+    std::unique_ptr<StimulusRecorder> stimulus_recorder_;
+    PartitionStats stats_;
+    RedoCost redo_cost_;
+    AdaptiveTolerance adaptive_;
+    SolverChoice solver_;
+    std::vector<SolverTrial> solver_trials_;
+    SolverTuner solver_tuner_;
+    bool inputs_changed_ = false;
+    bool no_redo_inputs_changed_ = false;
+    std::atomic<unsigned long long> pause_time_{NO_PAUSE};
+
+    bool select_solver();
+    bool tune_solver(const std::vector<SolverChoice> &candidates);
+    bool load_netlist();
+    void restrict_saves();
+    bool load_netlist_lines(const std::vector<std::string> &extra_lines);
+};
+
+} // namespace spice_vpi
+
+#endif // SPICE_PARTITION_H
@@ -0,0 +1,362 @@
+#include "Stats.h"
+#include "Debug.h"
+#include "CoSimSession.h"
+#include "vpi_user.h"
+#include <algorithm>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace spice_vpi {
+
+static auto seconds(std::chrono::nanoseconds duration) -> double {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Peak resident set size of the simulator process (0 where unknown)
+static auto peak_rss_bytes() -> unsigned long long {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<unsigned long long>(usage.ru_maxrss);  // bytes
+#else
+    return static_cast<unsigned long long>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#endif
+}
+
+void RedoCost::mark_dirty(const char *port) {
+    if (port == nullptr) {
+        return;
+    }
+    if (std::find(dirty_.begin(), dirty_.end(), port) == dirty_.end()) {
+        dirty_.emplace_back(port);
+    }
+}
+
+void RedoCost::request() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a rollback that is still pending gets the new ports as well
+    for (std::string &port : dirty_) {
+        if (std::find(pending_.begin(), pending_.end(), port) == pending_.end()) {
+            pending_.push_back(std::move(port));
+        }
+    }
+    dirty_.clear();
+}
+
+void RedoCost::performed(double step_s, double time_s) {
+    double wall_s = 0.0;
+    if (step_start_.time_since_epoch().count() != 0) {
+        wall_s = seconds(std::chrono::steady_clock::now() - step_start_);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+        pending_.emplace_back();
+    }
+    for (const std::string &port : pending_) {
+        auto cost = std::find_if(costs_.begin(), costs_.end(), [&](const PortCost &entry) { return entry.port == port; });
+        if (cost == costs_.end()) {
+            cost = costs_.insert(costs_.end(), PortCost());
+            cost->port = port;
+        }
+        cost->redos++;
+        cost->shared += (pending_.size() > 1) ? 1 : 0;
+        cost->discarded_s += step_s;
+        cost->discarded_wall_s += wall_s;
+        if (step_s > cost->max_step_s) {
+            cost->max_step_s = step_s;
+            cost->max_step_time_s = time_s;
+        }
+    }
+    pending_.clear();
+}
+
+void RedoCost::step_accepted() {
+    step_start_ = std::chrono::steady_clock::now();
+}
+
+auto RedoCost::per_port() const -> std::vector<PortCost> {
+    std::vector<PortCost> costs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        costs = costs_;
+    }
+    std::sort(costs.begin(), costs.end(), [](const PortCost &a, const PortCost &b) {
+        return (a.discarded_wall_s != b.discarded_wall_s) ? a.discarded_wall_s > b.discarded_wall_s : a.port < b.port;
+    });
+    return costs;
+}
+
+static auto barrier_stats(const CoSimSession::Barrier::WaitStats &wait) -> StatsReport::BarrierStats {
+    StatsReport::BarrierStats stats;
+    stats.updates = wait.updates;
+    stats.waits = wait.waits;
+    stats.blocked_s = seconds(wait.blocked);
+    return stats;
+}
+
+auto StatsReport::collect(CoSimSession &session, unsigned long long hdl_time, bool with_history) -> StatsReport {
+    StatsReport report;
+    const Config::Settings &config = session.config();
+    if (config.time_precision != 0) {
+        report.sim_time_s_ = static_cast<double>(hdl_time) / static_cast<double>(config.time_precision);
+    }
+    const SessionStats &session_stats = session.stats();
+    if (session_stats.wall_start.time_since_epoch().count() != 0) {
+        report.wall_time_s_ = seconds(std::chrono::steady_clock::now() - session_stats.wall_start);
+    }
+    report.timestep_callbacks_ = session_stats.timestep_callbacks.get();
+    report.peak_rss_bytes_ = peak_rss_bytes();
+    if (session.has_started()) {
+        report.hdl_barrier_ = barrier_stats(session.barrier().wait_stats(CoSimSession::Barrier::HDL_ENGINE_ID));
+    }
+
+    for (const auto &partition : session.partitions()) {
+        const PartitionStats &stats = partition->stats();
+        Partition entry;
+        entry.name = partition->is_corner() ? partition->config().corner_name : partition->config().hdl_instance_names.front();
+        entry.netlist = partition->config().spice_netlist_path;
+        entry.engine_id = partition->engine_id();
+        entry.sync_end_of_step = stats.sync_end_of_step.get();
+        entry.sync_start_of_step = stats.sync_start_of_step.get();
+        entry.sync_redostep = stats.sync_redostep.get();
+        entry.redos_requested = stats.redos_requested.get();
+        entry.redos_performed = stats.redos_performed.get();
+        entry.redos_cancelled = stats.redos_cancelled.get();
+        entry.input_events = stats.input_events.get();
+        entry.output_events = stats.output_events.get();
+        entry.sources = partition->interface().source_requests();
+        entry.redo_cost = partition->redo_cost().per_port();
+        entry.barrier = barrier_stats(session.barrier().wait_stats(partition->engine_id()));
+        entry.solver = partition->solver();
+        entry.solver_trials = partition->solver_trials();
+        entry.adaptive = partition->adaptive().enabled();
+        entry.adaptive_loose = partition->adaptive().loose();
+        entry.tolerance_loosened = partition->adaptive().loosened();
+        entry.tolerance_tightened = partition->adaptive().tightened();
+
+        // the vectors are only safe to read while ngspice is halted
+        if (with_history) {
+            SpicePartition::HistoryUsage usage = partition->history_usage();
+            entry.has_history = true;
+            entry.history_points = usage.points;
+            entry.history_vectors = usage.vectors;
+            entry.history_bytes = usage.bytes();
+        }
+        report.partitions_.push_back(std::move(entry));
+    }
+    return report;
+}
+
+void StatsReport::print() const {
+    double ratio = (wall_time_s_ > 0.0) ? sim_time_s_ / wall_time_s_ : 0.0;
+    char line[512];
+    std::snprintf(line, sizeof(line), "spicebind stats at %g s sim time, %.3f s wall time (sim/wall %g), peak RSS %.1f MiB", sim_time_s_,
+                  wall_time_s_, ratio, static_cast<double>(peak_rss_bytes_) / (1024.0 * 1024.0));
+    std::string text = line;
+
+    std::snprintf(line, sizeof(line), "\n   hdl: %llu timestep callbacks, blocked %.3f s in %llu of %llu barrier updates",
+                  timestep_callbacks_, hdl_barrier_.blocked_s, hdl_barrier_.waits, hdl_barrier_.updates);
+    text += line;
+
+    for (const Partition &partition : partitions_) {
+        const char *name = partition.name.c_str();
+        std::snprintf(line, sizeof(line), "\n   %s (engine %d): %llu steps, %llu step starts, %llu step repeats", name, partition.engine_id,
+                      partition.sync_end_of_step, partition.sync_start_of_step, partition.sync_redostep);
+        text += line;
+        std::snprintf(line, sizeof(line), "\n   %s redos: %llu requested, %llu performed, %llu cancelled", name, partition.redos_requested,
+                      partition.redos_performed, partition.redos_cancelled);
+        text += line;
+        std::snprintf(line, sizeof(line), "\n   %s events: %llu inputs, %llu outputs, blocked %.3f s in %llu of %llu barrier updates", name,
+                      partition.input_events, partition.output_events, partition.barrier.blocked_s, partition.barrier.waits,
+                      partition.barrier.updates);
+        text += line;
+
+        unsigned long long total = 0;
+        std::string sources;
+        for (const auto &[source, count] : partition.sources) {
+            total += count;
+            sources += (sources.empty() ? "" : ", ") + (source.empty() ? std::string("unbound") : source) + " " + std::to_string(count);
+        }
+        text += "\n   " + partition.name + " srcdata: " + std::to_string(total);
+        if (!sources.empty()) {
+            text += " (" + sources + ")";
+        }
+
+        for (const RedoCost::PortCost &cost : partition.redo_cost) {
+            std::snprintf(line, sizeof(line), "\n   %s redo cost of %s: %llu redos (%llu shared), %g s discarded in %.3f s wall, longest %g s at %g s",
+                          name, cost.port.empty() ? "(no input)" : cost.port.c_str(), cost.redos, cost.shared, cost.discarded_s,
+                          cost.discarded_wall_s, cost.max_step_s, cost.max_step_time_s);
+            text += line;
+        }
+
+        if (partition.solver.solver != "default" || partition.solver.threads != 0 || !partition.solver_trials.empty()) {
+            text += "\n   " + partition.name + " solver: " + partition.solver.describe();
+            for (size_t t = 0; t < partition.solver_trials.size(); ++t) {
+                const SolverTrial &trial = partition.solver_trials[t];
+                std::snprintf(line, sizeof(line), "%s%s %.3g us/step", (t == 0) ? " (tuned: " : "; ", trial.choice.describe().c_str(),
+                              trial.step_wall_s * 1e6);
+                text += line;
+            }
+            text += partition.solver_trials.empty() ? "" : ")";
+        }
+
+        if (partition.adaptive) {
+            std::snprintf(line, sizeof(line), "\n   %s tolerances: loosened %llu times, tightened %llu times, now %s", name,
+                          partition.tolerance_loosened, partition.tolerance_tightened, partition.adaptive_loose ? "loose" : "tight");
+            text += line;
+        }
+
+        if (partition.has_history) {
+            std::snprintf(line, sizeof(line), "\n   %s history: %zu points x %zu vectors (%.1f MB)", name, partition.history_points,
+                          partition.history_vectors, static_cast<double>(partition.history_bytes) / (1024.0 * 1024.0));
+            text += line;
+        }
+    }
+
+    // one message per report, so the repeat limit counts reports and not lines
+    INFO("%s", text.c_str());
+}
+
+static auto json_string(const std::string &value) -> std::string {
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static auto json_number(double value) -> std::string {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+static auto json_barrier(const StatsReport::BarrierStats &barrier) -> std::string {
+    return "{\"updates\": " + std::to_string(barrier.updates) + ", \"waits\": " + std::to_string(barrier.waits) +
+           ", \"blocked_s\": " + json_number(barrier.blocked_s) + "}";
+}
+
+auto StatsReport::to_json() const -> std::string {
+    double ratio = (wall_time_s_ > 0.0) ? sim_time_s_ / wall_time_s_ : 0.0;
+    std::string json = "{\n";
+    json += "  \"sim_time_s\": " + json_number(sim_time_s_) + ",\n";
+    json += "  \"wall_time_s\": " + json_number(wall_time_s_) + ",\n";
+    json += "  \"sim_wall_ratio\": " + json_number(ratio) + ",\n";
+    json += "  \"peak_rss_bytes\": " + std::to_string(peak_rss_bytes_) + ",\n";
+    json += "  \"hdl\": {\"timestep_callbacks\": " + std::to_string(timestep_callbacks_) + ", \"barrier\": " + json_barrier(hdl_barrier_) + "},\n";
+    json += "  \"partitions\": [";
+
+    for (size_t i = 0; i < partitions_.size(); ++i) {
+        const Partition &partition = partitions_[i];
+        unsigned long long total = 0;
+        std::string sources;
+        for (const auto &[source, count] : partition.sources) {
+            total += count;
+            sources += (sources.empty() ? "" : ", ") + json_string(source) + ": " + std::to_string(count);
+        }
+
+        json += (i == 0) ? "\n" : ",\n";
+        json += "    {\n";
+        json += "      \"name\": " + json_string(partition.name) + ",\n";
+        json += "      \"netlist\": " + json_string(partition.netlist) + ",\n";
+        json += "      \"engine_id\": " + std::to_string(partition.engine_id) + ",\n";
+        json += "      \"ng_sync\": {\"end_of_step\": " + std::to_string(partition.sync_end_of_step) +
+                ", \"start_of_step\": " + std::to_string(partition.sync_start_of_step) +
+                ", \"redostep\": " + std::to_string(partition.sync_redostep) + "},\n";
+        json += "      \"redos\": {\"requested\": " + std::to_string(partition.redos_requested) +
+                ", \"performed\": " + std::to_string(partition.redos_performed) +
+                ", \"cancelled\": " + std::to_string(partition.redos_cancelled) + "},\n";
+        json += "      \"srcdata\": {\"total\": " + std::to_string(total) + ", \"sources\": {" + sources + "}},\n";
+        json += "      \"redo_cost\": [";
+        for (size_t c = 0; c < partition.redo_cost.size(); ++c) {
+            const RedoCost::PortCost &cost = partition.redo_cost[c];
+            json += (c == 0) ? "\n" : ",\n";
+            json += "        {\"port\": " + json_string(cost.port) + ", \"redos\": " + std::to_string(cost.redos) +
+                    ", \"shared\": " + std::to_string(cost.shared) + ", \"discarded_s\": " + json_number(cost.discarded_s) +
+                    ", \"discarded_wall_s\": " + json_number(cost.discarded_wall_s) + ", \"max_step_s\": " + json_number(cost.max_step_s) +
+                    ", \"max_step_time_s\": " + json_number(cost.max_step_time_s) + "}";
+        }
+        json += partition.redo_cost.empty() ? "],\n" : "\n      ],\n";
+        json += "      \"input_events\": " + std::to_string(partition.input_events) + ",\n";
+        json += "      \"output_events\": " + std::to_string(partition.output_events) + ",\n";
+        json += "      \"solver\": {\"name\": " + json_string(partition.solver.solver) + ", \"threads\": " + std::to_string(partition.solver.threads) +
+                ", \"trials\": [";
+        for (size_t t = 0; t < partition.solver_trials.size(); ++t) {
+            const SolverTrial &trial = partition.solver_trials[t];
+            json += (t == 0) ? "" : ", ";
+            json += "{\"name\": " + json_string(trial.choice.solver) + ", \"threads\": " + std::to_string(trial.choice.threads) +
+                    ", \"steps\": " + std::to_string(trial.steps) + ", \"step_wall_s\": " + json_number(trial.step_wall_s) + "}";
+        }
+        json += "]},\n";
+        json += "      \"barrier\": " + json_barrier(partition.barrier);
+        if (partition.adaptive) {
+            json += ",\n      \"tolerances\": {\"loosened\": " + std::to_string(partition.tolerance_loosened) +
+                    ", \"tightened\": " + std::to_string(partition.tolerance_tightened) +
+                    ", \"loose\": " + std::string(partition.adaptive_loose ? "true" : "false") + "}";
+        }
+        if (partition.has_history) {
+            json += ",\n      \"history\": {\"points\": " + std::to_string(partition.history_points) +
+                    ", \"vectors\": " + std::to_string(partition.history_vectors) +
+                    ", \"bytes\": " + std::to_string(partition.history_bytes) + "}";
+        }
+        json += "\n    }";
+    }
+    json += partitions_.empty() ? "]\n" : "\n  ]\n";
+    json += "}\n";
+    return json;
+}
+
+auto StatsReport::write_json(const std::string &file_name) const -> bool {
+    FILE *file = std::fopen(file_name.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string json = to_json();
+    bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+static auto stats_calltf(PLI_BYTE8 *user_data) -> PLI_INT32 {
+    auto *session = reinterpret_cast<CoSimSession *>(user_data);
+
+    s_vpi_time simtime;
+    simtime.type = vpiSimTime;
+    vpi_get_time(nullptr, &simtime);
+    unsigned long long current_time = (simtime.high * (1ULL << 32)) + simtime.low;
+
+    session->report_stats(current_time);
+    return 0;
+}
+
+void register_stats_systf(CoSimSession *session) {
+    s_vpi_systf_data tf_data;
+    tf_data.type = vpiSysTask;
+    tf_data.sysfunctype = 0;
+    tf_data.tfname = "$spicebind_stats";
+    tf_data.calltf = stats_calltf;
+    tf_data.compiletf = nullptr;
+    tf_data.sizetf = nullptr;
+    tf_data.user_data = reinterpret_cast<PLI_BYTE8 *>(session);
+    vpi_register_systf(&tf_data);
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,202 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "SolverTuning.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace spice_vpi {
+
+class CoSimSession;
+
+/**
+ * @brief Event counter written by a single thread and read by any
+ *
+ * Each counter has exactly one writer (an ngspice thread or the HDL thread),
+ * so a relaxed load and store is enough and no read-modify-write is needed.
+ */
+class Counter {
+public:
+    void add(unsigned long long n = 1) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    unsigned long long get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<unsigned long long> value_{0};
+};
+
+/**
+ * @brief Co-simulation counters of one partition
+ */
+struct PartitionStats {
+    Counter sync_end_of_step;    // ng_sync at the end of an accepted step (location 0)
+    Counter sync_start_of_step;  // ng_sync before a new step (location 1)
+    Counter sync_redostep;       // ng_sync while ngspice repeats a rejected step
+    Counter redos_requested;     // input changes that asked ngspice to roll back (HDL thread)
+    Counter redos_performed;     // steps shortened to the input change time
+    Counter redos_cancelled;     // rollbacks dropped because the step already ended before the change
+    Counter input_events;        // HDL input value changes (HDL thread)
+    Counter output_events;       // outputs written to the HDL (HDL thread)
+};
+
+/**
+ * @brief Analog work discarded by redos, attributed to the HDL inputs that caused them
+ *
+ * Input changes mark their port dirty; when the HDL side asks ngspice to roll
+ * back, the dirty ports become the cause of that redo. The rolled back step is
+ * charged to every port of the cause when ngspice performs the redo.
+ */
+class RedoCost {
+public:
+    /**
+     * @brief Cost of the redos caused by one port
+     */
+    struct PortCost {
+        std::string port;                // HDL port, empty for redos without an input change (checkpoints)
+        unsigned long long redos = 0;
+        unsigned long long shared = 0;   // redos caused together with other ports
+        double discarded_s = 0.0;        // SPICE time of the rejected steps
+        double discarded_wall_s = 0.0;   // wall time ngspice spent on the rejected steps
+        double max_step_s = 0.0;         // longest rejected step
+        double max_step_time_s = 0.0;    // SPICE time it ended at
+    };
+
+    /**
+     * @brief An input changed (HDL thread)
+     * @param port Full HDL name of the port
+     */
+    void mark_dirty(const char *port);
+
+    /**
+     * @brief A rollback was requested for the dirty ports (HDL thread)
+     */
+    void request();
+
+    /**
+     * @brief ngspice rejected its last step for the requested rollback (ngspice thread)
+     * @param step_s Length of the rejected step in seconds
+     * @param time_s SPICE time the rejected step ended at
+     */
+    void performed(double step_s, double time_s);
+
+    /**
+     * @brief An accepted step ended (ngspice thread), the start of the next step's wall time
+     */
+    void step_accepted();
+
+    /**
+     * @brief Cost per port, most expensive (discarded wall time) first
+     */
+    std::vector<PortCost> per_port() const;
+
+private:
+    std::vector<std::string> dirty_;    // HDL thread only
+    mutable std::mutex mutex_;
+    std::vector<std::string> pending_;  // cause of the requested rollback
+    std::vector<PortCost> costs_;
+    std::chrono::steady_clock::time_point step_start_;  // ngspice thread only
+};
+
+/**
+ * @brief Co-simulation counters of the HDL side
+ */
+struct SessionStats {
+    Counter timestep_callbacks;  // vpi_timestep_cb calls
+    std::chrono::steady_clock::time_point wall_start;  // ngspice start
+};
+
+/**
+ * @brief Snapshot of the performance counters of a session
+ *
+ * Printed at the end of simulation and by the $spicebind_stats system task,
+ * and written as JSON to SPICE_STATS_JSON:
+ *
+ * @code
+ * initial begin
+ *     #1ms $spicebind_stats;
+ * end
+ * @endcode
+ */
+class StatsReport {
+public:
+    /**
+     * @brief Time an engine spent blocked in the time barrier
+     */
+    struct BarrierStats {
+        unsigned long long updates = 0;
+        unsigned long long waits = 0;
+        double blocked_s = 0.0;
+    };
+
+    struct Partition {
+        std::string name;     // HDL instance or corner
+        std::string netlist;
+        int engine_id = 0;
+        unsigned long long sync_end_of_step = 0;
+        unsigned long long sync_start_of_step = 0;
+        unsigned long long sync_redostep = 0;
+        unsigned long long redos_requested = 0;
+        unsigned long long redos_performed = 0;
+        unsigned long long redos_cancelled = 0;
+        unsigned long long input_events = 0;
+        unsigned long long output_events = 0;
+        std::vector<std::pair<std::string, unsigned long long>> sources;  // srcdata calls per input source
+        std::vector<RedoCost::PortCost> redo_cost;  // rolled back work per input port
+        BarrierStats barrier;
+        SolverChoice solver;                   // matrix solver and threads of the run
+        std::vector<SolverTrial> solver_trials;  // candidates timed when the solver was tuned
+        bool adaptive = false;                 // SPICE_ADAPTIVE switched the tolerances
+        bool adaptive_loose = false;           // loose tolerances applied at the time of the report
+        unsigned long long tolerance_loosened = 0;
+        unsigned long long tolerance_tightened = 0;
+        bool has_history = false;
+        size_t history_points = 0;
+        size_t history_vectors = 0;
+        size_t history_bytes = 0;
+    };
+
+    /**
+     * @brief Read the counters of a configured session
+     * @param session Co-simulation session
+     * @param hdl_time Current HDL time in simulator ticks
+     * @param with_history Include the ngspice history (only while ngspice is halted)
+     */
+    static StatsReport collect(CoSimSession &session, unsigned long long hdl_time, bool with_history);
+
+    /**
+     * @brief Print the report through the logger
+     */
+    void print() const;
+
+    /**
+     * @brief The report as a JSON object
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief Write to_json() to a file
+     * @return false if the file cannot be written
+     */
+    bool write_json(const std::string &file_name) const;
+
+private:
+    double sim_time_s_ = 0.0;
+    double wall_time_s_ = 0.0;
+    unsigned long long timestep_callbacks_ = 0;
+    unsigned long long peak_rss_bytes_ = 0;  // of the simulator process
+    BarrierStats hdl_barrier_;
+    std::vector<Partition> partitions_;
+};
+
+/**
+ * @brief Register the $spicebind_stats system task
+ * @param session Co-simulation session to report on
+ */
+void register_stats_systf(CoSimSession *session);
+
+} // namespace spice_vpi
+
+#endif // STATS_H
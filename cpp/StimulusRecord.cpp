@@ -0,0 +1,196 @@
+#include "StimulusRecord.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace spice_vpi {
+
+namespace {
+
+constexpr char STIMULUS_MAGIC[8] = {'S', 'B', 'S', 'T', 'I', 'M', '0', '1'};
+constexpr size_t WRITE_BUFFER = 1 << 16;
+
+template <typename T>
+void put(FILE *file, T value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T>
+auto get(FILE *file, T &value) -> bool {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+} // namespace
+
+StimulusRecorder::StimulusRecorder(const std::string &file_name, unsigned long long time_precision) : file_name_(file_name) {
+    file_ = std::fopen(file_name_.c_str(), "wb");
+    if (file_ == nullptr) {
+        throw std::runtime_error("cannot create stimulus file " + file_name_);
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER);
+    std::fwrite(STIMULUS_MAGIC, 1, sizeof(STIMULUS_MAGIC), file_);
+    put<uint64_t>(file_, time_precision);
+}
+
+StimulusRecorder::~StimulusRecorder() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+void StimulusRecorder::record(const char *source, double time, double value) {
+    if (file_ == nullptr) {
+        return;
+    }
+
+    auto it = sources_.find(source);
+    if (it == sources_.end()) {
+        if (sources_.size() > UINT16_MAX) {
+            return;
+        }
+        Source entry;
+        entry.id = static_cast<uint16_t>(sources_.size());
+        it = sources_.emplace(source, entry).first;
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(std::strlen(source), UINT16_MAX));
+        put<char>(file_, 'S');
+        put<uint16_t>(file_, entry.id);
+        put<uint16_t>(file_, length);
+        std::fwrite(source, 1, length, file_);
+        ++records_;
+    } else if (value == it->second.last_value && time >= it->second.last_time) {
+        it->second.last_time = time;
+        return;  // unchanged, implied by the previous value
+    }
+
+    Source &entry = it->second;
+    entry.last_time = time;
+    entry.last_value = value;
+    put<char>(file_, 'V');
+    put<uint16_t>(file_, entry.id);
+    put<double>(file_, time);
+    put<double>(file_, value);
+    ++records_;
+}
+
+void StimulusRecorder::close(double end_time) {
+    if (file_ == nullptr) {
+        return;
+    }
+    put<char>(file_, 'E');
+    put<double>(file_, end_time);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+auto StimulusRecorder::records() const -> unsigned long long {
+    return records_;
+}
+
+StimulusReplay::StimulusReplay(const std::string &file_name) {
+    FILE *file = std::fopen(file_name.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot open stimulus file " + file_name);
+    }
+
+    char magic[sizeof(STIMULUS_MAGIC)];
+    uint64_t time_precision = 0;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, STIMULUS_MAGIC, sizeof(magic)) != 0 ||
+        !get(file, time_precision)) {
+        std::fclose(file);
+        throw std::runtime_error(file_name + " is not a spicebind stimulus recording");
+    }
+    tolerance_ = (time_precision != 0) ? 0.5 / static_cast<double>(time_precision) : 0.0;
+
+    std::vector<std::vector<Point> *> by_id;
+    bool has_end = false;
+    double last_time = 0.0;
+    char type = 0;
+    while (get(file, type)) {
+        if (type == 'S') {
+            uint16_t id = 0;
+            uint16_t length = 0;
+            if (!get(file, id) || !get(file, length)) {
+                break;
+            }
+            std::string name(length, '\0');
+            if (std::fread(&name[0], 1, length, file) != length) {
+                break;
+            }
+            by_id.resize(std::max<size_t>(by_id.size(), id + 1u), nullptr);
+            by_id[id] = &sources_[name];
+        } else if (type == 'V') {
+            uint16_t id = 0;
+            Point point{};
+            if (!get(file, id) || !get(file, point.time) || !get(file, point.value) || id >= by_id.size() || by_id[id] == nullptr) {
+                break;
+            }
+            // a value for an earlier time rolls back the values of the rejected step
+            std::vector<Point> &points = *by_id[id];
+            while (!points.empty() && points.back().time > point.time + tolerance_) {
+                points.pop_back();
+            }
+            if (!points.empty() && std::abs(points.back().time - point.time) <= tolerance_) {
+                points.back().value = point.value;
+            } else {
+                points.push_back(point);
+            }
+            last_time = std::max(last_time, point.time);
+        } else if (type == 'E') {
+            has_end = get(file, end_time_);
+            break;
+        } else {
+            break;
+        }
+    }
+    std::fclose(file);
+    if (!has_end) {
+        end_time_ = last_time;  // the recording run did not finish cleanly
+    }
+
+    for (auto &[name, points] : sources_) {
+        // keep only the points where the value changes
+        auto last = std::unique(points.begin(), points.end(), [](const Point &a, const Point &b) { return a.value == b.value; });
+        points.erase(last, points.end());
+        for (size_t i = 1; i < points.size(); ++i) {
+            changes_.push_back(points[i].time);
+        }
+    }
+    std::sort(changes_.begin(), changes_.end());
+}
+
+auto StimulusReplay::value(const std::string &source, double time, double &value) const -> bool {
+    auto it = sources_.find(source);
+    if (it == sources_.end() || it->second.empty()) {
+        return false;
+    }
+    const std::vector<Point> &points = it->second;
+    auto next = std::upper_bound(points.begin(), points.end(), time + tolerance_, [](double t, const Point &p) { return t < p.time; });
+    value = (next == points.begin()) ? points.front().value : std::prev(next)->value;
+    return true;
+}
+
+auto StimulusReplay::next_change(double time) const -> double {
+    auto it = std::upper_bound(changes_.begin(), changes_.end(), time + tolerance_);
+    return (it == changes_.end()) ? -1.0 : *it;
+}
+
+auto StimulusReplay::end_time() const -> double {
+    return end_time_;
+}
+
+auto StimulusReplay::time_tolerance() const -> double {
+    return tolerance_;
+}
+
+auto StimulusReplay::sources() const -> std::vector<std::pair<std::string, size_t>> {
+    std::vector<std::pair<std::string, size_t>> result;
+    for (const auto &[name, points] : sources_) {
+        result.emplace_back(name, points.empty() ? 0 : points.size() - 1);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,131 @@
+#ifndef STIMULUS_RECORD_H
+#define STIMULUS_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Records the values ngspice consumed from its external sources (SPICE_RECORD_STIMULUS)
+ *
+ * Written from ng_srcdata in the order ngspice asked for the values, so the
+ * netlist can be rerun without the HDL simulator by spicebind_replay. A value
+ * is only written when it changed or when ngspice went back in time (a
+ * rejected step); repeated requests for an unchanged value are implied.
+ *
+ * File layout (little endian):
+ *
+ *     "SBSTIM01"  u64 time precision (HDL ticks per second)
+ *     'S' u16 id  u16 length  name       first value of a source
+ *     'V' u16 id  f64 time  f64 value    value returned to ngspice
+ *     'E' f64 time                       end of the recording (HDL time)
+ */
+class StimulusRecorder {
+public:
+    /**
+     * @brief Create the file and write its header
+     * @param file_name Output file
+     * @param time_precision HDL time precision in ticks per second
+     * @throws std::runtime_error if the file cannot be created
+     */
+    StimulusRecorder(const std::string &file_name, unsigned long long time_precision);
+
+    StimulusRecorder(const StimulusRecorder &) = delete;
+    StimulusRecorder &operator=(const StimulusRecorder &) = delete;
+    ~StimulusRecorder();
+
+    /**
+     * @brief Record the value returned for a source (ngspice thread)
+     * @param source Source name as passed to ng_srcdata, e.g. "va0"
+     * @param time SPICE time in seconds
+     * @param value Value returned to ngspice
+     */
+    void record(const char *source, double time, double value);
+
+    /**
+     * @brief Write the end record and close the file
+     * @param end_time HDL time in seconds the recording is valid until
+     */
+    void close(double end_time);
+
+    /**
+     * @brief Records written so far, including source definitions
+     */
+    unsigned long long records() const;
+
+private:
+    struct Source {
+        uint16_t id = 0;
+        double last_time = 0.0;
+        double last_value = 0.0;
+    };
+
+    FILE *file_ = nullptr;
+    std::string file_name_;
+    std::unordered_map<std::string, Source> sources_;
+    unsigned long long records_ = 0;
+};
+
+/**
+ * @brief Recorded source values of a run, read back for replay
+ *
+ * Values recorded for steps ngspice rejected are dropped, leaving one
+ * piecewise-constant waveform per source: the value at a time is the last
+ * recorded value at or before it.
+ */
+class StimulusReplay {
+public:
+    /**
+     * @brief Read a file written by StimulusRecorder
+     * @throws std::runtime_error if the file cannot be read or is not a stimulus recording
+     */
+    explicit StimulusReplay(const std::string &file_name);
+
+    /**
+     * @brief Value of a source at a SPICE time
+     * @param source Source name as passed to the GetVSRCData callback
+     * @param time SPICE time in seconds
+     * @param value Receives the value
+     * @return false if the source was not recorded
+     */
+    bool value(const std::string &source, double time, double &value) const;
+
+    /**
+     * @brief Earliest value change of any source strictly after a time, or a negative time if none
+     */
+    double next_change(double time) const;
+
+    /**
+     * @brief End of the recording (HDL time of the recorded run) in seconds
+     */
+    double end_time() const;
+
+    /**
+     * @brief Half an HDL tick in seconds, the resolution of the recorded times
+     */
+    double time_tolerance() const;
+
+    /**
+     * @brief Recorded sources in name order with their number of value changes
+     */
+    std::vector<std::pair<std::string, size_t>> sources() const;
+
+private:
+    struct Point {
+        double time;
+        double value;
+    };
+
+    std::unordered_map<std::string, std::vector<Point>> sources_;
+    std::vector<double> changes_;  // sorted change times of all sources
+    double end_time_ = 0.0;
+    double tolerance_ = 0.0;
+};
+
+} // namespace spice_vpi
+
+#endif // STIMULUS_RECORD_H
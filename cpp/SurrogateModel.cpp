@@ -0,0 +1,220 @@
+#include "SurrogateModel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace spice_vpi {
+
+namespace {
+
+constexpr char SURROGATE_MAGIC[8] = {'S', 'B', 'S', 'U', 'R', 'R', '0', '1'};
+
+template <typename T>
+void put(FILE *file, T value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T>
+auto get(FILE *file, T &value) -> bool {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+void put_string(FILE *file, const std::string &value) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+    put<uint16_t>(file, length);
+    std::fwrite(value.data(), 1, length, file);
+}
+
+auto get_string(FILE *file, std::string &value) -> bool {
+    uint16_t length = 0;
+    if (!get(file, length)) {
+        return false;
+    }
+    value.assign(length, '\0');
+    return length == 0 || std::fread(&value[0], 1, length, file) == length;
+}
+
+} // namespace
+
+SurrogateModel::SurrogateModel(std::vector<Input> inputs, std::vector<Output> outputs)
+    : inputs_(std::move(inputs)), outputs_(std::move(outputs)) {
+    if (inputs_.size() > MAX_INPUTS) {
+        throw std::invalid_argument("a surrogate table supports at most " + std::to_string(MAX_INPUTS) + " inputs");
+    }
+    size_t points = 1;
+    for (const Input &input : inputs_) {
+        if (input.grid.size() < 2) {
+            throw std::invalid_argument("surrogate input " + input.name + " needs at least two points");
+        }
+        strides_.push_back(points);
+        points *= input.grid.size();
+    }
+    table_.assign(2 * points * outputs_.size(), 0.0);
+}
+
+auto SurrogateModel::load(const std::string &file_name) -> SurrogateModel {
+    FILE *file = std::fopen(file_name.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot open surrogate table " + file_name);
+    }
+
+    auto fail = [&](const std::string &reason) {
+        std::fclose(file);
+        return std::runtime_error(file_name + ": " + reason);
+    };
+
+    char magic[sizeof(SURROGATE_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, SURROGATE_MAGIC, sizeof(magic)) != 0) {
+        throw fail("not a spicebind surrogate table");
+    }
+
+    uint16_t input_count = 0;
+    if (!get(file, input_count)) {
+        throw fail("truncated table");
+    }
+    std::vector<Input> inputs(input_count);
+    for (Input &input : inputs) {
+        uint8_t digital = 0;
+        uint16_t points = 0;
+        if (!get(file, digital) || !get_string(file, input.name) || !get(file, points)) {
+            throw fail("truncated table");
+        }
+        input.digital = digital != 0;
+        input.grid.resize(points);
+        if (points != 0 && std::fread(input.grid.data(), sizeof(double), points, file) != points) {
+            throw fail("truncated table");
+        }
+    }
+
+    uint16_t output_count = 0;
+    if (!get(file, output_count)) {
+        throw fail("truncated table");
+    }
+    std::vector<Output> outputs(output_count);
+    for (Output &output : outputs) {
+        uint64_t mismatches = 0;
+        if (!get_string(file, output.name) || !get(file, output.max_error) || !get(file, mismatches) || !get(file, output.max_delay)) {
+            throw fail("truncated table");
+        }
+        output.mismatches = mismatches;
+    }
+
+    std::unique_ptr<SurrogateModel> model;
+    try {
+        model = std::make_unique<SurrogateModel>(std::move(inputs), std::move(outputs));
+    } catch (const std::invalid_argument &e) {
+        throw fail(e.what());
+    }
+    if (std::fread(model->table_.data(), sizeof(double), model->table_.size(), file) != model->table_.size()) {
+        throw fail("truncated table");
+    }
+    std::fclose(file);
+    return std::move(*model);
+}
+
+void SurrogateModel::save(const std::string &file_name) const {
+    FILE *file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot create surrogate table " + file_name);
+    }
+    std::fwrite(SURROGATE_MAGIC, 1, sizeof(SURROGATE_MAGIC), file);
+
+    put<uint16_t>(file, static_cast<uint16_t>(inputs_.size()));
+    for (const Input &input : inputs_) {
+        put<uint8_t>(file, input.digital ? 1 : 0);
+        put_string(file, input.name);
+        put<uint16_t>(file, static_cast<uint16_t>(input.grid.size()));
+        std::fwrite(input.grid.data(), sizeof(double), input.grid.size(), file);
+    }
+
+    put<uint16_t>(file, static_cast<uint16_t>(outputs_.size()));
+    for (const Output &output : outputs_) {
+        put_string(file, output.name);
+        put<double>(file, output.max_error);
+        put<uint64_t>(file, output.mismatches);
+        put<double>(file, output.max_delay);
+    }
+
+    std::fwrite(table_.data(), sizeof(double), table_.size(), file);
+    if (std::fclose(file) != 0) {
+        throw std::runtime_error("cannot write surrogate table " + file_name);
+    }
+}
+
+auto SurrogateModel::inputs() const -> const std::vector<Input> & {
+    return inputs_;
+}
+
+auto SurrogateModel::outputs() const -> const std::vector<Output> & {
+    return outputs_;
+}
+
+void SurrogateModel::set_error(size_t output, double max_error, unsigned long long mismatches) {
+    outputs_.at(output).max_error = max_error;
+    outputs_.at(output).mismatches = mismatches;
+}
+
+auto SurrogateModel::points() const -> size_t {
+    return outputs_.empty() ? 0 : table_.size() / (2 * outputs_.size());
+}
+
+void SurrogateModel::set_point(size_t point, size_t output, double value, double delay) {
+    size_t at = 2 * (point * outputs_.size() + output);
+    table_.at(at) = value;
+    table_.at(at + 1) = delay;
+    outputs_[output].max_delay = std::max(outputs_[output].max_delay, delay);
+}
+
+void SurrogateModel::evaluate(const double *inputs, double *values, double *delays) const {
+    if (outputs_.empty()) {
+        return;
+    }
+
+    // lower corner of the cell and the weight of its upper neighbour per input
+    size_t base = 0;
+    double weights[MAX_INPUTS];
+    size_t interpolated[MAX_INPUTS];
+    size_t interpolated_count = 0;
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+        const std::vector<double> &grid = inputs_[i].grid;
+        double x = std::min(std::max(inputs[i], grid.front()), grid.back());
+        size_t cell = static_cast<size_t>(std::upper_bound(grid.begin(), grid.end(), x) - grid.begin());
+        cell = std::min(std::max<size_t>(cell, 1), grid.size() - 1) - 1;
+        double weight = (x - grid[cell]) / (grid[cell + 1] - grid[cell]);
+
+        if (inputs_[i].digital) {
+            cell = (weight > 0.5) ? cell + 1 : cell;
+            weight = 0.0;
+        }
+        base += cell * strides_[i];
+        if (weight > 0.0) {
+            weights[interpolated_count] = weight;
+            interpolated[interpolated_count++] = i;
+        }
+    }
+
+    std::fill(values, values + outputs_.size(), 0.0);
+    std::fill(delays, delays + outputs_.size(), 0.0);
+    for (size_t corner = 0; corner < (size_t{1} << interpolated_count); ++corner) {
+        size_t point = base;
+        double weight = 1.0;
+        for (size_t k = 0; k < interpolated_count; ++k) {
+            if ((corner >> k) & 1U) {
+                point += strides_[interpolated[k]];
+                weight *= weights[k];
+            } else {
+                weight *= 1.0 - weights[k];
+            }
+        }
+        const double *row = &table_[2 * point * outputs_.size()];
+        for (size_t j = 0; j < outputs_.size(); ++j) {
+            values[j] += weight * row[2 * j];
+            delays[j] += weight * row[2 * j + 1];
+        }
+    }
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,98 @@
+#ifndef SURROGATE_MODEL_H
+#define SURROGATE_MODEL_H
+
+#include <string>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Characterised lookup table of a block's settled outputs and delays (SPICE_SURROGATE)
+ *
+ * Built by spicebind_characterize from a sweep of the netlist's inputs, then
+ * evaluated by AnalogDigitalInterface in place of ngspice. Each table point
+ * holds, per output, the settled voltage and the delay after which the output
+ * stayed near it when the inputs stepped to that point. Between points of
+ * analog inputs the table is interpolated multilinearly; digital inputs snap
+ * to the nearest level.
+ *
+ * File layout (little endian):
+ *
+ *     "SBSURR01"
+ *     u16 inputs   per input:  u8 digital  u16 length name  u16 points  f64 grid[points]
+ *     u16 outputs  per output: u16 length name  f64 max_error  u64 mismatches  f64 max_delay
+ *     per point (input 0 varies fastest), per output: f64 value  f64 delay
+ */
+class SurrogateModel {
+public:
+    struct Input {
+        std::string name;          // port name as bound, e.g. "vin" or "a[0]"
+        bool digital = false;      // grid holds the two logic levels in volts
+        std::vector<double> grid;  // increasing input voltages of the table points
+    };
+
+    struct Output {
+        std::string name;                 // port name as bound
+        double max_error = 0.0;           // largest interpolation error in volts found by validation
+        unsigned long long mismatches = 0;  // validation points whose logic level was interpolated wrongly
+        double max_delay = 0.0;           // largest delay in seconds
+    };
+
+    /// Most inputs a table can have, the corners of a cell are enumerated
+    static constexpr size_t MAX_INPUTS = 16;
+
+    /**
+     * @brief Create an empty table
+     * @throws std::invalid_argument if an input has fewer than two points or there are too many inputs
+     */
+    SurrogateModel(std::vector<Input> inputs, std::vector<Output> outputs);
+
+    /**
+     * @brief Read a table written by save()
+     * @throws std::runtime_error if the file cannot be read or is not a surrogate table
+     */
+    static SurrogateModel load(const std::string &file_name);
+
+    /**
+     * @brief Write the table
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void save(const std::string &file_name) const;
+
+    const std::vector<Input> &inputs() const;
+    const std::vector<Output> &outputs() const;
+
+    /**
+     * @brief Set the validation results of an output
+     */
+    void set_error(size_t output, double max_error, unsigned long long mismatches);
+
+    /**
+     * @brief Number of table points, the product of the input grid sizes
+     */
+    size_t points() const;
+
+    /**
+     * @brief Set the settled value and delay of an output at a table point
+     * @param point Point index, input 0 varies fastest
+     */
+    void set_point(size_t point, size_t output, double value, double delay);
+
+    /**
+     * @brief Outputs for input voltages
+     * @param inputs One voltage per table input; values outside the grid are clamped
+     * @param values Receives one settled value per output
+     * @param delays Receives one delay in seconds per output
+     */
+    void evaluate(const double *inputs, double *values, double *delays) const;
+
+private:
+    std::vector<Input> inputs_;
+    std::vector<Output> outputs_;
+    std::vector<size_t> strides_;  // point index step per input
+    std::vector<double> table_;    // value and delay per point and output
+};
+
+} // namespace spice_vpi
+
+#endif // SURROGATE_MODEL_H
@@ -1,34 +1,57 @@
 #ifndef TIME_BARRIER_H
 #define TIME_BARRIER_H
 
+#include "Tracer.h"
 #include <mutex>
 #include <condition_variable>
-#include <array>
+#include <vector>
+#include <memory>
 #include <atomic>
+#include <chrono>
 #include <stdexcept>
 
 namespace spice_vpi {
 
 /**
- * @brief Two-party virtual-time synchronization barrier with shutdown support
- * 
- * Coordinates time progression between two simulation engines (HDL and SPICE).
- * Each engine calls update() with its current time. If one engine gets ahead,
- * it blocks until the other catches up or shutdown is called.
- * 
+ * @brief Virtual-time synchronization barrier between one HDL and N SPICE engines
+ *
+ * Coordinates time progression between the HDL simulator and one or more
+ * SPICE engines. Each engine calls update() with its current time. The HDL
+ * engine blocks until every SPICE engine has reached its time; a SPICE engine
+ * blocks until the HDL engine has reached its time. SPICE engines do not wait
+ * for each other, so independent partitions run in parallel.
+ *
  * @tparam TimeT Time type (typically unsigned long long for femtosecond precision)
  */
 template<typename TimeT>
 class TimeBarrier {
 public:
     static constexpr int HDL_ENGINE_ID = 0;
-    static constexpr int SPICE_ENGINE_ID = 1;
+    static constexpr int SPICE_ENGINE_ID = 1;  // first SPICE engine, others follow
 
-    TimeBarrier() : times_{TimeT{}, TimeT{}}, is_shutdown_(false), needs_redo_(false), next_spice_step_time_(TimeT{}) {}
+    /**
+     * @brief Startup state of the SPICE engines as seen by the HDL side
+     */
+    enum class SpiceStartState { Pending, Ready, Stopped };
+
+    /**
+     * @brief How often and how long one engine waited in update()
+     */
+    struct WaitStats {
+        unsigned long long updates = 0;  // update() calls
+        unsigned long long waits = 0;    // calls that had to block
+        std::chrono::nanoseconds blocked{0};
+    };
+
+    /**
+     * @brief Constructor
+     * @param num_spice_engines Number of SPICE engines (engine ids 1..num_spice_engines)
+     */
+    explicit TimeBarrier(int num_spice_engines = 1) { reset(num_spice_engines); }
 
     /**
      * @brief Update time for one engine and wait for synchronization
-     * @param engine_id Engine identifier (HDL_ENGINE_ID or SPICE_ENGINE_ID)
+     * @param engine_id Engine identifier (HDL_ENGINE_ID or a SPICE engine id)
      * @param current_time Current virtual time for this engine
      * @return false if barrier was shut down before sync completed
      */
@@ -58,29 +81,121 @@ public:
      */
     bool is_shutdown() const;
 
+    /**
+     * @brief Restore the initial state so the barrier can be used for a new run
+     *
+     * Must only be called while no engine is waiting on the barrier.
+     *
+     * @param num_spice_engines Number of SPICE engines for the new run
+     */
+    void reset(int num_spice_engines = 1);
+
+    /**
+     * @brief Number of SPICE engines taking part in the barrier
+     */
+    int num_spice_engines() const;
+
     // SPICE-specific methods
-    void set_needs_redo(bool needs_redo);
-    bool needs_redo() const;
-    
-    void set_next_spice_step_time(TimeT time);
+    void set_needs_redo(bool needs_redo, int engine_id = SPICE_ENGINE_ID);
+    bool needs_redo(int engine_id = SPICE_ENGINE_ID) const;
+
+    void set_next_spice_step_time(TimeT time, int engine_id = SPICE_ENGINE_ID);
+    TimeT get_next_spice_step_time(int engine_id) const;
+
+    /**
+     * @brief Earliest next step time over all SPICE engines
+     */
     TimeT get_next_spice_step_time() const;
 
+    /**
+     * @brief Mark a SPICE engine as running (first sync/source callback received)
+     * @param engine_id SPICE engine identifier
+     */
+    void set_spice_ready(int engine_id = SPICE_ENGINE_ID);
+
+    /**
+     * @brief Mark the background thread of a SPICE engine as terminated
+     *
+     * Only has an effect while startup is still pending, so a thread that
+     * exits before its first time step is reported as a startup failure.
+     *
+     * @param engine_id SPICE engine identifier
+     */
+    void set_spice_stopped(int engine_id = SPICE_ENGINE_ID);
+
+    /**
+     * @brief Wait until all SPICE engines are ready, one has stopped, or the timeout expires
+     * @param timeout Maximum time to wait
+     * @return Combined startup state (Pending on timeout)
+     */
+    SpiceStartState wait_for_spice_start(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Record whether the background thread of a SPICE engine is running
+     *
+     * Set before a run or resume is started and cleared when the thread ends,
+     * e.g. at a breakpoint.
+     *
+     * @param running True while the thread runs
+     * @param engine_id SPICE engine identifier
+     */
+    void set_spice_running(bool running, int engine_id = SPICE_ENGINE_ID);
+
+    /**
+     * @brief Wait until the background threads of all SPICE engines have ended, or shutdown or timeout
+     * @param timeout Maximum time to wait
+     * @return true if no SPICE engine is running
+     */
+    bool wait_for_spice_halt(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Let SPICE updates return without waiting for the HDL engine
+     *
+     * Used to drive ngspice to its next step boundary (e.g. for bg_halt)
+     * while the HDL engine is blocked outside the barrier.
+     *
+     * @param released True to release the SPICE engines, false to restore normal waiting
+     */
+    void set_spice_released(bool released);
+
+    /**
+     * @brief Wait statistics of one engine since the last reset
+     * @param engine_id Engine identifier (HDL_ENGINE_ID or a SPICE engine id)
+     */
+    WaitStats wait_stats(int engine_id) const;
+
 private:
+    struct SpiceEngineState {
+        std::atomic<bool> needs_redo{false};
+        std::atomic<TimeT> next_step_time{TimeT{}};
+        std::atomic<SpiceStartState> start_state{SpiceStartState::Pending};
+        std::atomic<bool> running{false};
+    };
+
     mutable std::mutex mutex_;
     std::condition_variable cv_;
-    std::array<TimeT, 2> times_;
-    std::atomic<bool> is_shutdown_;
-    std::atomic<bool> needs_redo_;
-    std::atomic<TimeT> next_spice_step_time_;
-    
+    std::vector<TimeT> times_;
+    std::vector<WaitStats> wait_stats_;  // per engine, guarded by mutex_
+    int num_spice_engines_ = 0;
+    std::unique_ptr<SpiceEngineState[]> spice_;
+    std::atomic<bool> is_shutdown_{false};
+    std::atomic<bool> spice_released_{false};
+
+    SpiceEngineState &spice(int engine_id);
+    const SpiceEngineState &spice(int engine_id) const;
+    bool spice_caught_up(TimeT time) const;
+    SpiceStartState combined_start_state() const;
+    bool any_spice_running() const;
+    void set_spice_start_state(int engine_id, SpiceStartState state);
     void validate_engine_id(int engine_id) const;
+    void validate_spice_engine_id(int engine_id) const;
 };
 
 // Template implementation
 template<typename TimeT>
 bool TimeBarrier<TimeT>::update(int engine_id, TimeT current_time) {
     validate_engine_id(engine_id);
-    
+
     std::unique_lock<std::mutex> lock(mutex_);
     if (is_shutdown_.load()) {
         return false;
@@ -90,11 +205,25 @@ bool TimeBarrier<TimeT>::update(int engine_id, TimeT current_time) {
     times_[engine_id] = current_time;
     cv_.notify_all();
 
-    // Wait until the other engine reaches our time or shutdown is called
-    const int other_engine = 1 - engine_id;
-    cv_.wait(lock, [&] {
-        return is_shutdown_.load() || times_[other_engine] >= times_[engine_id];
-    });
+    // Wait until the other side reaches our time or shutdown is called
+    auto synced = [&] {
+        if (engine_id == HDL_ENGINE_ID) {
+            return is_shutdown_.load() || spice_caught_up(times_[HDL_ENGINE_ID]);
+        }
+        return is_shutdown_.load() || times_[HDL_ENGINE_ID] >= times_[engine_id] || spice_released_.load();
+    };
+
+    WaitStats &stats = wait_stats_[engine_id];
+    stats.updates++;
+    TRACE(Barrier, "update engine=%d time=%llu", engine_id, current_time);
+    if (!synced()) {
+        TRACE(Barrier, "wait engine=%d time=%llu", engine_id, current_time);
+        auto start = std::chrono::steady_clock::now();
+        cv_.wait(lock, synced);
+        stats.waits++;
+        stats.blocked += std::chrono::steady_clock::now() - start;
+        TRACE(Barrier, "resume engine=%d time=%llu", engine_id, current_time);
+    }
 
     return !is_shutdown_.load();
 }
@@ -102,15 +231,16 @@ bool TimeBarrier<TimeT>::update(int engine_id, TimeT current_time) {
 template<typename TimeT>
 void TimeBarrier<TimeT>::update_no_wait(int engine_id, TimeT current_time) {
     validate_engine_id(engine_id);
-    
+
     std::lock_guard<std::mutex> lock(mutex_);
     times_[engine_id] = current_time;
+    cv_.notify_all();
 }
 
 template<typename TimeT>
 TimeT TimeBarrier<TimeT>::get_time(int engine_id) const {
     validate_engine_id(engine_id);
-    
+
     std::lock_guard<std::mutex> lock(mutex_);
     return times_[engine_id];
 }
@@ -130,32 +260,192 @@ bool TimeBarrier<TimeT>::is_shutdown() const {
 }
 
 template<typename TimeT>
-void TimeBarrier<TimeT>::set_needs_redo(bool needs_redo) {
-    needs_redo_.store(needs_redo);
+void TimeBarrier<TimeT>::reset(int num_spice_engines) {
+    if (num_spice_engines < 1) {
+        throw std::invalid_argument("TimeBarrier needs at least one SPICE engine");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    times_.assign(num_spice_engines + 1, TimeT{});
+    wait_stats_.assign(num_spice_engines + 1, WaitStats());
+    if (num_spice_engines != num_spice_engines_) {
+        spice_ = std::make_unique<SpiceEngineState[]>(num_spice_engines);
+        num_spice_engines_ = num_spice_engines;
+    }
+    for (int i = 0; i < num_spice_engines_; i++) {
+        spice_[i].needs_redo.store(false);
+        spice_[i].next_step_time.store(TimeT{});
+        spice_[i].start_state.store(SpiceStartState::Pending);
+        spice_[i].running.store(false);
+    }
+    is_shutdown_.store(false);
+    spice_released_.store(false);
+}
+
+template<typename TimeT>
+int TimeBarrier<TimeT>::num_spice_engines() const {
+    return num_spice_engines_;
 }
 
 template<typename TimeT>
-bool TimeBarrier<TimeT>::needs_redo() const {
-    return needs_redo_.load();
+void TimeBarrier<TimeT>::set_needs_redo(bool needs_redo, int engine_id) {
+    spice(engine_id).needs_redo.store(needs_redo);
 }
 
 template<typename TimeT>
-void TimeBarrier<TimeT>::set_next_spice_step_time(TimeT time) {
-    next_spice_step_time_.store(time);
+bool TimeBarrier<TimeT>::needs_redo(int engine_id) const {
+    return spice(engine_id).needs_redo.load();
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_next_spice_step_time(TimeT time, int engine_id) {
+    spice(engine_id).next_step_time.store(time);
+}
+
+template<typename TimeT>
+TimeT TimeBarrier<TimeT>::get_next_spice_step_time(int engine_id) const {
+    return spice(engine_id).next_step_time.load();
 }
 
 template<typename TimeT>
 TimeT TimeBarrier<TimeT>::get_next_spice_step_time() const {
-    return next_spice_step_time_.load();
+    TimeT next_time = spice_[0].next_step_time.load();
+    for (int i = 1; i < num_spice_engines_; i++) {
+        TimeT engine_next_time = spice_[i].next_step_time.load();
+        if (engine_next_time < next_time) {
+            next_time = engine_next_time;
+        }
+    }
+    return next_time;
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_spice_ready(int engine_id) {
+    // Fast path: called from every ngspice callback, lock only on the first transition
+    if (spice(engine_id).start_state.load() != SpiceStartState::Pending) {
+        return;
+    }
+    set_spice_start_state(engine_id, SpiceStartState::Ready);
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_spice_stopped(int engine_id) {
+    set_spice_start_state(engine_id, SpiceStartState::Stopped);
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_spice_start_state(int engine_id, SpiceStartState state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spice(engine_id).start_state.load() != SpiceStartState::Pending) {
+            return;
+        }
+        spice(engine_id).start_state.store(state);
+    }
+    cv_.notify_all();
+}
+
+template<typename TimeT>
+auto TimeBarrier<TimeT>::wait_for_spice_start(std::chrono::milliseconds timeout) -> SpiceStartState {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, timeout, [&] {
+        return is_shutdown_.load() || combined_start_state() != SpiceStartState::Pending;
+    });
+    return combined_start_state();
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_spice_running(bool running, int engine_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spice(engine_id).running.store(running);
+    }
+    cv_.notify_all();
+}
+
+template<typename TimeT>
+bool TimeBarrier<TimeT>::wait_for_spice_halt(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, timeout, [&] { return is_shutdown_.load() || !any_spice_running(); });
+    return !any_spice_running();
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::set_spice_released(bool released) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spice_released_.store(released);
+    }
+    cv_.notify_all();
+}
+
+template<typename TimeT>
+auto TimeBarrier<TimeT>::wait_stats(int engine_id) const -> WaitStats {
+    validate_engine_id(engine_id);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wait_stats_[engine_id];
+}
+
+template<typename TimeT>
+auto TimeBarrier<TimeT>::spice(int engine_id) -> SpiceEngineState & {
+    validate_spice_engine_id(engine_id);
+    return spice_[engine_id - SPICE_ENGINE_ID];
+}
+
+template<typename TimeT>
+auto TimeBarrier<TimeT>::spice(int engine_id) const -> const SpiceEngineState & {
+    validate_spice_engine_id(engine_id);
+    return spice_[engine_id - SPICE_ENGINE_ID];
+}
+
+template<typename TimeT>
+bool TimeBarrier<TimeT>::spice_caught_up(TimeT time) const {
+    for (int i = SPICE_ENGINE_ID; i <= num_spice_engines_; i++) {
+        if (times_[i] < time) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename TimeT>
+auto TimeBarrier<TimeT>::combined_start_state() const -> SpiceStartState {
+    bool all_ready = true;
+    for (int i = 0; i < num_spice_engines_; i++) {
+        SpiceStartState state = spice_[i].start_state.load();
+        if (state == SpiceStartState::Stopped) {
+            return SpiceStartState::Stopped;
+        }
+        all_ready = all_ready && (state == SpiceStartState::Ready);
+    }
+    return all_ready ? SpiceStartState::Ready : SpiceStartState::Pending;
+}
+
+template<typename TimeT>
+bool TimeBarrier<TimeT>::any_spice_running() const {
+    for (int i = 0; i < num_spice_engines_; i++) {
+        if (spice_[i].running.load()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 template<typename TimeT>
 void TimeBarrier<TimeT>::validate_engine_id(int engine_id) const {
-    if (engine_id != HDL_ENGINE_ID && engine_id != SPICE_ENGINE_ID) {
-        throw std::invalid_argument("Invalid engine ID: must be 0 (HDL) or 1 (SPICE)");
+    if (engine_id < HDL_ENGINE_ID || engine_id > num_spice_engines_) {
+        throw std::invalid_argument("Invalid engine ID: must be 0 (HDL) or 1..N (SPICE)");
+    }
+}
+
+template<typename TimeT>
+void TimeBarrier<TimeT>::validate_spice_engine_id(int engine_id) const {
+    if (engine_id < SPICE_ENGINE_ID || engine_id > num_spice_engines_) {
+        throw std::invalid_argument("Invalid SPICE engine ID: must be 1..N");
     }
 }
 
 } // namespace spice_vpi
 
-#endif // TIME_BARRIER_H 
\ No newline at end of file
+#endif // TIME_BARRIER_H
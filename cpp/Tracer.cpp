@@ -0,0 +1,200 @@
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace spice_vpi {
+
+static constexpr char TRACE_MAGIC[8] = {'S', 'B', 'T', 'R', 'A', 'C', 'E', '1'};
+
+std::atomic<uint32_t> Tracer::mask_{0};
+
+namespace {
+
+struct ThreadBuffer {
+    std::vector<Tracer::Event> events;
+    uint64_t next = 0;  // total events recorded, the ring holds the last events.size()
+    std::string name;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    size_t capacity = 1 << 16;
+    std::atomic<uint64_t> generation{1};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+auto registry() -> Registry & {
+    static Registry instance;
+    return instance;
+}
+
+struct ThreadSlot {
+    ThreadBuffer *buffer = nullptr;
+    uint64_t generation = 0;
+};
+
+thread_local ThreadSlot tls_slot;
+
+auto thread_buffer() -> ThreadBuffer & {
+    Registry &reg = registry();
+    uint64_t generation = reg.generation.load(std::memory_order_acquire);
+    if (tls_slot.buffer == nullptr || tls_slot.generation != generation) {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events.resize(std::max<size_t>(reg.capacity, 1));
+        buffer->name = "thread " + std::to_string(reg.buffers.size());
+        tls_slot.buffer = buffer.get();
+        tls_slot.generation = generation;
+        reg.buffers.push_back(std::move(buffer));
+    }
+    return *tls_slot.buffer;
+}
+
+template <typename T>
+void put(FILE *file, T value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+void put_string(FILE *file, const std::string &text) {
+    put<uint32_t>(file, static_cast<uint32_t>(text.size()));
+    std::fwrite(text.data(), 1, text.size(), file);
+}
+
+} // namespace
+
+void Tracer::configure(uint32_t categories, size_t events_per_thread) {
+    Registry &reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.clear();
+        reg.capacity = events_per_thread;
+        reg.epoch = std::chrono::steady_clock::now();
+        reg.generation.fetch_add(1);
+    }
+    mask_.store(categories);
+}
+
+void Tracer::name_thread(const std::string &name) {
+    if (mask_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    ThreadBuffer &buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+auto Tracer::next_event() -> Event & {
+    ThreadBuffer &buffer = thread_buffer();
+    return buffer.events[buffer.next++ % buffer.events.size()];
+}
+
+auto Tracer::now_ns() -> uint64_t {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count());
+}
+
+void Tracer::pack_string(Event &event, uint8_t &type, int &slot, const char *value) {
+    if (slot + 2 > SLOTS) {
+        type = Truncated;
+        return;
+    }
+    type = String;
+    char text[2 * sizeof(uint64_t)] = {};
+    if (value != nullptr) {
+        // keep the end of long names, it tells hierarchical ports apart
+        size_t length = std::strlen(value);
+        size_t skip = (length >= sizeof(text)) ? length - (sizeof(text) - 1) : 0;
+        std::memcpy(text, value + skip, length - skip);
+    }
+    std::memcpy(&event.slots[slot], text, sizeof(text));
+    slot += 2;
+}
+
+auto Tracer::parse_categories(const std::string &list, uint32_t &categories) -> bool {
+    categories = 0;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        std::string name = list.substr(start, comma - start);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        if (name == "all") {
+            categories |= All;
+        } else if (name == "general") {
+            categories |= General;
+        } else if (name == "sync") {
+            categories |= Sync;
+        } else if (name == "redo") {
+            categories |= Redo;
+        } else if (name == "srcdata") {
+            categories |= SrcData;
+        } else if (name == "port") {
+            categories |= Port;
+        } else if (name == "barrier") {
+            categories |= Barrier;
+        } else if (name == "timeline") {
+            categories |= Timeline;
+        } else if (!name.empty()) {
+            return false;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+// File layout (little endian on the usual hosts): magic, format table, then per thread
+// its name and events in recording order; see spicebind/trace.py for the decoder
+auto Tracer::write(const std::string &file_name) -> bool {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    FILE *file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::set<uint64_t> formats;
+    for (const auto &buffer : reg.buffers) {
+        uint64_t count = std::min<uint64_t>(buffer->next, buffer->events.size());
+        for (uint64_t i = 0; i < count; ++i) {
+            formats.insert(buffer->events[i].format);
+        }
+    }
+
+    std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file);
+    put<uint32_t>(file, static_cast<uint32_t>(sizeof(Event)));
+    put<uint32_t>(file, static_cast<uint32_t>(formats.size()));
+    for (uint64_t format : formats) {
+        put<uint64_t>(file, format);
+        put_string(file, reinterpret_cast<const char *>(static_cast<uintptr_t>(format)));
+    }
+
+    put<uint32_t>(file, static_cast<uint32_t>(reg.buffers.size()));
+    for (const auto &buffer : reg.buffers) {
+        uint64_t size = buffer->events.size();
+        uint64_t count = std::min<uint64_t>(buffer->next, size);
+        put_string(file, buffer->name);
+        put<uint64_t>(file, count);
+        put<uint64_t>(file, buffer->next - count);  // overwritten events
+        for (uint64_t i = buffer->next - count; i < buffer->next; ++i) {
+            std::fwrite(&buffer->events[i % size], sizeof(Event), 1, file);
+        }
+        buffer->next = 0;
+    }
+
+    bool ok = std::ferror(file) == 0;
+    ok = (std::fclose(file) == 0) && ok;
+    return ok;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,172 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace spice_vpi {
+
+/**
+ * @brief Binary event tracing in per-thread ring buffers, enabled at runtime by category
+ *
+ * A trace point records a timestamp, its printf-style format string and up to
+ * six raw arguments into a ring buffer owned by the calling thread; nothing is
+ * formatted while the simulation runs. With a category disabled a trace point
+ * costs one relaxed load and a branch. The buffers are written to a binary
+ * file at the end of simulation and decoded offline with `spicebind-trace`.
+ * When a ring buffer is full the oldest events of that thread are overwritten.
+ */
+class Tracer {
+public:
+    enum Category : uint32_t {
+        General = 1u << 0,  // setup and everything else
+        Sync = 1u << 1,     // ng_sync and HDL timestep handoffs
+        Redo = 1u << 2,     // rejected and cancelled SPICE steps
+        SrcData = 1u << 3,  // ng_srcdata source value requests
+        Port = 1u << 4,     // HDL port value changes and output updates
+        Barrier = 1u << 5,  // time barrier updates and waits of every engine
+        Timeline = 1u << 6, // redos, breakpoints and port updates shown on the timeline
+        All = 0x7f,
+    };
+
+    /**
+     * @brief Kind of a Timeline trace point, always its first argument
+     *
+     * `spicebind-trace --chrome` names the timeline instants by this value, so
+     * the messages can be reworded freely. Keep the values in sync with trace.py.
+     */
+    enum TimelineEvent : int {
+        RedoRequest = 1,    // an input changed, ngspice has to step back to the HDL time
+        RedoPerformed = 2,  // ngspice rejected its step for one ending at the HDL time
+        RedoCancelled = 3,  // the step already ended before the HDL time
+        Breakpoint = 4,     // ngspice stops once it reaches this time (pause)
+        InputChange = 5,    // an HDL input of a partition changed
+        OutputUpdate = 6,   // an output value was written to the HDL
+    };
+
+    static constexpr int MAX_ARGS = 6;
+    static constexpr int SLOTS = 8;  // 8-byte argument slots, strings take two (last 15 characters)
+
+    enum ArgType : uint8_t {
+        None = 0,
+        Int = 1,
+        Unsigned = 2,
+        Double = 3,
+        String = 4,
+        Truncated = 5,  // did not fit the remaining slots
+    };
+
+    struct Event {
+        uint64_t time_ns;  // steady clock since the tracer was configured
+        uint64_t format;   // address of the format string literal, resolved when the file is written
+        uint8_t category;
+        uint8_t count;
+        uint8_t types[MAX_ARGS];
+        uint64_t slots[SLOTS];
+    };
+
+    /**
+     * @brief Enable categories and size the per-thread ring buffers
+     * @param categories Bit mask of enabled categories (0 = tracing off)
+     * @param events_per_thread Ring buffer capacity in events
+     */
+    static void configure(uint32_t categories, size_t events_per_thread);
+
+    /**
+     * @brief Check if a category is enabled
+     */
+    static bool enabled(Category category) {
+        return (mask_.load(std::memory_order_relaxed) & category) != 0;
+    }
+
+    /**
+     * @brief Name the calling thread in the trace (e.g. "hdl")
+     */
+    static void name_thread(const std::string &name);
+
+    /**
+     * @brief Record one event; use the TRACE macro so disabled categories skip argument evaluation
+     * @param format printf-style format string literal, decoded offline
+     */
+    template <typename... Args>
+    static void record(Category category, const char *format, const Args &...args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "trace points take at most six arguments");
+        Event &event = next_event();
+        event.time_ns = now_ns();
+        event.format = reinterpret_cast<uintptr_t>(format);
+        event.category = static_cast<uint8_t>(category);
+        event.count = static_cast<uint8_t>(sizeof...(Args));
+        if constexpr (sizeof...(Args) > 0) {
+            int arg = 0;
+            int slot = 0;
+            (pack(event, arg, slot, args), ...);
+        }
+    }
+
+    /**
+     * @brief Write all ring buffers to a binary trace file and clear them
+     *
+     * Call when the traced threads are idle (after ngspice halted).
+     *
+     * @return false if the file could not be written
+     */
+    static bool write(const std::string &file_name);
+
+    /**
+     * @brief Parse a comma-separated category list ("sync,redo", "all", "" = none)
+     * @return false for an unknown category name
+     */
+    static bool parse_categories(const std::string &list, uint32_t &categories);
+
+private:
+    static std::atomic<uint32_t> mask_;
+
+    static Event &next_event();
+    static uint64_t now_ns();
+
+    template <typename T>
+    static void pack(Event &event, int &arg, int &slot, const T &value) {
+        using V = std::decay_t<T>;
+        uint8_t &type = event.types[arg++];
+        if constexpr (std::is_same_v<V, std::string>) {
+            pack_string(event, type, slot, value.c_str());
+        } else if constexpr (std::is_same_v<V, const char *> || std::is_same_v<V, char *>) {
+            pack_string(event, type, slot, value);
+        } else if constexpr (std::is_floating_point_v<V>) {
+            pack_bits(event, type, slot, Double, static_cast<double>(value));
+        } else if constexpr (std::is_enum_v<V> || (std::is_integral_v<V> && std::is_signed_v<V>)) {
+            pack_bits(event, type, slot, Int, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<V>) {
+            pack_bits(event, type, slot, Unsigned, static_cast<uint64_t>(value));
+        } else {
+            pack_bits(event, type, slot, Unsigned, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        }
+    }
+
+    template <typename T>
+    static void pack_bits(Event &event, uint8_t &type, int &slot, ArgType arg_type, T value) {
+        if (slot >= SLOTS) {
+            type = Truncated;
+            return;
+        }
+        type = arg_type;
+        std::memcpy(&event.slots[slot++], &value, sizeof(uint64_t));
+    }
+
+    static void pack_string(Event &event, uint8_t &type, int &slot, const char *value);
+};
+
+} // namespace spice_vpi
+
+// Trace point; arguments are only evaluated when the category is enabled (SPICE_TRACE)
+#define TRACE(category, ...)                                                                         \
+    do {                                                                                             \
+        if (spice_vpi::Tracer::enabled(spice_vpi::Tracer::category)) {                               \
+            spice_vpi::Tracer::record(spice_vpi::Tracer::category, __VA_ARGS__);                     \
+        }                                                                                            \
+    } while (0)
+
+#endif // TRACER_H
@@ -1,30 +1,22 @@
 #include "VpiCallbacks.h"
 #include "NgSpiceCallbacks.h"
+#include "Checkpoint.h"
+#include "Stats.h"
 #include "Debug.h"
-#include "TimeBarrier.h"
-#include "AnalogDigitalInterface.h"
-#include "Config.h"
-#include "ngspice/sharedspice.h"
+#include "CoSimSession.h"
 #include "vpi_user.h"
-#include <memory>
 #include <exception>
-#include <thread>
-#include <chrono>
 #include <cmath>
+#include <string>
 
-// External global variables (defined in vpi_module.cpp)
-extern spice_vpi::TimeBarrier<unsigned long long> g_time_barrier;
-extern spice_vpi::Config::Settings g_config;
-extern std::unique_ptr<spice_vpi::AnalogDigitalInterface> g_interface;
-
-// Global VPI state variables
-static bool add_ngspice_timestep = false;
-static vpiHandle next_time_cb_handle;
+// Process-wide co-simulation session (defined in vpi_module.cpp)
+extern spice_vpi::CoSimSession g_session;
 
 namespace spice_vpi {
 
 void register_vpi_callbacks() {
     s_cb_data cb_data;
+    cb_data.user_data = reinterpret_cast<PLI_BYTE8 *>(&g_session);
 
     /* Simulation start */
     cb_data.reason = cbStartOfSimulation;
@@ -38,10 +30,18 @@ void register_vpi_callbacks() {
     cb_data.reason = cbEndOfSimulation;
     cb_data.cb_rtn = vpi_end_of_sim_cb;
     vpi_register_cb(&cb_data);
+
+    register_checkpoint_systf(&g_session);
+    register_stats_systf(&g_session);
+
+    // queued log messages are printed from the HDL thread
+    Logger::instance().set_output_thread();
 }
 
 auto vpi_port_change_cb(p_cb_data cb_data_p) -> PLI_INT32 {
 
+    auto *watch = reinterpret_cast<PortWatch *>(cb_data_p->user_data);
+    CoSimSession *session = watch->session;
     vpiHandle value_handle = cb_data_p->obj;
 
     const char *name = vpi_get_str(vpiName, value_handle);
@@ -53,20 +53,43 @@ auto vpi_port_change_cb(p_cb_data cb_data_p) -> PLI_INT32 {
     simtime.type = vpiSimTime;
     vpi_get_time(nullptr, &simtime);
     unsigned long long current_time = (simtime.high * (1ULL << 32)) + simtime.low;
-    DBG("enter %s current_time=%llu size=%d value=%f", name, current_time, vsize, val_s.value.real);
+    TRACE(Port, "enter %s current_time=%llu size=%d value=%f", name, current_time, vsize, val_s.value.real);
+    TRACE(Timeline, "event=%d input %s current_time=%llu", Tracer::InputChange, name, current_time);
+    watch->partition->stats().input_events.add();
+    if (session->output_recorder() != nullptr && !watch->partition->is_corner()) {
+        session->output_recorder()->input_changed(value_handle);
+    }
+
+    // a characterised table stands in for ngspice: no SPICE step to roll back
+    if (session->is_surrogate()) {
+        watch->partition->interface().digital_input_update(value_handle);
+        watch->partition->stats().output_events.add(watch->partition->interface().surrogate_update());
+        return 0;
+    }
 
 
+    watch->partition->adaptive().input_changed();
+
+    // inputs without redo are applied at the next SPICE step, the current step is kept
+    if (watch->no_redo) {
+        watch->partition->set_no_redo_inputs_changed(true);
+    } else {
+        // only the partition owning this input has to redo its step
+        watch->partition->set_inputs_changed(true);
+        watch->partition->redo_cost().mark_dirty(vpi_get_str(vpiFullName, value_handle));
+    }
+
     // since we may go back in time in ngspice we need to remove the next time callback
-    if (next_time_cb_handle != nullptr) {
-        DBG("removing next_time_cb"); 
+    if (session->next_time_cb_handle() != nullptr) {
+        TRACE(Sync, "removing next_time_cb"); 
         // ngspice will update - cancel next time callback will be added in rw_sync
         // what if time_cb is registered for current time
-        vpi_remove_cb(next_time_cb_handle);
-        next_time_cb_handle = nullptr;
+        vpi_remove_cb(session->next_time_cb_handle());
+        session->set_next_time_cb_handle(nullptr);
     }
 
-    if (!add_ngspice_timestep) { // only once if multiple input changes same time
-        DBG("register vpi_timestep_cb current_time=%llu next_time_spice=%lld", current_time, g_time_barrier.get_next_spice_step_time());
+    if (!session->add_ngspice_timestep()) { // only once if multiple input changes same time
+        TRACE(Port, "register vpi_timestep_cb current_time=%llu next_time_spice=%lld", current_time, session->barrier().get_next_spice_step_time());
 
         // register next time callback for current time once
         s_vpi_time next_delay;
@@ -80,10 +103,11 @@ auto vpi_port_change_cb(p_cb_data cb_data_p) -> PLI_INT32 {
         next_cb_data.obj = nullptr;
         next_cb_data.time = &next_delay;
         next_cb_data.value = nullptr;
+        next_cb_data.user_data = reinterpret_cast<PLI_BYTE8 *>(session);
 
         vpi_register_cb(&next_cb_data);
 
-        add_ngspice_timestep = true;
+        session->set_add_ngspice_timestep(true);
 
     }
 
@@ -94,40 +118,72 @@ auto vpi_port_change_cb(p_cb_data cb_data_p) -> PLI_INT32 {
 
 auto vpi_timestep_cb(p_cb_data cb_data_p) -> PLI_INT32 {
 
+    auto *session = reinterpret_cast<CoSimSession *>(cb_data_p->user_data);
+    auto &barrier = session->barrier();
+
     s_vpi_time simtime;
     simtime.type = vpiSimTime;
     vpi_get_time(nullptr, &simtime);
     unsigned long long current_time = (simtime.high * (1ULL << 32)) + simtime.low;
 
-    DBG("enter current_time=%llu next_time_spice=%lld", current_time, g_time_barrier.get_next_spice_step_time());
-
-    if (add_ngspice_timestep) {
-        DBG("add ngspice time step at current_time=%llu", current_time);
-        g_time_barrier.update_no_wait(spice_vpi::TimeBarrier<unsigned long long>::SPICE_ENGINE_ID, current_time);
-        g_time_barrier.set_needs_redo(true);
+    TRACE(Sync, "enter current_time=%llu next_time_spice=%lld", current_time, barrier.get_next_spice_step_time());
+    session->stats().timestep_callbacks.add();
+
+    if (session->add_ngspice_timestep()) {
+        for (const auto &partition : session->partitions()) {
+            if (partition->inputs_changed()) {
+                TRACE(Redo, "add ngspice time step at current_time=%llu engine=%d", current_time, partition->engine_id());
+                TRACE(Timeline, "event=%d redo request engine=%d current_time=%llu", Tracer::RedoRequest, partition->engine_id(), current_time);
+                barrier.update_no_wait(partition->engine_id(), current_time);
+                barrier.set_needs_redo(true, partition->engine_id());
+                partition->stats().redos_requested.add();
+                partition->redo_cost().request();
+            } else if (partition->no_redo_inputs_changed()) {
+                // no rollback: the sources pick the new values up at the next step
+                TRACE(Port, "update inputs without redo at current_time=%llu engine=%d", current_time, partition->engine_id());
+                partition->interface().update_all_digital_inputs();
+                partition->set_no_redo_inputs_changed(false);
+            }
+        }
     }
 
-    g_time_barrier.update(spice_vpi::TimeBarrier<unsigned long long>::HDL_ENGINE_ID, current_time + 1);
-    DBG("after time_sync.update (+1) current_time=%llu next_time_spice=%lld", current_time, g_time_barrier.get_next_spice_step_time());
+    session->apply_adaptive_tolerances(current_time);
+
+    barrier.update(CoSimSession::Barrier::HDL_ENGINE_ID, current_time + 1);
+    TRACE(Sync, "after time_sync.update (+1) current_time=%llu next_time_spice=%lld", current_time, barrier.get_next_spice_step_time());
+    Logger::instance().flush();
 
-    if (add_ngspice_timestep) {
-        DBG("update_all_digital_inputs after ngspice time new timestep");
-        g_interface->update_all_digital_inputs();
+    if (session->add_ngspice_timestep()) {
+        TRACE(Port, "update_all_digital_inputs after ngspice time new timestep");
+        for (const auto &partition : session->partitions()) {
+            if (partition->inputs_changed()) {
+                partition->interface().update_all_digital_inputs();
+                partition->set_inputs_changed(false);
+                partition->set_no_redo_inputs_changed(false);
+            }
+        }
 
         // TODO: add one more ngspice step (+1) to have inputs rise faster?
     }
-    add_ngspice_timestep = false;
+    session->set_add_ngspice_timestep(false);
 
     //
-    //  update digital outputs
+    //  update digital outputs, corners only compare theirs with the driving netlist
     //
-    g_interface->set_digital_output();
+    const AnalogDigitalInterface &driver = session->partitions().front()->interface();
+    for (const auto &partition : session->partitions()) {
+        if (partition->is_corner()) {
+            partition->interface().compare_digital_output(driver, current_time);
+        } else {
+            partition->stats().output_events.add(partition->interface().set_digital_output());
+        }
+    }
 
-    unsigned long long next_spice_step = g_time_barrier.get_next_spice_step_time();
+    unsigned long long next_spice_step = barrier.get_next_spice_step_time();
     unsigned long long time_low = next_spice_step - current_time;
 
     if (time_low < 1) {
-        DBG("SMALL STEP: current_time=%llu next_spice_step=%llu time_step==0", current_time, next_spice_step);
+        TRACE(Sync, "SMALL STEP: current_time=%llu next_spice_step=%llu time_step==0", current_time, next_spice_step);
         time_low = 1;
     }
 
@@ -137,60 +193,28 @@ auto vpi_timestep_cb(p_cb_data cb_data_p) -> PLI_INT32 {
     cb_data_p->time->high = 0;
     cb_data_p->time->low = time_low;
 
-    DBG("register next event t=%llu time_low=%llu next_time_spice=%lld", current_time, time_low, g_time_barrier.get_next_spice_step_time());
+    TRACE(Sync, "register next event t=%llu time_low=%llu next_time_spice=%lld", current_time, time_low, barrier.get_next_spice_step_time());
 
-    next_time_cb_handle = vpi_register_cb(cb_data_p);
+    session->set_next_time_cb_handle(vpi_register_cb(cb_data_p));
 
     return 0;
 }
 
-auto vpi_start_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
-
-    try {
-        // Load configuration from environment variables
-        g_config = spice_vpi::Config::load_from_environment();
-
-        // Initialize the interface with the configuration
-        g_interface = std::make_unique<spice_vpi::AnalogDigitalInterface>(g_config);
-        
-        vpi_printf("** Info: Using SPICE netlist: %s\n", g_config.spice_netlist_path.c_str());
-        
-        // Log all HDL instances
-        vpi_printf("** Info: Using HDL instances: ");
-        for (size_t i = 0; i < g_config.hdl_instance_names.size(); ++i) {
-            vpi_printf("%s", g_config.hdl_instance_names[i].c_str());
-            if (i < g_config.hdl_instance_names.size() - 1) {
-                vpi_printf(", ");
-            }
-        }
-        if (g_config.full_path_discovery) {
-            vpi_printf(" (full path discovery mode)");
-        }
-        vpi_printf("\n");
-        
-        vpi_printf("** Info: Using VCC: %g\n", g_config.vcc_voltage);
-        vpi_printf("** Info: Using logic thresholds: LOGIC_THRESHOLD_LOW=%g, LOGIC_THRESHOLD_HIGH=%g\n", 
-                   g_config.logic_threshold_low, g_config.logic_threshold_high);
-        
-        int time_unit = vpi_get(vpiTimeUnit, nullptr);
-        int time_precision = vpi_get(vpiTimePrecision, nullptr);
-        g_config.time_precision = static_cast<unsigned long long>(std::pow(10, -time_precision));
-        vpi_printf("** Info: Simulation precision: %lld (10e%d)\n", g_config.time_precision, time_precision);
-        
-    } catch (const std::exception& e) {
-        ERROR("Configuration error: %s", e.what());
-        return 1;
-    }
-
-    // Process each HDL instance
-    for (const std::string& instance_name : g_config.hdl_instance_names) {
+// Bind the ports of the HDL instances of one partition and watch its inputs
+static void bind_partition_ports(CoSimSession *session, size_t index) {
+    SpicePartition &partition = *session->partitions()[index];
+    for (const std::string& instance_name : partition.config().hdl_instance_names) {
         vpiHandle inst = vpi_handle_by_name(const_cast<char*>(instance_name.c_str()), nullptr);
         if (inst == nullptr) {
             ERROR("ERROR: instance \"%s\" not found", instance_name.c_str());
             continue; // Continue with other instances instead of returning
         }
 
-        vpi_printf("** Info: Processing instance: %s\n", instance_name.c_str());
+        if (partition.is_corner()) {
+            TRACE(General, "Processing instance %s for corner %s", instance_name.c_str(), partition.config().corner_name.c_str());
+        } else {
+            vpi_printf("** Info: Processing instance: %s\n", instance_name.c_str());
+        }
 
         vpiHandle iter = vpi_iterate(vpiPort, inst);
         vpiHandle port = nullptr;
@@ -202,11 +226,15 @@ auto vpi_start_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
             if (dir == vpiInout) {
                 ERROR(" port %s inout - not supported", pname);
             } else {
-                g_interface->add_port(port);
+                bool no_redo = partition.interface().add_port(port) == AnalogDigitalInterface::PortBinding::NoRedo;
 
                 vpiHandle module = vpi_handle(vpiParent, port);
                 vpiHandle net = vpi_handle_by_name(const_cast<char*>(pname), module);
                 if (dir == vpiInput) {
+                    if (session->output_recorder() != nullptr && !partition.is_corner()) {
+                        session->output_recorder()->add_input(net);
+                    }
+
                     // Set up a value-change callback on that handle
                     s_cb_data cb_data_s;
                     cb_data_s.reason = cbValueChange;
@@ -214,39 +242,114 @@ auto vpi_start_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
                     cb_data_s.obj = net;
                     cb_data_s.time = nullptr;
                     cb_data_s.value = nullptr;
-                    vpi_register_cb(&cb_data_s);
+                    cb_data_s.user_data = reinterpret_cast<PLI_BYTE8 *>(session->port_watch(index, no_redo));
+                    session->track_port_callback(vpi_register_cb(&cb_data_s));
                 }
             }
         }
     }
+}
 
-    //
-    // initialize ngspice
-    //
-    if (ngSpice_Init(ng_printf, nullptr, ng_exit, nullptr, nullptr, nullptr, nullptr) == 0) { 
-        ngSpice_Command((char *)g_config.spice_netlist_path.c_str());
-    } else {
-        ERROR("Failed to initialize ngspice.");
-        vpi_control(vpiFinish, 1);
+auto vpi_start_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
+
+    auto *session = reinterpret_cast<CoSimSession *>(cb_data_p->user_data);
+
+    // simulator restarted in the same process: drop the previous circuit and state
+    if (session->has_started()) {
+        vpi_printf("** Info: Resetting co-simulation session\n");
+        session->reset();
+    }
+
+    try {
+        int time_unit = vpi_get(vpiTimeUnit, nullptr);
+        int time_precision = vpi_get(vpiTimePrecision, nullptr);
+
+        // Load configuration from environment variables and initialize the interface
+        session->configure(static_cast<unsigned long long>(std::pow(10, -time_precision)));
+        if (session->is_stub()) {
+            vpi_printf("** Info: Replaying SPICE outputs from %s\n", session->config().output_stub.c_str());
+            if (!session->start_stub()) {
+                vpi_control(vpiFinish, 1);
+                return 1;
+            }
+            return 0;
+        }
+        const Config::Settings &config = session->config();
+        
+        if (config.spice_netlist_paths.size() > 1) {
+            for (const auto &partition : session->partitions()) {
+                if (partition->is_corner()) {
+                    continue;
+                }
+                vpi_printf("** Info: Using SPICE netlist: %s for %s\n", partition->config().spice_netlist_path.c_str(),
+                           partition->config().hdl_instance_names.front().c_str());
+            }
+        } else {
+            vpi_printf("** Info: Using SPICE netlist: %s\n", config.spice_netlist_path.c_str());
+        }
+        for (const auto &partition : session->partitions()) {
+            if (partition->is_corner()) {
+                vpi_printf("** Info: Using SPICE corner %s: %s\n", partition->config().corner_name.c_str(),
+                           partition->config().spice_netlist_path.c_str());
+            }
+        }
+        
+        // Log all HDL instances
+        vpi_printf("** Info: Using HDL instances: ");
+        for (size_t i = 0; i < config.hdl_instance_names.size(); ++i) {
+            vpi_printf("%s", config.hdl_instance_names[i].c_str());
+            if (i < config.hdl_instance_names.size() - 1) {
+                vpi_printf(", ");
+            }
+        }
+        if (config.full_path_discovery) {
+            vpi_printf(" (full path discovery mode)");
+        }
+        vpi_printf("\n");
+        
+        vpi_printf("** Info: Using VCC: %g\n", config.vcc_voltage);
+        vpi_printf("** Info: Using logic thresholds: LOGIC_THRESHOLD_LOW=%g, LOGIC_THRESHOLD_HIGH=%g\n", 
+                   config.logic_threshold_low, config.logic_threshold_high);
+        vpi_printf("** Info: Using SPICE startup timeout: %g s\n", config.spice_startup_timeout);
+        vpi_printf("** Info: Simulation precision: %lld (10e%d)\n", config.time_precision, time_precision);
+
+        for (const auto &partition : session->partitions()) {
+            OperatingPointCache &op_cache = partition->op_cache();
+            if (op_cache.enabled()) {
+                INFO("Operating point cache %s: %s", op_cache.has_cache() ? "hit" : "miss", op_cache.path().c_str());
+            }
+        }
+        
+    } catch (const std::exception& e) {
+        ERROR("Configuration error: %s", e.what());
         return 1;
     }
 
-    if (ngSpice_Init_Sync(ng_srcdata, nullptr, ng_sync, nullptr, nullptr) == 0) {
-        ngSpice_Command((char *)"bg_run");
-        std::this_thread::sleep_for(std::chrono::seconds(1)); // wait for ngspice to start
-        if (ngSpice_running()==0) {
-            ERROR("Failed to initialize run ngspice.");
+    // Process each HDL instance of each partition
+    for (size_t p = 0; p < session->partitions().size(); ++p) {
+        bind_partition_ports(session, p);
+    }
+
+    if (session->is_surrogate()) {
+        vpi_printf("** Info: Using surrogate tables instead of ngspice\n");
+        if (!session->start_surrogate()) {
             vpi_control(vpiFinish, 1);
             return 1;
         }
-    } else {
-        ERROR("Failed to initialize ngSpice_Init_Sync interface.");
+        return 0;
+    }
+
+    //
+    // initialize ngspice and wait for its first time step
+    //
+    if (!session->start_spice()) {
         vpi_control(vpiFinish, 1);
         return 1;
     }
 
-    g_time_barrier.update(spice_vpi::TimeBarrier<unsigned long long>::HDL_ENGINE_ID, 1);
-    DBG("update time_barrier.update t=%llu", 1);
+    session->barrier().update(CoSimSession::Barrier::HDL_ENGINE_ID, 1);
+    TRACE(Sync, "update time_barrier.update t=%llu", 1);
+    Logger::instance().flush();
 
     s_vpi_time next_delay;
     next_delay.type = vpiSimTime;
@@ -258,20 +361,29 @@ auto vpi_start_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
     next_cb_data.obj = nullptr;
     next_cb_data.time = &next_delay;
     next_cb_data.value = nullptr;
+    next_cb_data.user_data = reinterpret_cast<PLI_BYTE8 *>(session);
 
     // vpi_timestep_cb(&next_cb_data);
-    next_time_cb_handle = vpi_register_cb(&next_cb_data);
+    session->set_next_time_cb_handle(vpi_register_cb(&next_cb_data));
 
     return 0;
 }
 
 auto vpi_end_of_sim_cb(p_cb_data cb_data_p) -> PLI_INT32 {
 
-    g_time_barrier.shutdown();
+    auto *session = reinterpret_cast<CoSimSession *>(cb_data_p->user_data);
+    session->stop();
+    session->report_corners();
+
+    if (session->has_started()) {
+        s_vpi_time simtime;
+        simtime.type = vpiSimTime;
+        vpi_get_time(nullptr, &simtime);
+        session->report_stats((simtime.high * (1ULL << 32)) + simtime.low);
+    }
 
-    ngSpice_Command((char *)"bg_halt");
-    // ngSpice_Command((char *)"set filetype=ascii");
-    ngSpice_Command((char *)"write dump.raw");
+    wait_for_checkpoint_children();
+    Logger::instance().close();
 
     vpi_printf("End of simulation\n");
 
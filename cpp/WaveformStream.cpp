@@ -0,0 +1,207 @@
+#include "WaveformStream.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace spice_vpi {
+
+static constexpr int POINTS_FIELD_WIDTH = 20;  // room for the patched point count
+
+auto raw_vector_name(const char *vecname) -> std::string {
+    std::string name = vecname;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "time" || name == "frequency" || name.find('(') != std::string::npos) {
+        return name;
+    }
+    const std::string branch = "#branch";
+    if (name.size() > branch.size() && name.compare(name.size() - branch.size(), branch.size(), branch) == 0) {
+        return "i(" + name.substr(0, name.size() - branch.size()) + ")";
+    }
+    return "v(" + name + ")";
+}
+
+static auto raw_vector_type(const std::string &name) -> const char * {
+    if (name == "time" || name == "frequency") {
+        return name.c_str();
+    }
+    return (name.rfind("i(", 0) == 0) ? "current" : "voltage";
+}
+
+WaveformStream::WaveformStream(const std::string &file_name, const std::vector<std::string> &vectors, size_t chunk_points)
+    : file_name_(file_name), chunk_points_(std::max<size_t>(chunk_points, 1)) {
+    for (std::string name : vectors) {
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        selection_.push_back(name);
+    }
+
+    file_ = std::fopen(file_name_.c_str(), "wb");
+    if (file_ == nullptr) {
+        throw std::runtime_error("cannot create waveform file " + file_name_);
+    }
+    writer_ = std::thread(&WaveformStream::writer, this);
+}
+
+WaveformStream::~WaveformStream() {
+    close();
+}
+
+auto WaveformStream::file_name() const -> const std::string & {
+    return file_name_;
+}
+
+void WaveformStream::begin_plot(pvecinfoall info) {
+    if (info == nullptr) {
+        return;
+    }
+    if (!pending_.samples.empty()) {
+        push(std::move(pending_));
+    }
+
+    // the scale goes first, then the selected vectors in ngspice order
+    columns_.clear();
+    std::vector<std::string> names;
+    for (int i = 0; i < info->veccount; ++i) {
+        std::string name = raw_vector_name(info->vecs[i]->vecname);
+        if (name == "time" || name == "frequency") {
+            columns_.insert(columns_.begin(), i);
+            names.insert(names.begin(), name);
+            continue;
+        }
+        std::string plain = info->vecs[i]->vecname;
+        std::transform(plain.begin(), plain.end(), plain.begin(), ::tolower);
+        if (selection_.empty() || std::find(selection_.begin(), selection_.end(), name) != selection_.end() ||
+            std::find(selection_.begin(), selection_.end(), plain) != selection_.end()) {
+            columns_.push_back(i);
+            names.push_back(name);
+        }
+    }
+
+    std::string header;
+    header += "Title: " + std::string(info->title != nullptr ? info->title : "") + "\n";
+    header += "Date: " + std::string(info->date != nullptr ? info->date : "") + "\n";
+    header += "Plotname: " + std::string(info->type != nullptr ? info->type : "") + "\n";
+    header += "Flags: real\n";
+    header += "No. Variables: " + std::to_string(names.size()) + "\n";
+    header += "No. Points: ";
+    size_t points_field = header.size();
+    header += std::string(POINTS_FIELD_WIDTH, ' ') + "\n";
+    header += "Variables:\n";
+    for (size_t i = 0; i < names.size(); ++i) {
+        header += "\t" + std::to_string(i) + "\t" + names[i] + "\t" + raw_vector_type(names[i]) + "\n";
+    }
+    header += "Binary:\n";
+
+    Block block;
+    block.header = std::move(header);
+    block.points_field = points_field;
+    block.columns = names.size();
+    push(std::move(block));
+
+    pending_ = Block();
+    pending_.samples.reserve(chunk_points_ * columns_.size());
+    TRACE(General, "Streaming %zu vectors to %s", names.size(), file_name_.c_str());
+}
+
+void WaveformStream::add_point(pvecvaluesall values) {
+    if (values == nullptr || columns_.empty()) {
+        return;
+    }
+    for (int index : columns_) {
+        pending_.samples.push_back(index < values->veccount ? values->vecsa[index]->creal : 0.0);
+    }
+    if (pending_.samples.size() >= chunk_points_ * columns_.size()) {
+        push(std::move(pending_));
+        pending_ = Block();
+        pending_.samples.reserve(chunk_points_ * columns_.size());
+    }
+}
+
+void WaveformStream::push(Block block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // bounded queue: the ngspice thread waits for a slow disk instead of growing memory
+    cv_.wait(lock, [this] { return queue_.size() < MAX_QUEUED_BLOCKS || closing_; });
+    queue_.push_back(std::move(block));
+    cv_.notify_all();
+}
+
+void WaveformStream::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+    }
+    if (!pending_.samples.empty()) {
+        push(std::move(pending_));
+        pending_ = Block();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+        cv_.notify_all();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void WaveformStream::writer() {
+    while (true) {
+        Block block;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !queue_.empty() || closing_; });
+            if (queue_.empty()) {
+                break;
+            }
+            block = std::move(queue_.front());
+            queue_.pop_front();
+            cv_.notify_all();
+        }
+        write_block(block);
+    }
+
+    finish_plot();
+    if (std::fclose(file_) != 0) {
+        write_error_ = true;
+    }
+    file_ = nullptr;
+    if (write_error_) {
+        ERROR("Failed to write waveform file %s", file_name_.c_str());
+    }
+}
+
+void WaveformStream::write_block(const Block &block) {
+    if (write_error_) {
+        return;
+    }
+    if (!block.header.empty()) {
+        finish_plot();
+        plot_open_ = std::fgetpos(file_, &plot_pos_) == 0;
+        points_field_ = block.points_field;
+        plot_points_ = 0;
+        plot_columns_ = block.columns;
+        write_error_ = std::fwrite(block.header.data(), 1, block.header.size(), file_) != block.header.size();
+    }
+    if (!block.samples.empty() && plot_columns_ > 0) {
+        write_error_ = write_error_ || std::fwrite(block.samples.data(), sizeof(double), block.samples.size(), file_) != block.samples.size();
+        plot_points_ += block.samples.size() / plot_columns_;
+    }
+}
+
+// Patch the point count of the current plot into its header
+void WaveformStream::finish_plot() {
+    if (!plot_open_ || write_error_) {
+        return;
+    }
+    std::string count = std::to_string(plot_points_);
+    write_error_ = std::fsetpos(file_, &plot_pos_) != 0 ||
+                   std::fseek(file_, static_cast<long>(points_field_), SEEK_CUR) != 0 ||
+                   std::fwrite(count.data(), 1, count.size(), file_) != count.size() ||
+                   std::fseek(file_, 0, SEEK_END) != 0;
+    plot_open_ = false;
+}
+
+} // namespace spice_vpi
@@ -0,0 +1,107 @@
+#ifndef WAVEFORM_STREAM_H
+#define WAVEFORM_STREAM_H
+
+#include "ngspice/sharedspice.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spice_vpi {
+
+/**
+ * @brief Vector name as ngspice writes it to raw files: v(node), i(source) or the scale name
+ * @param vecname Vector name reported by SendInitData (e.g. "out" or "vdd#branch")
+ */
+std::string raw_vector_name(const char *vecname);
+
+/**
+ * @brief Writes selected ngspice vectors to a binary raw file while the simulation runs
+ *
+ * Points from the SendData callback are collected in chunks of a fixed number
+ * of points and written by a background thread, so the waveforms never have
+ * to be held for the whole run. The point count in the plot header is patched
+ * when the plot ends; the file can be read by the usual raw file tools.
+ * A new plot (SendInitData) starts a new section in the same file.
+ */
+class WaveformStream {
+public:
+    /**
+     * @brief Open the raw file and start the writer thread
+     * @param file_name Output raw file
+     * @param vectors Vectors to write, as "v(node)", "i(source)" or plain names (empty = all)
+     * @param chunk_points Points per chunk handed to the writer thread
+     * @throws std::runtime_error if the file cannot be created
+     */
+    WaveformStream(const std::string &file_name, const std::vector<std::string> &vectors, size_t chunk_points);
+
+    WaveformStream(const WaveformStream &) = delete;
+    WaveformStream &operator=(const WaveformStream &) = delete;
+    ~WaveformStream();
+
+    /**
+     * @brief Start a new plot with the vectors reported by SendInitData
+     */
+    void begin_plot(pvecinfoall info);
+
+    /**
+     * @brief Append one point reported by SendData
+     *
+     * Waits while the writer thread is behind by more than a few chunks.
+     */
+    void add_point(pvecvaluesall values);
+
+    /**
+     * @brief Write the pending points, stop the writer thread and close the file
+     */
+    void close();
+
+    const std::string &file_name() const;
+
+private:
+    // header of a new plot or a chunk of points, in file order
+    struct Block {
+        std::string header;
+        size_t points_field = 0;  // offset of the point count in the header
+        size_t columns = 0;
+        std::vector<double> samples;
+    };
+
+    static constexpr size_t MAX_QUEUED_BLOCKS = 4;
+
+    std::string file_name_;
+    std::vector<std::string> selection_;
+    size_t chunk_points_;
+
+    // producer (ngspice thread) state
+    std::vector<int> columns_;  // vector index per written column, scale first
+    Block pending_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Block> queue_;
+    bool closing_ = false;
+    bool closed_ = false;
+
+    // writer thread state
+    FILE *file_ = nullptr;
+    bool plot_open_ = false;
+    std::fpos_t plot_pos_{};  // start of the current plot's header
+    size_t points_field_ = 0;
+    size_t plot_points_ = 0;
+    size_t plot_columns_ = 0;
+    bool write_error_ = false;
+    std::thread writer_;
+
+    void push(Block block);
+    void writer();
+    void write_block(const Block &block);
+    void finish_plot();
+};
+
+} // namespace spice_vpi
+
+#endif // WAVEFORM_STREAM_H
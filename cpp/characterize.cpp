@@ -0,0 +1,434 @@
+// spicebind_characterize: sweeps the inputs of a netlist in ngspice and writes a surrogate table
+//
+// Usage: spicebind_characterize [-o model.sbsurr] [--vcc V] [--digital a,b] [--analog vin=LO:HI:POINTS]
+//                               [--dwell T] [--rise T] [--settle V] <netlist> <output>...
+//
+// Every input is an external source named after it, as in the co-simulation
+// (Vvin for input vin). The inputs step through all combinations of their table
+// points, plus the midpoints between analog points that validate the
+// interpolation, in snake order so consecutive points differ by one step of one
+// input. Each point is held for the dwell time: the output at its end is the
+// settled value, and the time the output last left the settle band around it
+// is the delay. The table is used with SPICE_SURROGATE.
+
+#include "SurrogateModel.h"
+#include "ngspice/sharedspice.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+using spice_vpi::SurrogateModel;
+
+namespace {
+
+struct SweepInput {
+    std::string name;
+    bool digital = false;
+    std::vector<double> levels;  // swept voltages, analog inputs include the validation midpoints
+};
+
+constexpr size_t MAX_POINTS = 1 << 20;
+
+std::vector<SweepInput> g_inputs;
+size_t g_points = 1;
+double g_dwell = 20e-9;
+double g_rise = 0.0;
+double g_end_time = 0.0;
+std::atomic<unsigned long long> g_steps{0};
+std::set<std::string> g_unknown;  // ngspice thread only
+
+std::mutex g_done_mutex;
+std::condition_variable g_done_cv;
+bool g_running = false;
+bool g_reached_end = false;
+
+void set_done(bool reached_end) {
+    std::lock_guard<std::mutex> lock(g_done_mutex);
+    g_reached_end = g_reached_end || reached_end;
+    g_running = false;
+    g_done_cv.notify_all();
+}
+
+// Level index of each input at sweep point k: mixed radix digits, input 0 fastest, each
+// input reversed while the sum of the slower digits is odd (boustrophedon order)
+void point_levels(size_t k, std::vector<size_t> &index) {
+    std::vector<size_t> digits(g_inputs.size());
+    for (size_t i = 0; i < g_inputs.size(); ++i) {
+        digits[i] = k % g_inputs[i].levels.size();
+        k /= g_inputs[i].levels.size();
+    }
+    index.resize(g_inputs.size());
+    size_t slower = 0;
+    for (size_t i = g_inputs.size(); i-- > 0;) {
+        size_t size = g_inputs[i].levels.size();
+        index[i] = (slower % 2 == 1) ? size - 1 - digits[i] : digits[i];
+        slower += digits[i];
+    }
+}
+
+auto input_level(size_t k, size_t input) -> double {
+    static thread_local size_t cached = SIZE_MAX;
+    static thread_local std::vector<size_t> index;
+    if (k != cached) {
+        point_levels(k, index);
+        cached = k;
+    }
+    return g_inputs[input].levels[index[input]];
+}
+
+// Input voltage at a SPICE time, ramping from the previous point over the rise time
+auto input_value(size_t input, double time) -> double {
+    size_t k = std::min(static_cast<size_t>(std::max(time, 0.0) / g_dwell), g_points - 1);
+    double current = input_level(k, input);
+    double local = time - static_cast<double>(k) * g_dwell;
+    if (k == 0 || local >= g_rise) {
+        return current;
+    }
+    double previous = input_level(k - 1, input);
+    return previous + (current - previous) * local / g_rise;
+}
+
+int characterize_printf(char *output, int ident, void *userdata) {
+    std::printf("%s\n", output);
+    return 0;
+}
+
+int characterize_exit(int status, NG_BOOL immediate, NG_BOOL quit, int ident, void *userdata) {
+    set_done(false);
+    return status;
+}
+
+int characterize_bgthread_running(NG_BOOL noruns, int ident, void *userdata) {
+    if (noruns) {
+        set_done(false);
+    }
+    return 0;
+}
+
+int characterize_srcdata(double *vp, double time, char *source, int id, void *udp) {
+    std::string name = source + 1;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    for (size_t i = 0; i < g_inputs.size(); ++i) {
+        if (g_inputs[i].name == name) {
+            *vp = input_value(i, time);
+            return 0;
+        }
+    }
+    if (g_unknown.insert(name).second) {
+        std::fprintf(stderr, "spicebind_characterize: source %s is not swept, it stays at %g\n", source, *vp);
+    }
+    return 0;
+}
+
+int characterize_sync(double actual_time, double *delta_time, double old_delta_time, int redostep, int id, int location, void *user_data) {
+    if (redostep) {
+        return 0;
+    }
+
+    if (location == 0) {
+        g_steps++;
+        if (actual_time >= g_end_time) {
+            set_done(true);
+        }
+        return 0;
+    }
+
+    // end steps at the start and the end of each input ramp
+    const double eps = g_dwell * 1e-9;
+    const double step_start = actual_time - old_delta_time;
+    double point_start = std::floor((step_start + eps) / g_dwell) * g_dwell;
+    double next_break = (point_start + g_rise > step_start + eps) ? point_start + g_rise : point_start + g_dwell;
+    if (next_break < actual_time - eps) {
+        *delta_time = next_break - step_start;
+        return 1;
+    }
+    return 0;
+}
+
+void usage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [-o model.sbsurr] [--vcc V] [--digital a,b] [--analog vin=LO:HI:POINTS]\n"
+                 "          [--dwell T] [--rise T] [--settle V] <netlist> <output>...\n",
+                 program);
+}
+
+auto lower(std::string text) -> std::string {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+// "vin=0:1.8:33" -> analog input with 33 table points and the midpoints between them
+auto parse_analog(const std::string &spec, SweepInput &input) -> bool {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        return false;
+    }
+    double low = 0.0;
+    double high = 0.0;
+    int points = 0;
+    if (std::sscanf(spec.c_str() + equals + 1, "%lf:%lf:%d", &low, &high, &points) != 3 || points < 2 || high <= low) {
+        return false;
+    }
+    input.name = lower(spec.substr(0, equals));
+    input.digital = false;
+    size_t levels = 2 * static_cast<size_t>(points) - 1;
+    for (size_t j = 0; j < levels; ++j) {
+        input.levels.push_back(low + (high - low) * static_cast<double>(j) / static_cast<double>(levels - 1));
+    }
+    return true;
+}
+
+// Settled value and delay of one output at each sweep point
+void measure(const pvector_info time, const pvector_info output, double settle, std::vector<double> &settled, std::vector<double> &delays) {
+    const int n = std::min(time->v_length, output->v_length);
+    const double *t = time->v_realdata;
+    const double *v = output->v_realdata;
+    const double eps = g_dwell * 1e-9;
+
+    int last = 0;
+    for (size_t k = 0; k < g_points; ++k) {
+        double start = static_cast<double>(k) * g_dwell;
+        double end = start + g_dwell;
+        while (last + 1 < n && t[last + 1] <= end + eps) {
+            ++last;
+        }
+        double value = v[last];
+
+        // the output entered the settle band after the last sample outside it
+        double delay = 0.0;
+        for (int r = last; r > 0 && t[r - 1] >= start - eps; --r) {
+            double outside = std::abs(v[r - 1] - value);
+            if (outside > settle) {
+                double inside = std::abs(v[r] - value);
+                double frac = (outside - settle) / std::max(outside - inside, 1e-30);
+                delay = std::max(0.0, t[r - 1] + frac * (t[r] - t[r - 1]) - start);
+                break;
+            }
+        }
+        settled[k] = value;
+        delays[k] = delay;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string output_file = "model.sbsurr";
+    double vcc = 1.0;
+    double settle = -1.0;
+    std::string netlist;
+    std::vector<std::string> outputs;
+
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&]() -> const char * { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        const char *arg = argv[i];
+        const char *param = nullptr;
+        if (std::strcmp(arg, "-o") == 0 && (param = value()) != nullptr) {
+            output_file = param;
+        } else if (std::strcmp(arg, "--vcc") == 0 && (param = value()) != nullptr) {
+            vcc = std::atof(param);
+        } else if (std::strcmp(arg, "--dwell") == 0 && (param = value()) != nullptr) {
+            g_dwell = std::atof(param);
+        } else if (std::strcmp(arg, "--rise") == 0 && (param = value()) != nullptr) {
+            g_rise = std::atof(param);
+        } else if (std::strcmp(arg, "--settle") == 0 && (param = value()) != nullptr) {
+            settle = std::atof(param);
+        } else if (std::strcmp(arg, "--digital") == 0 && (param = value()) != nullptr) {
+            std::string names = param;
+            for (size_t start = 0; start <= names.size();) {
+                size_t comma = std::min(names.find(',', start), names.size());
+                if (comma > start) {
+                    SweepInput input;
+                    input.name = lower(names.substr(start, comma - start));
+                    input.digital = true;
+                    g_inputs.push_back(input);
+                }
+                start = comma + 1;
+            }
+        } else if (std::strcmp(arg, "--analog") == 0 && (param = value()) != nullptr) {
+            SweepInput input;
+            if (!parse_analog(param, input)) {
+                std::fprintf(stderr, "spicebind_characterize: --analog expects NAME=LO:HI:POINTS with POINTS >= 2 (got %s)\n", param);
+                return 2;
+            }
+            g_inputs.push_back(input);
+        } else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (netlist.empty()) {
+            netlist = arg;
+        } else {
+            outputs.push_back(lower(arg));
+        }
+    }
+    if (netlist.empty() || outputs.empty() || g_inputs.empty() || vcc <= 0.0 || g_dwell <= 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (settle <= 0.0) {
+        settle = 0.05 * vcc;
+    }
+    if (g_rise <= 0.0) {
+        g_rise = g_dwell / 100.0;
+    }
+    g_rise = std::min(g_rise, g_dwell / 2.0);
+
+    std::vector<SurrogateModel::Input> table_inputs;
+    for (SweepInput &input : g_inputs) {
+        SurrogateModel::Input table_input;
+        table_input.name = input.name;
+        table_input.digital = input.digital;
+        if (input.digital) {
+            input.levels = {0.0, vcc};
+            table_input.grid = input.levels;
+        } else {
+            for (size_t j = 0; j < input.levels.size(); j += 2) {
+                table_input.grid.push_back(input.levels[j]);
+            }
+        }
+        table_inputs.push_back(table_input);
+
+        if (g_points > MAX_POINTS / input.levels.size()) {
+            std::fprintf(stderr, "spicebind_characterize: more than %zu sweep points, use fewer inputs or points\n", MAX_POINTS);
+            return 2;
+        }
+        g_points *= input.levels.size();
+    }
+    std::vector<SurrogateModel::Output> table_outputs;
+    for (const std::string &name : outputs) {
+        SurrogateModel::Output output;
+        output.name = name;
+        table_outputs.push_back(output);
+    }
+
+    std::unique_ptr<SurrogateModel> model;
+    try {
+        model = std::make_unique<SurrogateModel>(table_inputs, table_outputs);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "spicebind_characterize: %s\n", e.what());
+        return 2;
+    }
+    g_end_time = static_cast<double>(g_points) * g_dwell;
+    std::printf("spicebind_characterize: %zu sweep points of %g s, %g s of SPICE time\n", g_points, g_dwell, g_end_time);
+
+    static int ident = 0;
+    if (ngSpice_Init(characterize_printf, nullptr, characterize_exit, nullptr, nullptr, characterize_bgthread_running, nullptr) != 0 ||
+        ngSpice_Init_Sync(characterize_srcdata, nullptr, characterize_sync, &ident, nullptr) != 0) {
+        std::fprintf(stderr, "spicebind_characterize: failed to initialize ngspice\n");
+        return 1;
+    }
+
+    std::string source_command = "source " + netlist;
+    ngSpice_Command(&source_command[0]);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(g_done_mutex);
+        g_running = true;
+    }
+    ngSpice_Command(const_cast<char *>("bg_run"));
+    {
+        std::unique_lock<std::mutex> lock(g_done_mutex);
+        g_done_cv.wait(lock, [] { return !g_running; });
+    }
+    ngSpice_Command(const_cast<char *>("bg_halt"));
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!g_reached_end) {
+        std::fprintf(stderr, "spicebind_characterize: the transient ended before the sweep, extend .tran to at least %g s\n", g_end_time);
+        return 1;
+    }
+
+    pvector_info time = ngGet_Vec_Info(const_cast<char *>("time"));
+    if (time == nullptr || time->v_length == 0) {
+        std::fprintf(stderr, "spicebind_characterize: no transient time vector\n");
+        return 1;
+    }
+
+    // settled value and delay at every sweep point, per output
+    std::vector<std::vector<double>> settled(outputs.size(), std::vector<double>(g_points));
+    std::vector<std::vector<double>> delays(outputs.size(), std::vector<double>(g_points));
+    for (size_t j = 0; j < outputs.size(); ++j) {
+        std::string vector_name = "v(" + outputs[j] + ")";
+        pvector_info vector = ngGet_Vec_Info(&vector_name[0]);
+        if (vector == nullptr || vector->v_length == 0) {
+            std::fprintf(stderr, "spicebind_characterize: output %s not found in the netlist\n", outputs[j].c_str());
+            return 1;
+        }
+        measure(time, vector, settle, settled[j], delays[j]);
+    }
+
+    // points on the table grid fill the table, the analog midpoints validate its interpolation
+    std::vector<size_t> index;
+    std::vector<size_t> validation;
+    for (size_t k = 0; k < g_points; ++k) {
+        point_levels(k, index);
+        size_t point = 0;
+        size_t stride = 1;
+        bool on_grid = true;
+        for (size_t i = 0; i < g_inputs.size(); ++i) {
+            size_t level = g_inputs[i].digital ? index[i] : index[i] / 2;
+            on_grid = on_grid && (g_inputs[i].digital || index[i] % 2 == 0);
+            point += level * stride;
+            stride *= table_inputs[i].grid.size();
+        }
+        if (!on_grid) {
+            validation.push_back(k);
+            continue;
+        }
+        for (size_t j = 0; j < outputs.size(); ++j) {
+            model->set_point(point, j, settled[j][k], delays[j][k]);
+        }
+    }
+
+    const double low = 0.3 * vcc;
+    const double high = 0.7 * vcc;
+    auto level = [&](double v) { return v < low ? 0 : (v > high ? 1 : 2); };
+    std::vector<double> voltages(g_inputs.size());
+    std::vector<double> values(outputs.size());
+    std::vector<double> value_delays(outputs.size());
+    std::vector<double> max_error(outputs.size(), 0.0);
+    std::vector<unsigned long long> mismatches(outputs.size(), 0);
+    for (size_t k : validation) {
+        point_levels(k, index);
+        for (size_t i = 0; i < g_inputs.size(); ++i) {
+            voltages[i] = g_inputs[i].levels[index[i]];
+        }
+        model->evaluate(voltages.data(), values.data(), value_delays.data());
+        for (size_t j = 0; j < outputs.size(); ++j) {
+            max_error[j] = std::max(max_error[j], std::abs(values[j] - settled[j][k]));
+            mismatches[j] += (level(values[j]) != level(settled[j][k])) ? 1 : 0;
+        }
+    }
+    for (size_t j = 0; j < outputs.size(); ++j) {
+        model->set_error(j, max_error[j], mismatches[j]);
+    }
+
+    try {
+        model->save(output_file);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "spicebind_characterize: %s\n", e.what());
+        return 1;
+    }
+
+    std::printf("spicebind_characterize: %zu table points, %zu validation points, %llu steps in %.3f s wall\n", model->points(),
+                validation.size(), g_steps.load(), wall_s);
+    for (const SurrogateModel::Output &output : model->outputs()) {
+        std::printf("  %s: max error %g V, %llu logic mismatches, delay up to %g s\n", output.name.c_str(), output.max_error,
+                    output.mismatches, output.max_delay);
+    }
+    std::printf("spicebind_characterize: written to %s\n", output_file.c_str());
+    std::fflush(nullptr);
+    return 0;
+}
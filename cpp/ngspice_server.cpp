@@ -0,0 +1,387 @@
+// spicebind_ngspice_server: hosts libngspice for the spicebind VPI module
+//
+// Usage: spicebind_ngspice_server <shared memory name>
+//
+// Started by NgSpiceRemote. Simulator requests are executed in order on a
+// worker thread, since commands like bg_halt block. Requests made from inside
+// an ngspice callback are served on the reader thread while the ngspice
+// background thread waits for the callback reply.
+
+#include "ShmChannel.h"
+#include "ngspice/sharedspice.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+#include <unistd.h>
+
+using spice_vpi::ShmChannel;
+using spice_vpi::ShmMessage;
+
+static ShmChannel *g_channel = nullptr;
+static std::mutex g_send_mutex;
+
+// replies to the callbacks of the ngspice background thread
+static std::mutex g_reply_mutex;
+static std::condition_variable g_reply_cv;
+static std::deque<ShmMessage> g_replies;
+
+// simulator requests for the worker thread
+static std::mutex g_work_mutex;
+static std::condition_variable g_work_cv;
+static std::deque<ShmMessage> g_work;
+
+static std::vector<std::string> g_circ_lines;
+static std::atomic<bool> g_send_data{false};  // forward the vector data callbacks
+
+static void send(const ShmMessage &message) {
+    std::lock_guard<std::mutex> lock(g_send_mutex);
+    g_channel->send(message);
+}
+
+static auto wait_callback_reply(ShmMessage &reply) -> bool {
+    std::unique_lock<std::mutex> lock(g_reply_mutex);
+    while (g_replies.empty()) {
+        if (g_channel->is_closed()) {
+            return false;
+        }
+        g_reply_cv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    reply = g_replies.front();
+    g_replies.pop_front();
+    return true;
+}
+
+static int srv_printf(char *output, int ident, void *userdata) {
+    ShmMessage message;
+    message.type = ShmMessage::Print;
+    std::string text(output);
+    if (text.size() >= ShmMessage::PAYLOAD_SIZE) {
+        text.resize(ShmMessage::PAYLOAD_SIZE - 1);
+    }
+    message.set_payload(text);
+    send(message);
+    return 0;
+}
+
+static int srv_exit(int status, NG_BOOL immediate, NG_BOOL quit, int ident, void *userdata) {
+    ShmMessage message;
+    message.type = ShmMessage::Exit;
+    message.arg = status;
+    send(message);
+    std::fflush(nullptr);
+    _exit(status);
+}
+
+static int srv_init_data(pvecinfoall info, int ident, void *userdata) {
+    if (!g_send_data.load()) {
+        return 0;
+    }
+    ShmMessage message;
+    message.type = ShmMessage::PlotInit;
+    message.arg = info->veccount;
+    std::string type = (info->type != nullptr) ? info->type : "";
+    std::string title = (info->title != nullptr) ? info->title : "";
+    type.resize(std::min<size_t>(type.size(), ShmMessage::PAYLOAD_SIZE / 2 - 1));
+    title.resize(std::min<size_t>(title.size(), ShmMessage::PAYLOAD_SIZE / 2 - 1));
+    std::memcpy(message.payload, type.c_str(), type.size() + 1);
+    std::memcpy(message.payload + type.size() + 1, title.c_str(), title.size() + 1);
+    message.length = static_cast<uint32_t>(type.size() + title.size() + 2);
+    send(message);
+
+    for (int i = 0; i < info->veccount; ++i) {
+        ShmMessage vec;
+        vec.type = ShmMessage::VecInit;
+        vec.arg = i;
+        vec.set_payload(info->vecs[i]->vecname);
+        send(vec);
+    }
+    return 0;
+}
+
+// One point of all vectors, split over as many messages as needed
+static int srv_data(pvecvaluesall values, int count, int ident, void *userdata) {
+    if (!g_send_data.load()) {
+        return 0;
+    }
+    constexpr int per_message = static_cast<int>(ShmMessage::PAYLOAD_SIZE / sizeof(double));
+    int first = 0;
+    do {
+        int n = std::min(per_message, values->veccount - first);
+        ShmMessage message;
+        message.type = ShmMessage::VecValues;
+        message.arg = first;
+        message.arg2 = values->veccount;
+        auto *payload = reinterpret_cast<double *>(message.payload);
+        for (int i = 0; i < n; ++i) {
+            payload[i] = values->vecsa[first + i]->creal;
+        }
+        message.length = static_cast<uint32_t>(n * sizeof(double));
+        send(message);
+        first += n;
+    } while (first < values->veccount);
+    return 0;
+}
+
+// XSPICE event node reported at the start of the simulation
+static int srv_evt_init(int index, int max_index, char *name, char *type, int ident, void *userdata) {
+    ShmMessage message;
+    message.type = ShmMessage::EvtNode;
+    message.arg = index;
+    message.arg2 = max_index;
+    size_t name_size = std::strlen(name) + 1;
+    size_t type_size = std::strlen(type) + 1;
+    if (name_size + type_size > ShmMessage::PAYLOAD_SIZE) {
+        return 0;
+    }
+    std::memcpy(message.payload, name, name_size);
+    std::memcpy(message.payload + name_size, type, type_size);
+    message.length = static_cast<uint32_t>(name_size + type_size);
+    send(message);
+    return 0;
+}
+
+// XSPICE event node changed, no reply needed
+static int srv_evt_data(int index, double step, double dvalue, char *svalue, void *pvalue, int plen, int mode, int ident, void *userdata) {
+    ShmMessage message;
+    message.type = ShmMessage::EvtData;
+    message.arg = index;
+    message.arg2 = mode;
+    message.time = step;
+    message.value = dvalue;
+    message.set_payload(svalue != nullptr ? svalue : "");
+    send(message);
+    return 0;
+}
+
+// ngSpice_Init_Evt only exists in XSPICE builds of libngspice
+static int init_evt() {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&ngSpice_Init), &info) == 0 || info.dli_fname == nullptr) {
+        return -1;
+    }
+    void *handle = dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD);
+    if (handle == nullptr) {
+        return -1;
+    }
+    using InitEvt = int (*)(decltype(&srv_evt_data), decltype(&srv_evt_init), void *);
+    auto init = reinterpret_cast<InitEvt>(dlsym(handle, "ngSpice_Init_Evt"));
+    int ret = (init != nullptr) ? init(srv_evt_data, srv_evt_init, nullptr) : -1;
+    dlclose(handle);
+    return ret;
+}
+
+static int srv_bgthread_running(NG_BOOL noruns, int ident, void *userdata) {
+    ShmMessage message;
+    message.type = ShmMessage::BgThread;
+    message.arg = noruns ? 1 : 0;
+    send(message);
+    return 0;
+}
+
+static int srv_srcdata(double *vp, double time, char *source, int id, void *udp) {
+    ShmMessage message;
+    message.type = ShmMessage::SrcData;
+    message.time = time;
+    message.value = *vp;
+    message.set_payload(source);
+    send(message);
+
+    ShmMessage reply;
+    if (!wait_callback_reply(reply)) {
+        return 0;
+    }
+    *vp = reply.value;
+    return reply.arg;
+}
+
+static int srv_sync(double actual_time, double *delta_time, double old_delta_time, int redostep, int id, int location, void *user_data) {
+    ShmMessage message;
+    message.type = ShmMessage::SyncData;
+    message.time = actual_time;
+    message.value = *delta_time;
+    message.value2 = old_delta_time;
+    message.arg = redostep;
+    message.arg2 = location;
+    send(message);
+
+    ShmMessage reply;
+    if (!wait_callback_reply(reply)) {
+        return 0;
+    }
+    *delta_time = reply.value;
+    return reply.arg;
+}
+
+static void send_list_item(uint32_t requester, const char *item) {
+    ShmMessage message;
+    message.type = ShmMessage::ListItem;
+    message.requester = requester;
+    message.set_payload(item);
+    send(message);
+}
+
+static void handle_request(const ShmMessage &request) {
+    ShmMessage reply;
+    reply.requester = request.requester;
+
+    switch (request.type) {
+    case ShmMessage::Command: {
+        std::string command = request.payload_string();
+        reply.type = ShmMessage::CommandDone;
+        reply.arg = ngSpice_Command(&command[0]);
+        break;
+    }
+    case ShmMessage::CircLine:
+        g_circ_lines.push_back(request.payload_string());
+        return;
+    case ShmMessage::CircEnd: {
+        std::vector<char *> circarray;
+        for (std::string &line : g_circ_lines) {
+            circarray.push_back(&line[0]);
+        }
+        circarray.push_back(nullptr);
+        reply.type = ShmMessage::CommandDone;
+        reply.arg = ngSpice_Circ(circarray.data());
+        g_circ_lines.clear();
+        break;
+    }
+    case ShmMessage::DataEnable:
+        g_send_data.store(request.arg != 0);
+        return;
+    case ShmMessage::InitEvt:
+        reply.type = ShmMessage::CommandDone;
+        reply.arg = init_evt();
+        break;
+    case ShmMessage::Running:
+        reply.type = ShmMessage::CommandDone;
+        reply.arg = ngSpice_running() ? 1 : 0;
+        break;
+    case ShmMessage::CurPlot: {
+        char *plot = ngSpice_CurPlot();
+        if (plot != nullptr) {
+            send_list_item(request.requester, plot);
+        }
+        reply.type = ShmMessage::ListEnd;
+        break;
+    }
+    case ShmMessage::AllVecs: {
+        std::string plot = request.payload_string();
+        char **vecs = ngSpice_AllVecs(&plot[0]);
+        for (char **vec = vecs; vec != nullptr && *vec != nullptr; ++vec) {
+            send_list_item(request.requester, *vec);
+        }
+        reply.type = ShmMessage::ListEnd;
+        break;
+    }
+    case ShmMessage::GetVec: {
+        std::string name = request.payload_string();
+        pvector_info info = ngGet_Vec_Info(&name[0]);
+        reply.type = ShmMessage::VecInfo;
+        reply.arg = -1;
+        if (info != nullptr) {
+            reply.arg = info->v_length;
+            reply.arg2 = info->v_type;
+            if (info->v_realdata != nullptr && info->v_length > 0) {
+                reply.value = info->v_realdata[info->v_length - 1];
+            }
+        }
+        break;
+    }
+    default:
+        return;
+    }
+
+    send(reply);
+}
+
+static void worker() {
+    while (true) {
+        ShmMessage request;
+        {
+            std::unique_lock<std::mutex> lock(g_work_mutex);
+            g_work_cv.wait(lock, [] { return !g_work.empty(); });
+            request = g_work.front();
+            g_work.pop_front();
+        }
+        if (request.type == ShmMessage::Quit) {
+            return;
+        }
+        handle_request(request);
+    }
+}
+
+static void queue_work(const ShmMessage &request) {
+    std::lock_guard<std::mutex> lock(g_work_mutex);
+    g_work.push_back(request);
+    g_work_cv.notify_one();
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <shared memory name>\n", argv[0]);
+        return 2;
+    }
+
+    ShmChannel channel = [&] {
+        try {
+            return ShmChannel::open(argv[1]);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "spicebind_ngspice_server: %s\n", e.what());
+            std::exit(1);
+        }
+    }();
+    g_channel = &channel;
+    const pid_t parent = getppid();
+
+    static int ident = 0;
+    ShmMessage ready;
+    ready.type = ShmMessage::Ready;
+    ready.arg = ngSpice_Init(srv_printf, nullptr, srv_exit, srv_data, srv_init_data, srv_bgthread_running, nullptr);
+    if (ready.arg == 0) {
+        ready.arg = ngSpice_Init_Sync(srv_srcdata, nullptr, srv_sync, &ident, nullptr);
+    }
+    send(ready);
+
+    std::thread worker_thread(worker);
+
+    ShmMessage message;
+    while (true) {
+        if (!channel.receive(message, std::chrono::milliseconds(100))) {
+            // stop with the simulator, also if it died without saying goodbye
+            if (channel.is_closed() || getppid() != parent) {
+                break;
+            }
+            continue;
+        }
+
+        if (message.type == ShmMessage::SrcReply || message.type == ShmMessage::SyncReply) {
+            std::lock_guard<std::mutex> lock(g_reply_mutex);
+            g_replies.push_back(message);
+            g_reply_cv.notify_one();
+        } else if (message.type == ShmMessage::Quit) {
+            break;
+        } else if (message.requester == ShmMessage::Callback) {
+            handle_request(message);
+        } else {
+            queue_work(message);
+        }
+    }
+
+    ShmMessage quit;
+    quit.type = ShmMessage::Quit;
+    queue_work(quit);
+    worker_thread.join();
+
+    // the ngspice background thread may still wait for a callback reply
+    std::fflush(nullptr);
+    _exit(0);
+}
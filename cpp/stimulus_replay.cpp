@@ -0,0 +1,168 @@
+// spicebind_replay: reruns a netlist in ngspice with the inputs of a recorded co-simulation
+//
+// Usage: spicebind_replay [-o dump.raw] [--end TIME] <netlist> <stimulus>
+//
+// The stimulus is written by the VPI module with SPICE_RECORD_STIMULUS. Its
+// external sources get the recorded values, steps are cut at the recorded
+// input changes like the co-simulation's redos would, and the run stops at the
+// end of the recording. No HDL simulator or time barrier is involved.
+
+#include "StimulusRecord.h"
+#include "ngspice/sharedspice.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+using spice_vpi::StimulusReplay;
+
+static std::unique_ptr<StimulusReplay> g_replay;
+static double g_end_time = 0.0;
+static std::atomic<unsigned long long> g_srcdata_calls{0};
+static std::atomic<unsigned long long> g_steps{0};
+static std::atomic<unsigned long long> g_cuts{0};
+static std::set<std::string> g_missing;  // ngspice thread only
+
+static std::mutex g_done_mutex;
+static std::condition_variable g_done_cv;
+static bool g_running = false;
+static bool g_reached_end = false;
+
+static void set_done(bool reached_end) {
+    std::lock_guard<std::mutex> lock(g_done_mutex);
+    g_reached_end = g_reached_end || reached_end;
+    g_running = false;
+    g_done_cv.notify_all();
+}
+
+static int replay_printf(char *output, int ident, void *userdata) {
+    std::printf("%s\n", output);
+    return 0;
+}
+
+static int replay_exit(int status, NG_BOOL immediate, NG_BOOL quit, int ident, void *userdata) {
+    set_done(false);
+    return status;
+}
+
+static int replay_bgthread_running(NG_BOOL noruns, int ident, void *userdata) {
+    if (noruns) {
+        set_done(false);
+    }
+    return 0;
+}
+
+static int replay_srcdata(double *vp, double time, char *source, int id, void *udp) {
+    g_srcdata_calls++;
+    if (!g_replay->value(source, time, *vp) && g_missing.insert(source).second) {
+        std::fprintf(stderr, "spicebind_replay: source %s is not in the recording, it stays at %g\n", source, *vp);
+    }
+    return 0;
+}
+
+static int replay_sync(double actual_time, double *delta_time, double old_delta_time, int redostep, int id, int location, void *user_data) {
+    if (redostep) {
+        return 0;
+    }
+
+    if (location == 0) {
+        g_steps++;
+        if (actual_time >= g_end_time) {
+            set_done(true);
+        }
+        return 0;
+    }
+
+    // end the step at the next input change, as the co-simulation's redo would
+    const double step_start = actual_time - old_delta_time;
+    const double change = g_replay->next_change(step_start);
+    if (change > 0.0 && change < actual_time - g_replay->time_tolerance()) {
+        *delta_time = change - step_start;
+        g_cuts++;
+        return 1;
+    }
+    return 0;
+}
+
+static void usage(const char *program) {
+    std::fprintf(stderr, "usage: %s [-o dump.raw] [--end TIME] <netlist> <stimulus>\n", program);
+}
+
+int main(int argc, char **argv) {
+    std::string output = "replay.raw";
+    double end_time = -1.0;
+    std::string netlist;
+    std::string stimulus;
+
+    for (int i = 1; i < argc; ++i) {
+        if ((std::strcmp(argv[i], "-o") == 0) && i + 1 < argc) {
+            output = argv[++i];
+        } else if ((std::strcmp(argv[i], "--end") == 0) && i + 1 < argc) {
+            end_time = std::atof(argv[++i]);
+        } else if (netlist.empty()) {
+            netlist = argv[i];
+        } else if (stimulus.empty()) {
+            stimulus = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (netlist.empty() || stimulus.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        g_replay = std::make_unique<StimulusReplay>(stimulus);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "spicebind_replay: %s\n", e.what());
+        return 1;
+    }
+    g_end_time = (end_time > 0.0) ? end_time : g_replay->end_time();
+    if (g_end_time <= 0.0) {
+        std::fprintf(stderr, "spicebind_replay: %s has no recorded time, pass --end\n", stimulus.c_str());
+        return 1;
+    }
+    for (const auto &[source, changes] : g_replay->sources()) {
+        std::printf("spicebind_replay: source %s, %zu changes\n", source.c_str(), changes);
+    }
+
+    static int ident = 0;
+    if (ngSpice_Init(replay_printf, nullptr, replay_exit, nullptr, nullptr, replay_bgthread_running, nullptr) != 0 ||
+        ngSpice_Init_Sync(replay_srcdata, nullptr, replay_sync, &ident, nullptr) != 0) {
+        std::fprintf(stderr, "spicebind_replay: failed to initialize ngspice\n");
+        return 1;
+    }
+
+    std::string source_command = "source " + netlist;
+    ngSpice_Command(&source_command[0]);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(g_done_mutex);
+        g_running = true;
+    }
+    ngSpice_Command(const_cast<char *>("bg_run"));
+    {
+        std::unique_lock<std::mutex> lock(g_done_mutex);
+        g_done_cv.wait(lock, [] { return !g_running; });
+    }
+    ngSpice_Command(const_cast<char *>("bg_halt"));
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string write_command = "write " + output;
+    ngSpice_Command(&write_command[0]);
+
+    std::printf("spicebind_replay: %g s replayed in %.3f s wall, %llu steps (%llu cut at input changes), %llu source values, written to %s\n",
+                g_end_time, wall_s, g_steps.load(), g_cuts.load(), g_srcdata_calls.load(), output.c_str());
+    std::fflush(nullptr);
+    return g_reached_end ? 0 : 1;
+}
@@ -1,14 +1,10 @@
 
-#include "TimeBarrier.h"
-#include "Config.h"
-#include "AnalogDigitalInterface.h"
+#include "CoSimSession.h"
 
 #include "VpiCallbacks.h"
 
-// Global variables
-spice_vpi::TimeBarrier<unsigned long long> g_time_barrier;
-spice_vpi::Config::Settings g_config;
-std::unique_ptr<spice_vpi::AnalogDigitalInterface> g_interface;
+// Process-wide co-simulation session, passed to the callbacks as user data
+spice_vpi::CoSimSession g_session;
 
 /* This array tells Icarus which init function(s) to call */
 void (*vlog_startup_routines[])(void) = {
@@ -16,13 +12,14 @@ void (*vlog_startup_routines[])(void) = {
     nullptr
 };
 
-// Build command:
-// g++ -shared -fPIC -std=c++17 -I./cpp -I/home/tomasz.hemperek/miniconda3/include -L/home/tomasz.hemperek/miniconda3/lib -lngspice cpp/Config.cpp cpp/AnalogDigitalInterface.cpp cpp/NgSpiceCallbacks.cpp cpp/VpiCallbacks.cpp cpp/vpi_module.cpp -o spicebind/spicebind_vpi.vpi
+// Build (the source list lives in CMakeLists.txt):
+// cmake -S . -B build && cmake --build build  -> spicebind/spicebind_vpi.vpi and spicebind_vpi_debug.vpi
 
-// Build command profiler:
-// g++ -shared -fPIC -std=c++17 -g -lprofiler -I./cpp -I/home/tomasz.hemperek/miniconda3/include -L/home/tomasz.hemperek/miniconda3/lib -lngspice cpp/Config.cpp cpp/AnalogDigitalInterface.cpp cpp/NgSpiceCallbacks.cpp cpp/VpiCallbacks.cpp cpp/vpi_module.cpp -o spicebind/spicebind_vpi.vpi  
-// CPUPROFILE=./myprof.prof  python examples/adc/test_flash_adc8.py
-// pprof --cum  --line --text spicebind/spicebind_vpi.vpi sim_build/myprof.prof > profline
+// Profiling build (optimised, frame pointers and debug info):
+// cmake --build build --target profile      -> spicebind/spicebind_vpi_profile.vpi
+// perf record -g vvp -M ./spicebind -m spicebind_vpi_profile tests/tb
+// LD_PRELOAD=libprofiler.so CPUPROFILE=./myprof.prof vvp -M ./spicebind -m spicebind_vpi_profile tests/tb
+// pprof --cum  --line --text spicebind/spicebind_vpi_profile.vpi myprof.prof > profline
 
 // Usage:
 // iverilog tests/tb.sv -o tests/tb
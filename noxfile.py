@@ -8,6 +8,8 @@
 """Setup file for nox (https://nox.thea.codes/en/stable/tutorial.html)."""
 
 
+from pathlib import Path
+
 import nox
 
 # Python 3.11+ has tomllib built-in, use tomli for earlier versions
@@ -60,6 +62,18 @@ def test_sdist(session: nox.Session) -> None:
     session.run("pytest", *session.posargs)
 
 
+@nox.session
+def bench(session: nox.Session) -> None:
+    """Run the end-to-end co-simulation benchmarks, against bench/baseline.json if present."""
+    dev_deps = get_dev_dependencies()
+    session.install(".", *dev_deps)
+    args = list(session.posargs)
+    baseline = Path("bench/baseline.json")
+    if baseline.exists() and "--baseline" not in args and "--save-baseline" not in args:
+        args += ["--baseline", str(baseline)]
+    session.run("spicebind", "bench", *args)
+
+
 @nox.session
 def docs(session: nox.Session) -> None:
     """Invoke sphinx-build to build the HTML docs."""
@@ -6,14 +6,16 @@ using the VPI interface.
 """
 
 try:
-    from importlib.metadata import version
-    __version__ = version("spicebind")
+    from importlib.metadata import PackageNotFoundError, version
 except ImportError:
     # Fallback for Python < 3.8 (though you require 3.8+)
-    from importlib_metadata import version
+    from importlib_metadata import PackageNotFoundError, version
+
+try:
     __version__ = version("spicebind")
-except Exception:
+except PackageNotFoundError:
     # Fallback for development environments where package isn't installed
+    # (e.g. the pgo-train target running from the source tree)
     __version__ = "dev"
 
 
@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+"""
+End-to-end co-simulation benchmarks (``spicebind bench``).
+
+Runs the examples and generated synthetic netlists under a simulator with
+SPICE_STATS_JSON enabled and reports wall time, ng_sync/ng_srcdata counts,
+redo rate and peak RSS per case. Results can be saved as a baseline and later
+runs compared against it to catch regressions in the synchronisation logic.
+"""
+
+import fnmatch
+import json
+import os
+import sys
+import time
+from pathlib import Path
+
+import spicebind
+
+RESULTS_VERSION = 1
+
+# Scaling sweeps of the synthetic cases: ports, input toggle period (ns) and stiffness
+SYNTH_PORTS = [1, 4, 16, 64, 256, 1024]
+SYNTH_TOGGLE_NS = [1.0, 10.0, 100.0]
+SYNTH_STIFFNESS = [1.0, 1e2, 1e4]
+SYNTH_DURATION_NS = 1000.0
+QUICK_PORTS = [1, 16, 64]
+
+# Metrics compared against the baseline: (key, tolerance option)
+COMPARED_METRICS = [
+    ("wall_s", "tolerance"),
+    ("ng_sync", "count_tolerance"),
+    ("srcdata", "count_tolerance"),
+    ("redos", "count_tolerance"),
+    ("peak_rss_bytes", "tolerance"),
+]
+
+
+class Case:
+    """One benchmark: HDL sources, netlist and the cocotb test driving it."""
+
+    def __init__(self, name, toplevel, sources, test_module, env, test_path=None, generate=None):
+        self.name = name
+        self.toplevel = toplevel
+        self.sources = sources
+        self.test_module = test_module
+        self.env = env
+        self.test_path = test_path  # directory of the cocotb test module (None if importable)
+        self.generate = generate  # writes generated files into the case directory
+
+
+def synthetic_netlist(ports, toggle_ns, stiffness):
+    """
+    RC netlist with one external source per input driving one output.
+
+    Each output is an RC low-pass with a time constant of a tenth of the toggle
+    period, loaded by a second pole ``stiffness`` times faster.
+    """
+    r = 1e3
+    c_slow = toggle_ns * 1e-9 / 10.0 / r
+    c_fast = c_slow / stiffness
+    lines = [f"* spicebind bench: {ports} ports, toggle {toggle_ns:g} ns, stiffness {stiffness:g}", ""]
+    for i in range(ports):
+        lines += [
+            f"VA{i} a{i} 0 0 external",
+            f"R{i} a{i} y{i} {r:g}",
+            f"C{i} y{i} 0 {c_slow:g}",
+            f"RF{i} y{i} f{i} {r:g}",
+            f"CF{i} f{i} 0 {c_fast:g}",
+            "",
+        ]
+    lines += [f".tran {toggle_ns / 20.0:g}ns 1", "", ".end", ""]
+    return "\n".join(lines)
+
+
+def synthetic_verilog(ports):
+    """Module with inputs a<i> and outputs y<i>, all driven through spicebind."""
+    inputs = ", ".join(f"a{i}" for i in range(ports))
+    outputs = ", ".join(f"y{i}" for i in range(ports))
+    return (
+        "`timescale 1ns/1ps\n\n"
+        "module synth(\n"
+        f"    input wire {inputs},\n"
+        f"    output wire {outputs}\n"
+        ");\n\n"
+        "endmodule\n"
+    )
+
+
+def synthetic_case(ports, toggle_ns, stiffness, duration_ns=SYNTH_DURATION_NS):
+    name = f"synth_p{ports}_t{toggle_ns:g}ns_s{stiffness:g}"
+
+    def generate(case_dir):
+        (case_dir / "synth.v").write_text(synthetic_verilog(ports))
+        (case_dir / "synth.cir").write_text(synthetic_netlist(ports, toggle_ns, stiffness))
+
+    return Case(
+        name,
+        toplevel="synth",
+        sources=["synth.v"],
+        test_module="spicebind.bench_tb",
+        env={
+            "SPICE_NETLIST": "synth.cir",
+            "HDL_INSTANCE": "synth",
+            "VCC": "1.0",
+            "BENCH_PORTS": str(ports),
+            "BENCH_TOGGLE_NS": f"{toggle_ns:g}",
+            "BENCH_DURATION_NS": f"{duration_ns:g}",
+        },
+        generate=generate,
+    )
+
+
+def example_cases(root):
+    """The repository's examples, skipped when they are not in root."""
+    cases = []
+    adc = root / "examples" / "adc"
+    if (adc / "flash_adc8.v").exists():
+        cases.append(
+            Case(
+                "flash_adc8",
+                toplevel="flash_adc8",
+                sources=[str(adc / "flash_adc8.v")],
+                test_module="test_flash_adc8",
+                env={"SPICE_NETLIST": str(adc / "flash_adc8.cir"), "HDL_INSTANCE": "flash_adc8"},
+                test_path=adc,
+            )
+        )
+    spi = root / "examples" / "spi_adc"
+    if (spi / "spi_adc.v").exists():
+        cases.append(
+            Case(
+                "spi_adc",
+                toplevel="spi_adc",
+                sources=[str(spi / "spi_adc.v")],
+                test_module="test_spi_adc",
+                env={"SPICE_NETLIST": str(spi / "spi_adc.cir"), "HDL_INSTANCE": "spi_adc.adc_inst", "COCOTB_RESOLVE_X": "ZEROS"},
+                test_path=spi,
+            )
+        )
+    tests = root / "tests"
+    if (tests / "tb.sv").exists():
+
+        def generate(case_dir):
+            (case_dir / "test.cir").write_text((tests / "test.cir").read_text().format(VCC=1.8))
+
+        cases.append(
+            Case(
+                "tb",
+                toplevel="tb",
+                sources=[str(tests / "tb.sv")],
+                test_module="test_tb",
+                env={"SPICE_NETLIST": "test.cir", "HDL_INSTANCE": "tb.test_cir", "VCC": "1.8"},
+                test_path=tests,
+                generate=generate,
+            )
+        )
+    return cases
+
+
+def all_cases(root, quick=False):
+    """Examples followed by the synthetic sweeps (ports, toggle rate, stiffness)."""
+    cases = [] if quick else example_cases(root)
+    for ports in QUICK_PORTS if quick else SYNTH_PORTS:
+        cases.append(synthetic_case(ports, 10.0, 1.0))
+    for toggle_ns in [] if quick else SYNTH_TOGGLE_NS:
+        if toggle_ns != 10.0:
+            cases.append(synthetic_case(16, toggle_ns, 1.0))
+    for stiffness in [1e3] if quick else SYNTH_STIFFNESS:
+        if stiffness != 1.0:
+            cases.append(synthetic_case(16, 10.0, stiffness))
+    return cases
+
+
+def metrics(stats, wall_s):
+    """Benchmark metrics of one SPICE_STATS_JSON report."""
+    partitions = stats["partitions"]
+    end_of_step = sum(p["ng_sync"]["end_of_step"] for p in partitions)
+    redos = sum(p["redos"]["performed"] for p in partitions)
+    return {
+        "wall_s": stats["wall_time_s"],
+        "process_wall_s": wall_s,
+        "sim_s": stats["sim_time_s"],
+        "ng_sync": sum(sum(p["ng_sync"].values()) for p in partitions),
+        "srcdata": sum(p["srcdata"]["total"] for p in partitions),
+        "steps": end_of_step,
+        "redos": redos,
+        "redo_rate": redos / end_of_step if end_of_step else 0.0,
+        "input_events": sum(p["input_events"] for p in partitions),
+        "barrier_blocked_s": stats["hdl"]["barrier"]["blocked_s"],
+        "peak_rss_bytes": stats.get("peak_rss_bytes", 0),
+    }
+
+
+def run_case(case, work_dir, sim, vpi_module):
+    """Build and run one case with a VPI module file, return its metrics."""
+    from cocotb.runner import get_runner
+
+    case_dir = (work_dir / case.name).resolve()
+    case_dir.mkdir(parents=True, exist_ok=True)
+    if case.generate:
+        case.generate(case_dir)
+    stats_file = case_dir / "stats.json"
+    if stats_file.exists():
+        stats_file.unlink()
+
+    sources = [case_dir / source if not Path(source).is_absolute() else Path(source) for source in case.sources]
+    env = {key: str(case_dir / value) if key == "SPICE_NETLIST" and not Path(value).is_absolute() else value for key, value in case.env.items()}
+    env["SPICE_STATS_JSON"] = str(stats_file)
+
+    # the simulator imports the test module through PYTHONPATH, taken from sys.path
+    if case.test_path is not None and str(case.test_path) not in sys.path:
+        sys.path.insert(0, str(case.test_path))
+
+    runner = get_runner(sim)
+    runner.build(sources=sources, hdl_toplevel=case.toplevel, always=True, build_dir=case_dir)
+    start = time.perf_counter()
+    runner.test(
+        hdl_toplevel=case.toplevel,
+        test_module=case.test_module,
+        test_args=["-M", str(vpi_module.parent), "-m", vpi_module.stem],
+        extra_env=env,
+        build_dir=case_dir,
+        test_dir=case_dir,
+    )
+    wall_s = time.perf_counter() - start
+
+    if not stats_file.exists():
+        raise RuntimeError(f"{case.name}: no statistics written to {stats_file}")
+    return metrics(json.loads(stats_file.read_text()), wall_s)
+
+
+def compare(results, baseline, tolerance, count_tolerance):
+    """
+    Compare results against a baseline.
+
+    Returns a list of regression messages; a metric regresses when it exceeds
+    its baseline value by more than its relative tolerance.
+    """
+    tolerances = {"tolerance": tolerance, "count_tolerance": count_tolerance}
+    regressions = []
+    for name, current in results["cases"].items():
+        reference = baseline.get("cases", {}).get(name)
+        if reference is None:
+            continue
+        for key, option in COMPARED_METRICS:
+            old, new = reference.get(key), current.get(key)
+            if not old or new is None:
+                continue
+            if new > old * (1.0 + tolerances[option]):
+                regressions.append(f"{name}: {key} {new:g} > baseline {old:g} (+{(new / old - 1.0) * 100.0:.1f}%)")
+    return regressions
+
+
+def print_table(results, baseline=None):
+    header = f"{'case':<32} {'wall s':>9} {'sim/wall':>10} {'ng_sync':>9} {'srcdata':>10} {'redo %':>7} {'RSS MiB':>8}"
+    print(header)
+    print("-" * len(header))
+    for name, m in results["cases"].items():
+        ratio = m["sim_s"] / m["wall_s"] if m["wall_s"] else 0.0
+        line = (
+            f"{name:<32} {m['wall_s']:>9.3f} {ratio:>10.3g} {m['ng_sync']:>9} {m['srcdata']:>10}"
+            f" {m['redo_rate'] * 100.0:>7.2f} {m['peak_rss_bytes'] / 2**20:>8.1f}"
+        )
+        reference = (baseline or {}).get("cases", {}).get(name)
+        if reference and reference.get("wall_s"):
+            line += f"  ({(m['wall_s'] / reference['wall_s'] - 1.0) * 100.0:+.1f}% wall)"
+        print(line)
+
+
+def main(argv=None):
+    """Entry point of ``spicebind bench``."""
+    import argparse
+
+    parser = argparse.ArgumentParser(prog="spicebind bench", description="Run the end-to-end co-simulation benchmarks")
+    parser.add_argument("-k", "--cases", action="append", metavar="PATTERN", help="only run cases matching this glob (repeatable)")
+    parser.add_argument("--list", action="store_true", help="list the cases and exit")
+    parser.add_argument("--quick", action="store_true", help="small synthetic sweep only, without the examples")
+    parser.add_argument("--root", default=".", help="repository checkout with examples/ and tests/ (default: .)")
+    parser.add_argument("--work-dir", default="bench_build", help="build and output directory (default: bench_build)")
+    parser.add_argument("--sim", default=os.getenv("SIM", "icarus"), help="cocotb simulator (default: $SIM or icarus)")
+    parser.add_argument("--vpi", help="VPI module to benchmark, e.g. a profiling build (default: the installed spicebind_vpi)")
+    parser.add_argument("-o", "--output", help="write the results as JSON (default: <work-dir>/results.json)")
+    parser.add_argument("--baseline", help="compare against a results file and fail on regressions")
+    parser.add_argument("--save-baseline", metavar="FILE", help="also write the results to FILE as the new baseline")
+    parser.add_argument("--tolerance", type=float, default=0.25, help="allowed relative increase of wall time and RSS (default: 0.25)")
+    parser.add_argument("--count-tolerance", type=float, default=0.05, help="allowed relative increase of ng_sync, srcdata and redo counts (default: 0.05)")
+    args = parser.parse_args(argv)
+
+    cases = all_cases(Path(args.root).resolve(), quick=args.quick)
+    if args.cases:
+        cases = [case for case in cases if any(fnmatch.fnmatch(case.name, pattern) for pattern in args.cases)]
+    if args.list:
+        for case in cases:
+            print(case.name)
+        return 0
+    if not cases:
+        print("no benchmark cases selected", file=sys.stderr)
+        return 1
+    vpi_module = args.vpi or spicebind.get_vpi_module_path()
+    if vpi_module is None or not Path(vpi_module).exists():
+        print("Error: spicebind library not found", file=sys.stderr)
+        return 1
+    vpi_module = Path(vpi_module).resolve()
+
+    work_dir = Path(args.work_dir)
+    results = {"version": RESULTS_VERSION, "sim": args.sim, "vpi": vpi_module.name, "cases": {}}
+    failed = []
+    for case in cases:
+        print(f"# {case.name}", flush=True)
+        try:
+            results["cases"][case.name] = run_case(case, work_dir, args.sim, vpi_module)
+        except Exception as e:  # keep benchmarking the other cases
+            print(f"# {case.name} failed: {e}", file=sys.stderr)
+            failed.append(case.name)
+
+    output = Path(args.output) if args.output else work_dir / "results.json"
+    output.parent.mkdir(parents=True, exist_ok=True)
+    output.write_text(json.dumps(results, indent=2) + "\n")
+    if args.save_baseline:
+        Path(args.save_baseline).write_text(json.dumps(results, indent=2) + "\n")
+
+    baseline = json.loads(Path(args.baseline).read_text()) if args.baseline else None
+    print()
+    print_table(results, baseline)
+    print(f"\nresults written to {output}")
+
+    regressions = compare(results, baseline, args.tolerance, args.count_tolerance) if baseline else []
+    for message in regressions:
+        print(f"REGRESSION {message}", file=sys.stderr)
+    return 1 if regressions or failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
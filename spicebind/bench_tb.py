@@ -0,0 +1,44 @@
+"""
+cocotb testbench of the synthetic ``spicebind bench`` netlists.
+
+Every input toggles once per BENCH_TOGGLE_NS, staggered evenly over the
+period, until BENCH_DURATION_NS.
+"""
+
+import os
+
+import cocotb
+from cocotb.triggers import Timer
+
+
+@cocotb.test()
+async def toggle_inputs(dut):
+    ports = int(os.environ["BENCH_PORTS"])
+    period_ps = max(1, round(float(os.environ["BENCH_TOGGLE_NS"]) * 1000))
+    duration_ps = round(float(os.environ["BENCH_DURATION_NS"]) * 1000)
+
+    inputs = [getattr(dut, f"a{i}") for i in range(ports)]
+    levels = [0] * ports
+    for signal in inputs:
+        signal.value = 0
+
+    # inputs toggling at the same offset into the period
+    groups = {}
+    for i in range(ports):
+        groups.setdefault(i * period_ps // ports, []).append(i)
+    offsets = sorted(groups)
+
+    now_ps = 0
+    start_ps = period_ps
+    while start_ps < duration_ps:
+        for offset in offsets:
+            if start_ps + offset >= duration_ps:
+                break
+            await Timer(start_ps + offset - now_ps, units="ps")
+            now_ps = start_ps + offset
+            for i in groups[offset]:
+                levels[i] ^= 1
+                inputs[i].value = levels[i]
+        start_ps += period_ps
+
+    await Timer(duration_ps - now_ps, units="ps")
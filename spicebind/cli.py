@@ -35,5 +35,44 @@ def main():
         sys.exit(1)
 
 
+def run_tool(name, args):
+    """Run one of the executables installed next to this file and return its exit code."""
+    import subprocess
+    import sys
+    from pathlib import Path
+
+    tool = Path(__file__).parent / (name + ".exe" if sys.platform == "win32" else name)
+    if not tool.exists():
+        print(f"Error: {name} not found", file=sys.stderr)
+        return 1
+    return subprocess.call([str(tool), *args])
+
+
+def spicebind_main(argv=None):
+    """Entry point of the spicebind command."""
+    import argparse
+    import sys
+
+    parser = argparse.ArgumentParser(prog="spicebind", description="spicebind tools")
+    parser.add_argument(
+        "command",
+        choices=["bench", "characterize", "replay", "vpi-path"],
+        help="bench: run the co-simulation benchmarks; characterize: build a surrogate table of a netlist; "
+        "replay: rerun a netlist with a recorded stimulus; vpi-path: print the VPI module directory",
+    )
+    parser.add_argument("args", nargs=argparse.REMAINDER, help="arguments of the command")
+    args = parser.parse_args(argv)
+
+    if args.command == "bench":
+        from spicebind.bench import main as bench_main
+
+        sys.exit(bench_main(args.args))
+    if args.command == "replay":
+        sys.exit(run_tool("spicebind_replay", args.args))
+    if args.command == "characterize":
+        sys.exit(run_tool("spicebind_characterize", args.args))
+    main()
+
+
 if __name__ == "__main__":
     main()
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+Decoder for the binary event traces written with SPICE_TRACE.
+"""
+
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"SBTRACE1"
+CATEGORIES = {1: "general", 2: "sync", 4: "redo", 8: "srcdata", 16: "port", 32: "barrier", 64: "timeline"}
+ARG_INT, ARG_UNSIGNED, ARG_DOUBLE, ARG_STRING, ARG_TRUNCATED = 1, 2, 3, 4, 5
+MAX_ARGS = 6
+
+# printf conversion with flags, width and precision; length modifiers are dropped
+_CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t|L)?([diouxXeEfgGcsp%])")
+
+
+def _read(f, fmt):
+    size = struct.calcsize(fmt)
+    data = f.read(size)
+    if len(data) != size:
+        raise ValueError("truncated trace file")
+    return struct.unpack(fmt, data)
+
+
+def _read_string(f):
+    (length,) = _read(f, "<I")
+    return f.read(length).decode("utf-8", errors="replace")
+
+
+def _decode_args(types, count, slots):
+    args = []
+    slot = 0
+    for arg_type in types[:count]:
+        if arg_type == ARG_STRING:
+            args.append(slots[slot * 8 : slot * 8 + 16].split(b"\0", 1)[0].decode("utf-8", errors="replace"))
+            slot += 2
+        elif arg_type in (ARG_INT, ARG_UNSIGNED, ARG_DOUBLE):
+            fmt = {ARG_INT: "<q", ARG_UNSIGNED: "<Q", ARG_DOUBLE: "<d"}[arg_type]
+            args.append(struct.unpack_from(fmt, slots, slot * 8)[0])
+            slot += 1
+        else:
+            args.append("?")
+    return args
+
+
+def format_message(fmt, args):
+    """Apply C printf-style args, one per conversion."""
+    args = list(args)
+
+    def convert(match):
+        spec, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        value = args.pop(0) if args else "?"
+        if conversion in "diouxXc" and isinstance(value, float):
+            value = int(value)
+        if conversion in "eEfgG" and isinstance(value, int):
+            value = float(value)
+        if isinstance(value, str) or conversion in "sp":
+            return ("%" + spec + "s") % (value,)
+        if conversion in "diu":
+            conversion = "d"
+        return ("%" + spec + conversion) % (value,)
+
+    return _CONVERSION.sub(convert, fmt)
+
+
+def read_trace(file_name):
+    """Read a trace file.
+
+    Returns a list of (time_ns, thread_name, category, message) sorted by time,
+    and a dict with the number of overwritten events per thread.
+    """
+    records, overwritten = _read_records(file_name)
+    events = [(time_ns, thread, category, format_message(fmt, args)) for time_ns, thread, category, fmt, args in records]
+    return events, overwritten
+
+
+def _read_records(file_name):
+    """Read a trace file as (time_ns, thread_name, category, format, args) sorted by time."""
+    events = []
+    overwritten = {}
+    with open(file_name, "rb") as f:
+        if f.read(len(MAGIC)) != MAGIC:
+            raise ValueError(f"{file_name} is not a spicebind trace")
+        (event_size,) = _read(f, "<I")
+        (format_count,) = _read(f, "<I")
+        formats = {}
+        for _ in range(format_count):
+            (address,) = _read(f, "<Q")
+            formats[address] = _read_string(f)
+
+        (thread_count,) = _read(f, "<I")
+        for _ in range(thread_count):
+            thread = _read_string(f)
+            count, lost = _read(f, "<QQ")
+            overwritten[thread] = lost
+            for _ in range(count):
+                data = f.read(event_size)
+                if len(data) != event_size:
+                    raise ValueError("truncated trace file")
+                time_ns, address, category, arg_count = struct.unpack_from("<QQBB", data)
+                types = data[18 : 18 + MAX_ARGS]
+                slots = data[24:event_size]
+                args = _decode_args(types, arg_count, slots)
+                events.append((time_ns, thread, CATEGORIES.get(category, str(category)), formats.get(address, "?"), args))
+
+    events.sort(key=lambda event: event[0])
+    return events, overwritten
+
+
+# Barrier trace points (TimeBarrier.h)
+_PRECISION = "time precision=%llu"
+_UPDATE = "update engine=%d time=%llu"
+_WAIT = "wait engine=%d time=%llu"
+_RESUME = "resume engine=%d time=%llu"
+# instants of the timeline category by their first argument (Tracer::TimelineEvent)
+_TIMELINE = {1: "redo request", 2: "redo", 3: "cancel redo", 4: "breakpoint", 5: "input", 6: "output"}
+_WALL_PID, _SIM_PID = 1, 2
+
+
+def chrome_trace(file_name):
+    """Convert a trace file to Chrome trace-event JSON (chrome://tracing, Perfetto).
+
+    Needs the barrier category. Each thread gets a wall-clock track with its run and
+    wait intervals and a simulation-time track with the time its engine advanced;
+    redo requests, redos, breakpoints and port updates (timeline category) are
+    instants on both.
+    """
+    records, _ = _read_records(file_name)
+
+    # one HDL tick is shown as one nanosecond, the timeline cannot resolve picoseconds
+    precision = next((args[0] for _, _, _, fmt, args in records if fmt == _PRECISION and args), None)
+    sim_us = 1e-3
+    sim_name = "simulation time (1 ns = 1 tick" + (f" of {1.0 / precision:g} s)" if precision else ")")
+
+    trace = [
+        {"ph": "M", "pid": _WALL_PID, "name": "process_name", "args": {"name": "wall clock"}},
+        {"ph": "M", "pid": _SIM_PID, "name": "process_name", "args": {"name": sim_name}},
+    ]
+    threads = {}
+    for time_ns, thread, category, fmt, args in records:
+        if thread not in threads:
+            tid = len(threads) + 1
+            threads[thread] = {"tid": tid, "run": time_ns, "wait": None, "sim": None}
+            for pid in (_WALL_PID, _SIM_PID):
+                trace.append({"ph": "M", "pid": pid, "tid": tid, "name": "thread_name", "args": {"name": thread}})
+        state = threads[thread]
+        tid = state["tid"]
+        ts = time_ns / 1000.0
+
+        if fmt == _UPDATE:
+            engine, sim_time = args
+            if state["sim"] is not None and sim_time > state["sim"]:
+                trace.append({"ph": "X", "pid": _SIM_PID, "tid": tid, "name": "advance", "cat": "barrier",
+                              "ts": state["sim"] * sim_us, "dur": (sim_time - state["sim"]) * sim_us,
+                              "args": {"engine": engine, "wall_us": ts}})
+            state["sim"] = sim_time
+        elif fmt == _WAIT:
+            trace.append({"ph": "X", "pid": _WALL_PID, "tid": tid, "name": "run", "cat": "barrier",
+                          "ts": state["run"] / 1000.0, "dur": (time_ns - state["run"]) / 1000.0})
+            state["wait"] = time_ns
+        elif fmt == _RESUME and state["wait"] is not None:
+            engine, sim_time = args
+            blocked_us = (time_ns - state["wait"]) / 1000.0
+            trace.append({"ph": "X", "pid": _WALL_PID, "tid": tid, "name": "wait", "cat": "barrier",
+                          "ts": state["wait"] / 1000.0, "dur": blocked_us, "args": {"engine": engine, "sim_time": sim_time}})
+            trace.append({"ph": "i", "s": "t", "pid": _SIM_PID, "tid": tid, "name": "wait", "cat": "barrier",
+                          "ts": sim_time * sim_us, "args": {"engine": engine, "blocked_us": blocked_us}})
+            state["wait"] = None
+            state["run"] = time_ns
+        elif category == "timeline" and args:
+            name = _TIMELINE.get(args[0], "event")
+            message = format_message(fmt, args)
+            trace.append({"ph": "i", "s": "t", "pid": _WALL_PID, "tid": tid, "name": name, "cat": category,
+                          "ts": ts, "args": {"message": message}})
+            if state["sim"] is not None:
+                trace.append({"ph": "i", "s": "t", "pid": _SIM_PID, "tid": tid, "name": name, "cat": category,
+                              "ts": state["sim"] * sim_us, "args": {"message": message}})
+
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+
+def main(argv=None):
+    """Entry point of the spicebind-trace command: print a trace file as text."""
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Decode a spicebind event trace (SPICE_TRACE)")
+    parser.add_argument("trace", nargs="?", default="spicebind.trace", help="trace file (default: spicebind.trace)")
+    parser.add_argument("-c", "--category", action="append", help="only print this category (repeatable)")
+    parser.add_argument("--chrome", metavar="FILE", help="write a Chrome trace-event JSON timeline for Perfetto instead")
+    args = parser.parse_args(argv)
+
+    if args.chrome:
+        with open(args.chrome, "w") as f:
+            json.dump(chrome_trace(args.trace), f)
+        return 0
+
+    events, overwritten = read_trace(args.trace)
+    for thread, lost in overwritten.items():
+        if lost:
+            print(f"# {thread}: {lost} older events overwritten", file=sys.stderr)
+    for time_ns, thread, category, message in events:
+        if args.category and category not in args.category:
+            continue
+        print(f"{time_ns / 1000.0:14.3f} us  {thread:<10} {category:<8} {message}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,27 @@
+`timescale 1ns/1ps
+
+module debug(
+    input wire A0, A1, A2,
+    output wire Y0, Y1, Y2
+);
+
+endmodule
+
+module tb(
+    input wire A0, A1, A2,
+    output wire Y0, Y1, Y2
+);
+
+   debug debug (.A0(A0), .A1(A1), .A2(A2), .Y0(Y0), .Y1(Y1), .Y2(Y2));
+
+   integer test_id;
+
+    // checkpoint while the inverters driven by A2 (rising at 2.1 ns) switch;
+    // the child ends right there, the original process goes on
+    initial begin
+        #2.15 test_id = $spicebind_checkpoint(1);
+        if (test_id != 0)
+            $finish;
+    end
+
+endmodule
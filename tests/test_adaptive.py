@@ -0,0 +1,66 @@
+from cocotb.runner import get_runner
+import json
+import os
+from pathlib import Path
+import spicebind
+
+
+def test_adaptive():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    stats_file = Path("sim_build/stats.json")
+
+    def run(loose_reltol, loose_abstol):
+        if stats_file.exists():
+            stats_file.unlink()
+
+        # a short hold, so the gaps between the input changes of the test count as idle
+        runner.test(
+            hdl_toplevel="tb",
+            test_module="test_debug,",
+            test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+            extra_env={
+                "SPICE_NETLIST": str(proj_path / "debug.cir"),
+                "HDL_INSTANCE": "tb.debug",
+                "VCC": "1.8",
+                "SPICE_STATS_JSON": "stats.json",
+                "SPICE_ADAPTIVE": "on",
+                "SPICE_ADAPTIVE_RELTOL": "1e-4",
+                "SPICE_ADAPTIVE_ABSTOL": "1e-13",
+                "SPICE_ADAPTIVE_LOOSE_RELTOL": loose_reltol,
+                "SPICE_ADAPTIVE_LOOSE_ABSTOL": loose_abstol,
+                "SPICE_ADAPTIVE_HOLD": "0.5e-9",
+                "SPICE_ADAPTIVE_MAX_STEP": "0.05e-9",
+            },
+        )
+        (partition,) = json.loads(stats_file.read_text())["partitions"]
+        return partition
+
+    # the same switches, pauses and step limits with the loose tolerances equal to
+    # the tight ones, so only the tolerance values differ between the two runs
+    same = run("1e-4", "1e-13")
+    loose = run("1e-2", "1e-9")
+
+    # idle periods loosen the tolerances, the following input changes tighten them again
+    tolerances = loose["tolerances"]
+    assert tolerances["loosened"] > 0
+    assert tolerances["tightened"] > 0
+    assert tolerances["tightened"] >= tolerances["loosened"] - 1
+    assert same["tolerances"]["loosened"] > 0
+
+    # ngspice picks the loose values up when it resumes after the pause: fewer accepted steps
+    assert loose["ng_sync"]["end_of_step"] < same["ng_sync"]["end_of_step"]
+
+
+if __name__ == "__main__":
+    test_adaptive()
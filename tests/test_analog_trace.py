@@ -0,0 +1,90 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+
+
+def read_vcd(file_name):
+    """Real signals of a VCD file as {"scope.name": [(time, value), ...]}"""
+    names = {}
+    changes = {}
+    scope = []
+    time = 0
+    with open(file_name) as f:
+        for line in f:
+            tokens = line.split()
+            if not tokens:
+                continue
+            if tokens[0] == "$scope":
+                scope.append(tokens[2])
+            elif tokens[0] == "$upscope":
+                scope.pop()
+            elif tokens[0] == "$var":
+                names[tokens[3]] = ".".join(scope + [tokens[4]])
+                changes[names[tokens[3]]] = []
+            elif tokens[0].startswith("#"):
+                time = int(tokens[0][1:])
+            elif tokens[0].startswith("r"):
+                changes[names[tokens[1]]].append((time, float(tokens[0][1:])))
+    return changes
+
+
+def value_at(changes, time):
+    value = None
+    for t, v in changes:
+        if t > time:
+            break
+        value = v
+    return value
+
+
+def test_analog_trace():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    trace = Path("sim_build/analog.vcd")
+    if trace.exists():
+        trace.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_FST": "analog.vcd",
+            "SPICE_FST_NODES": "v(a2_inv0)",
+            "SPICE_FST_TOLERANCE": "0.01",
+        },
+    )
+
+    signals = read_vcd(str(trace))
+
+    # bound ports under the HDL instance, extra nodes under "spice"; times in ps
+    for port in ["a0", "a1", "a2", "y0", "y1", "y2"]:
+        assert "tb.debug." + port in signals
+    assert "spice.v(a2_inv0)" in signals
+
+    a0 = signals["tb.debug.a0"]
+    assert abs(value_at(a0, 2100) - 0.0) < 0.01
+    assert abs(value_at(a0, 2400) - 1.8) < 0.01
+    assert abs(value_at(a0, 4400) - 1.8) < 0.01
+    assert abs(value_at(a0, 4700) - 0.0) < 0.01
+
+    # the tolerance keeps flat regions out of the file
+    assert len(a0) < 20
+
+
+if __name__ == "__main__":
+    test_analog_trace()
@@ -0,0 +1,53 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+from rawread import rawread
+from test_debug import check_transition
+
+
+def test_checkpoint():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "checkpoint.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    # the output checks of test_debug hold in the original process across the checkpoint;
+    # the child stops early and writes its results first, the original overwrites them
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+        },
+    )
+
+    # the child ends at the checkpoint, its ngspice never ran past it
+    arrs, plots = rawread("sim_build/dump_1.raw")
+    time = arrs[0]["time"]
+    assert abs(time[-1] - 2.15e-9) < 5e-12, f"child waveform ends at {time[-1]}"
+    check_transition(time, arrs[0]["v(a2)"], 2.1e-09, 0.0, 1.8)
+
+    # and the original process matches a run without checkpoint
+    arrs, plots = rawread("sim_build/dump.raw")
+    time = arrs[0]["time"]
+    check_transition(time, arrs[0]["v(a0)"], 2.2e-09, 0.0, 1.8)
+    check_transition(time, arrs[0]["v(a0)"], 4.5e-09, 1.8, 0.0)
+    check_transition(time, arrs[0]["v(a2)"], 2.1e-09, 0.0, 1.8)
+    check_transition(time, arrs[0]["v(a2)"], 4.4e-09, 1.8, 0.0)
+    check_transition(time, arrs[0]["v(a1)"], 2.3e-09, 0.0, 1.8)
+    check_transition(time, arrs[0]["v(a1)"], 5.6e-09, 1.8, 0.0)
+
+
+if __name__ == "__main__":
+    test_checkpoint()
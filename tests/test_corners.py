@@ -0,0 +1,55 @@
+from cocotb.runner import get_runner
+import os
+import re
+from pathlib import Path
+import spicebind
+
+
+def test_corners():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "multi_instance.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    corner_dump = Path("sim_build/dump_multi_instance_slow.raw")
+    if corner_dump.exists():
+        corner_dump.unlink()
+    log = Path("sim_build/spicebind.log")
+    if log.exists():
+        log.unlink()
+
+    # a corner identical to the nominal netlist must not diverge
+    nominal_corner = Path("sim_build/multi_instance_nominal.cir")
+    nominal_corner.write_text((proj_path / "multi_instance.cir").read_text())
+
+    # the nominal netlist drives the HDL, the corners run alongside it
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_multi_instance,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "multi_instance.cir"),
+            "SPICE_CORNERS": f"{proj_path / 'multi_instance_slow.cir'},{nominal_corner.resolve()}",
+            "HDL_INSTANCE": "tb.inv0,tb.inv1",
+            "VCC": "1.8",
+            "SPICE_LOG_FILE": "spicebind.log",
+        },
+    )
+
+    assert corner_dump.exists()
+    text = log.read_text()
+    # the 20 ns slew of the slow corner delays the inverter outputs past the comparison
+    assert re.search(r"Corner multi_instance_slow: output \S+ diverged \d+ time\(s\)", text)
+    assert "Corner multi_instance_slow: outputs match" not in text
+    assert "Corner multi_instance_nominal: outputs match the driving netlist" in text
+    assert "Corner multi_instance_nominal: output " not in text
+
+if __name__ == "__main__":
+    test_corners()
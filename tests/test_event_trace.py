@@ -0,0 +1,89 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+from spicebind.trace import chrome_trace, read_trace
+
+
+def test_event_trace():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    trace = Path("sim_build/spicebind.trace")
+    if trace.exists():
+        trace.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_TRACE": "sync,port",
+        },
+    )
+
+    events, overwritten = read_trace(str(trace))
+
+    # only the enabled categories are recorded, from the HDL and the ngspice thread
+    categories = {category for _, _, category, _ in events}
+    assert categories == {"sync", "port"}
+    threads = {thread for _, thread, _, _ in events}
+    assert "hdl" in threads
+    assert len(threads) > 1
+    assert any(message.startswith("enter A0 ") for _, _, category, message in events if category == "port")
+
+
+def test_chrome_trace():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_TRACE": "barrier,timeline",
+            "SPICE_TRACE_FILE": "timeline.trace",
+        },
+    )
+
+    events = chrome_trace("sim_build/timeline.trace")["traceEvents"]
+
+    # both sides wait for each other, the input changes request redos and
+    # ngspice pauses at a breakpoint at the HDL end time
+    waits = {event["tid"] for event in events if event["name"] == "wait" and event["ph"] == "X"}
+    assert len(waits) > 1
+    assert any(event["name"] == "advance" for event in events)
+    instants = {event["name"] for event in events if event["ph"] == "i" and event["cat"] == "timeline"}
+    assert {"input", "redo request", "breakpoint", "output"} <= instants
+    assert instants & {"redo", "cancel redo"}
+    assert all(event["dur"] >= 0 for event in events if event["ph"] == "X")
+
+
+if __name__ == "__main__":
+    test_event_trace()
+    test_chrome_trace()
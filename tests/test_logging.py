@@ -0,0 +1,49 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import pytest
+import spicebind
+
+
+@pytest.mark.parametrize("level", ["all", "error"])
+def test_logging(level):
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    log = Path("sim_build/spicebind.log")
+    if log.exists():
+        log.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_LOG_LEVEL": level,
+            "SPICE_LOG_FILE": "spicebind.log",
+        },
+    )
+
+    # ngspice output goes to the log file, and only with the "all" level
+    text = log.read_text()
+    if level == "all":
+        assert "NGSPICE: Circuit: debug test" in text
+    else:
+        assert "NGSPICE:" not in text
+        assert "** Info:" not in text
+
+
+if __name__ == "__main__":
+    test_logging("all")
@@ -0,0 +1,95 @@
+import cocotb
+from cocotb.triggers import Edge, Timer
+from cocotb.runner import get_runner
+from cocotb.utils import get_sim_time
+import os
+from pathlib import Path
+import spicebind
+
+
+@cocotb.test()
+async def run_no_redo_inputs(dut):
+    dut.A0.value = 0
+    dut.A1.value = 0
+
+    await Timer(5, units="ns")
+    assert dut.Y0.value == 1
+    assert dut.Y1.value == 1
+
+    # input without redo: applied at the next SPICE step, then the gate delay
+    dut.A0.value = 1
+    await Timer(10, units="ns")
+    assert dut.Y0.value == 0
+    assert dut.Y1.value == 1
+
+    # analog input next to it still follows its slew
+    dut.A1.value = 1
+    await Timer(20, units="ns")
+    assert dut.Y0.value == 0
+    assert dut.Y1.value == 0
+
+    dut.A0.value = 0
+    await Timer(10, units="ns")
+    assert dut.Y0.value == 1
+
+
+@cocotb.test()
+async def run_edge_latency(dut):
+    dut.A0.value = 0
+    dut.A1.value = 0
+    await Timer(5.3, units="ns")
+
+    # from the input edge to the output of the 1 ns inverter
+    start = get_sim_time(units="ps")
+    dut.A0.value = 1
+    await Edge(dut.Y0)
+    Path("latency.txt").write_text(str(get_sim_time(units="ps") - start))
+
+
+def test_no_redo_inputs():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "multi_instance.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    env = {
+        "SPICE_NETLIST": str(proj_path / "no_redo_inputs.cir"),
+        "HDL_INSTANCE": "tb.inv0,tb.inv1",
+        "VCC": "1.8",
+    }
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_no_redo_inputs,",
+        testcase="run_no_redo_inputs",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={**env, "SPICE_NO_REDO_INPUTS": "tb.inv0.a"},
+    )
+
+    def latency(extra_env):
+        runner.test(
+            hdl_toplevel="tb",
+            test_module="test_no_redo_inputs,",
+            testcase="run_edge_latency",
+            test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+            extra_env={**env, **extra_env},
+        )
+        return int(Path("sim_build/latency.txt").read_text())
+
+    # with a redo the edge reaches the bridge at its own time; without one it
+    # waits for the next SPICE step, at most the 1 ns step of the netlist's .tran
+    with_redo = latency({})
+    without_redo = latency({"SPICE_NO_REDO_INPUTS": "tb.inv0.a"})
+    assert with_redo >= 1000
+    assert with_redo <= without_redo <= with_redo + 1000
+
+
+if __name__ == "__main__":
+    test_no_redo_inputs()
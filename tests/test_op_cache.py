@@ -0,0 +1,63 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+
+
+def test_op_cache():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    cache_dir = Path("sim_build/op_cache").resolve()
+    cache_dir.mkdir(parents=True, exist_ok=True)
+    for old in cache_dir.glob("*.op"):
+        old.unlink()
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    def run():
+        runner.test(
+            hdl_toplevel="tb",
+            test_module="test_debug,",
+            test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+            extra_env={
+                "SPICE_NETLIST": str(proj_path / "debug.cir"),
+                "HDL_INSTANCE": "tb.debug",
+                "VCC": "1.8",
+                "SPICE_OP_CACHE": str(cache_dir),
+                "SPICE_LOG_FILE": "spicebind.log",
+            },
+        )
+
+    log = Path("sim_build/spicebind.log")
+
+    # first run saves the operating point
+    run()
+    cache_files = list(cache_dir.glob("*.op"))
+    assert len(cache_files) == 1
+    content = cache_files[0].read_text()
+    assert ".ic" not in content
+    assert "v(vdd)=" in content
+    assert "Operating point cache miss" in log.read_text()
+    mtime = cache_files[0].stat().st_mtime_ns
+
+    # second run starts from the cached operating point and leaves it as it was
+    log.unlink()
+    run()
+    assert list(cache_dir.glob("*.op")) == cache_files
+    text = log.read_text()
+    assert f"Operating point cache hit: {cache_files[0]}" in text
+    assert "Saved operating point cache" not in text
+    assert cache_files[0].stat().st_mtime_ns == mtime
+    assert cache_files[0].read_text() == content
+
+
+if __name__ == "__main__":
+    test_op_cache()
@@ -0,0 +1,80 @@
+import cocotb
+from cocotb.triggers import Timer
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+
+
+@cocotb.test()
+async def run_other_stimulus(dut):
+    # drives A0 at a time the recorded run of test_debug did not
+    dut.A2.value = 0
+    dut.A1.value = 0
+    dut.A0.value = 0
+    await Timer(0.5, units="ns")
+    dut.A0.value = 1
+    await Timer(1, units="ns")
+
+
+def test_output_stub():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    env = {
+        "SPICE_NETLIST": str(proj_path / "debug.cir"),
+        "HDL_INSTANCE": "tb.debug",
+        "VCC": "1.8",
+        "SPICE_LOG_FILE": "spicebind.log",
+    }
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={**env, "SPICE_RECORD_OUTPUTS": "outputs.sbout"},
+    )
+    assert Path("sim_build/outputs.sbout").exists()
+
+    # the same test passes on the recorded outputs, without ngspice
+    dump = Path("sim_build/dump.raw")
+    dump.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={**env, "SPICE_STUB_OUTPUTS": "outputs.sbout"},
+    )
+
+    text = Path("sim_build/spicebind.log").read_text()
+    assert "Stub inputs match" in text
+    assert "NGSPICE:" not in text
+    assert not dump.exists()
+
+    # a different stimulus is reported against the recording
+    Path("sim_build/spicebind.log").unlink()
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_output_stub,",
+        testcase="run_other_stimulus",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={**env, "SPICE_STUB_OUTPUTS": "outputs.sbout"},
+    )
+
+    text = Path("sim_build/spicebind.log").read_text()
+    assert "Stub inputs diverged from outputs.sbout" in text
+    assert "Stub inputs match" not in text
+
+
+if __name__ == "__main__":
+    test_output_stub()
@@ -0,0 +1,58 @@
+import cocotb
+from cocotb.triggers import Timer
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import spicebind
+
+
+@cocotb.test()
+async def run_partitions(dut):
+    # inv0 inverts and inv1 buffers; an engine running the other netlist gets both wrong
+    dut.A0.value = 0
+    dut.A1.value = 0
+
+    await Timer(5, units="ns")
+    assert dut.Y0.value == 1
+    assert dut.Y1.value == 0
+
+    dut.A0.value = 1
+    dut.A1.value = 1
+    await Timer(20, units="ns")
+    assert dut.Y0.value == 0
+    assert dut.Y1.value == 1
+
+    dut.A1.value = 0
+    await Timer(20, units="ns")
+    assert dut.Y0.value == 0
+    assert dut.Y1.value == 0
+
+
+def test_partitions():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "multi_instance.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    # one ngspice engine per instance, both netlists use the same element, node and model names
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_partitions,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": f"{proj_path / 'partition_inv0.cir'},{proj_path / 'partition_buf1.cir'}",
+            "HDL_INSTANCE": "tb.inv0,tb.inv1",
+            "VCC": "1.8",
+        },
+    )
+
+
+if __name__ == "__main__":
+    test_partitions()
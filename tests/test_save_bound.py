@@ -0,0 +1,67 @@
+from cocotb.runner import get_runner
+import json
+import os
+from pathlib import Path
+import numpy as np
+import spicebind
+from rawread import rawread
+from test_debug import check_transition
+
+
+def test_save_bound():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    def run(netlist, **env):
+        stats_file = Path("sim_build/stats.json")
+        if stats_file.exists():
+            stats_file.unlink()
+        runner.test(
+            hdl_toplevel="tb",
+            test_module="test_debug,",
+            test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+            extra_env={
+                "SPICE_NETLIST": str(netlist),
+                "HDL_INSTANCE": "tb.debug",
+                "VCC": "1.8",
+                "SPICE_SAVE": "bound",
+                "SPICE_SAVE_NODES": "v(a0)",
+                "SPICE_STATS_JSON": "stats.json",
+                **env,
+            },
+        )
+        arrs, plots = rawread("sim_build/dump.raw")
+        (partition,) = json.loads(stats_file.read_text())["partitions"]
+        return arrs[0], partition["history"]
+
+    # only the scale, the bound outputs and the requested node are kept
+    arr, history = run(proj_path / "debug.cir")
+
+    assert set(arr.dtype.names) == {"time", "v(y0)", "v(y1)", "v(y2)", "v(a0)"}
+    assert history["vectors"] == len(arr.dtype.names)
+    assert history["points"] == len(arr)
+    assert history["bytes"] == history["points"] * history["vectors"] * 8
+    check_transition(arr["time"], arr["v(a0)"], 2.2e-09, 0.0, 1.8)
+    check_transition(arr["time"], arr["v(a0)"], 4.5e-09, 1.8, 0.0)
+
+    # on the grid, ngspice keeps one point per .tran step
+    grid_netlist = Path("sim_build/debug_grid.cir")
+    grid_netlist.write_text((proj_path / "debug.cir").read_text().replace(".tran 1ns 1", ".tran 10ps 1"))
+    arr, history = run(grid_netlist.resolve(), SPICE_SAVE_GRID="on")
+
+    assert set(arr.dtype.names) == {"time", "v(y0)", "v(y1)", "v(y2)", "v(a0)"}
+    assert history["points"] == len(arr)
+    assert np.allclose(np.diff(arr["time"]), 10e-12, rtol=1e-6, atol=1e-18)
+
+
+if __name__ == "__main__":
+    test_save_bound()
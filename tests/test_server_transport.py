@@ -0,0 +1,57 @@
+from cocotb.runner import get_runner
+import json
+import os
+from pathlib import Path
+import pytest
+import spicebind
+from rawread import rawread
+from test_debug import check_transition
+
+
+@pytest.mark.parametrize("transport", ["inprocess", "server"])
+def test_server_transport(transport):
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    stats_file = Path("sim_build/stats.json")
+    if stats_file.exists():
+        stats_file.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_TRANSPORT": transport,
+            "SPICE_STATS_JSON": "stats.json",
+        },
+    )
+
+    # both transports must produce the same waveforms
+    arrs, plots = rawread("sim_build/dump.raw")
+
+    check_transition(arrs[0]["time"], arrs[0]["v(a0)"], 2.2e-09, 0.0, 1.8)
+    check_transition(arrs[0]["time"], arrs[0]["v(a0)"], 4.5e-09, 1.8, 0.0)
+    check_transition(arrs[0]["time"], arrs[0]["v(a1)"], 2.3e-09, 0.0, 1.8)
+    check_transition(arrs[0]["time"], arrs[0]["v(a1)"], 5.6e-09, 1.8, 0.0)
+
+    # the retained history is reported for both transports
+    (partition,) = json.loads(stats_file.read_text())["partitions"]
+    assert partition["history"]["points"] == len(arrs[0])
+    assert partition["history"]["vectors"] == len(arrs[0].dtype.names)
+
+
+if __name__ == "__main__":
+    test_server_transport("server")
@@ -0,0 +1,55 @@
+from cocotb.runner import get_runner
+import json
+import os
+from pathlib import Path
+import spicebind
+
+
+def test_solver_tuning():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    stats_file = Path("sim_build/stats.json")
+    if stats_file.exists():
+        stats_file.unlink()
+
+    # the tuning runs happen before the co-simulation and must not disturb it
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_LOG_FILE": "spicebind.log",
+            "SPICE_STATS_JSON": "stats.json",
+            "SPICE_SOLVER": "auto",
+            "SPICE_THREADS": "1",
+            "SPICE_TUNE_STEPS": "20",
+        },
+    )
+
+    stats = json.loads(stats_file.read_text())
+    (partition,) = stats["partitions"]
+    solver = partition["solver"]
+    assert [trial["name"] for trial in solver["trials"]] == ["klu", "sparse"]
+    assert all(trial["steps"] == 20 and trial["step_wall_s"] > 0 for trial in solver["trials"])
+
+    fastest = min(solver["trials"], key=lambda trial: trial["step_wall_s"])
+    assert solver["name"] == fastest["name"]
+    assert solver["threads"] == 1
+    assert "Solver for" in Path("sim_build/spicebind.log").read_text()
+
+
+if __name__ == "__main__":
+    test_solver_tuning()
@@ -0,0 +1,65 @@
+from cocotb.runner import get_runner
+import json
+import os
+from pathlib import Path
+import spicebind
+
+
+def test_stats():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    stats_file = Path("sim_build/stats.json")
+    if stats_file.exists():
+        stats_file.unlink()
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_STATS_JSON": "stats.json",
+        },
+    )
+
+    stats = json.loads(stats_file.read_text())
+
+    assert stats["sim_time_s"] > 0
+    assert stats["wall_time_s"] > 0
+    assert stats["peak_rss_bytes"] > 0
+    assert stats["hdl"]["timestep_callbacks"] > 0
+
+    (partition,) = stats["partitions"]
+    assert partition["name"] == "tb.debug"
+    assert partition["ng_sync"]["end_of_step"] > 0
+    assert set(partition["srcdata"]["sources"]) == {"a0", "a1", "a2"}
+    assert partition["srcdata"]["total"] == sum(partition["srcdata"]["sources"].values())
+
+    # the input changes of the test roll ngspice back
+    assert partition["input_events"] > 0
+    assert partition["redos"]["requested"] > 0
+    assert partition["redos"]["performed"] > 0
+
+    # the rolled back work is charged to the inputs that changed
+    costs = partition["redo_cost"]
+    assert costs and all(cost["port"].startswith("tb.debug.") for cost in costs)
+    assert sum(cost["redos"] for cost in costs) >= partition["redos"]["performed"]
+    assert all(cost["discarded_s"] > 0 for cost in costs)
+    assert partition["output_events"] > 0
+    assert partition["history"]["points"] > 0
+
+
+if __name__ == "__main__":
+    test_stats()
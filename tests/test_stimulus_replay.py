@@ -0,0 +1,57 @@
+from cocotb.runner import get_runner
+import os
+import subprocess
+from pathlib import Path
+import numpy as np
+import spicebind
+from rawread import rawread
+from test_debug import check_transition
+
+
+def test_stimulus_replay():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_RECORD_STIMULUS": "stimulus.sbstim",
+        },
+    )
+
+    # rerun the netlist in ngspice alone with the recorded inputs
+    replay = Path(spicebind.get_lib_dir()) / "spicebind_replay"
+    subprocess.run(
+        [str(replay), "-o", "replay.raw", str(proj_path / "debug.cir"), "stimulus.sbstim"],
+        cwd="sim_build",
+        check=True,
+    )
+
+    cosim, _ = rawread("sim_build/dump.raw")
+    replayed, _ = rawread("sim_build/replay.raw")
+
+    check_transition(replayed[0]["time"], replayed[0]["v(a0)"], 2.2e-09, 0.0, 1.8)
+    check_transition(replayed[0]["time"], replayed[0]["v(a0)"], 4.5e-09, 1.8, 0.0)
+
+    # the replayed outputs follow the co-simulation
+    for node in ("v(y0)", "v(y1)", "v(y2)"):
+        expected = np.interp(replayed[0]["time"], cosim[0]["time"], cosim[0][node])
+        assert np.mean(np.abs(replayed[0][node] - expected)) < 0.02 * 1.8, node
+
+
+if __name__ == "__main__":
+    test_stimulus_replay()
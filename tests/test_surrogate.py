@@ -0,0 +1,66 @@
+from cocotb.runner import get_runner
+import os
+import subprocess
+from pathlib import Path
+import spicebind
+
+
+def test_surrogate():
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    # characterise the block once; fast input edges so the delays are the block's own
+    table = Path("sim_build/debug.sbsurr").resolve()
+    characterize = Path(spicebind.get_lib_dir()) / "spicebind_characterize"
+    subprocess.run(
+        [
+            str(characterize),
+            "-o",
+            str(table),
+            "--vcc",
+            "1.8",
+            "--digital",
+            "a0,a1,a2",
+            "--dwell",
+            "5e-9",
+            "--rise",
+            "1e-12",
+            str(proj_path / "debug.cir"),
+            "y0",
+            "y1",
+            "y2",
+        ],
+        check=True,
+    )
+    assert table.exists()
+
+    # the debug test passes on the table, without ngspice
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_LOG_FILE": "spicebind.log",
+            "SPICE_SURROGATE": str(table),
+        },
+    )
+
+    text = Path("sim_build/spicebind.log").read_text()
+    assert "Surrogate" in text
+    assert "NGSPICE:" not in text
+
+
+if __name__ == "__main__":
+    test_surrogate()
@@ -0,0 +1,54 @@
+from cocotb.runner import get_runner
+import os
+from pathlib import Path
+import pytest
+import spicebind
+from rawread import rawread
+from test_debug import check_transition
+
+
+@pytest.mark.parametrize("transport", ["inprocess", "server"])
+def test_waveform_stream(transport):
+    proj_path = Path(__file__).resolve().parent
+    sources = [proj_path / "debug.v"]
+
+    sim = os.getenv("SIM", "icarus")
+
+    runner = get_runner(sim)
+    runner.build(
+        sources=sources,
+        hdl_toplevel="tb",
+        always=True,
+    )
+
+    dump = Path("sim_build/dump.raw")
+    if dump.exists():
+        dump.unlink()
+
+    # small chunks so the writer thread sees several of them
+    runner.test(
+        hdl_toplevel="tb",
+        test_module="test_debug,",
+        test_args=["-M", spicebind.get_lib_dir(), "-m", "spicebind_vpi"],
+        extra_env={
+            "SPICE_NETLIST": str(proj_path / "debug.cir"),
+            "HDL_INSTANCE": "tb.debug",
+            "VCC": "1.8",
+            "SPICE_TRANSPORT": transport,
+            "SPICE_DUMP": "stream",
+            "SPICE_DUMP_VECTORS": "v(a0),a1",
+            "SPICE_DUMP_CHUNK": "16",
+        },
+    )
+
+    arrs, plots = rawread(str(dump))
+
+    assert arrs[0].dtype.names == ("time", "v(a0)", "v(a1)")
+    check_transition(arrs[0]["time"], arrs[0]["v(a0)"], 2.2e-09, 0.0, 1.8)
+    check_transition(arrs[0]["time"], arrs[0]["v(a0)"], 4.5e-09, 1.8, 0.0)
+    check_transition(arrs[0]["time"], arrs[0]["v(a1)"], 2.3e-09, 0.0, 1.8)
+    check_transition(arrs[0]["time"], arrs[0]["v(a1)"], 5.6e-09, 1.8, 0.0)
+
+
+if __name__ == "__main__":
+    test_waveform_stream("inprocess")